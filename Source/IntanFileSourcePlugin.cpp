@@ -22,9 +22,42 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include "IntanFileSourcePlugin.h"
+#include "rhx/abstractrhxcontroller.h"
 #include <exception>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+// Spike events are reported on the event lines following those reserved for the digital inputs, in a
+// bounded encoding. The lines from SpikeStrobeLine up to NumEventLines are split into slots of a strobe
+// line and the lines coding an amplifier channel index in binary (bit b on the slot's strobe line + 1 + b).
+// A spike is a one-sample pulse on a slot's strobe line, with its channel index on the slot's code lines
+// for the same sample. A 1024 channel recording has 4 slots of 11 lines.
+const int SpikeStrobeLine = 16;
+const int NumEventLines = 64;
+
+// Spikes waiting for a slot, at most; more are dropped (and reported once).
+const size_t MaxPendingSpikes = 1 << 20;
+
+// Largest block the resampler filters in one pass; its buffers are sized for this when a file is opened.
+const int ResampleBlockSize = 16384;
+
+// In live-follow mode, the length reported for each record (the recording has no end yet), and the
+// longest a read waits for RHX to write the samples asked for.
+const double FollowRecordLength = 24.0 * 3600.0;    // seconds
+const int FollowReadTimeout = 1000;                 // ms
 
 IntanFileSourcePlugin::IntanFileSourcePlugin()
+: m_masking(false)
+, m_applyNotchFilter(false)
+, m_spikeCodeBits(1)
+, m_spikeSlots(1)
+, m_nextSpikeTimestamp(0)
+, m_spikesDropped(false)
+, m_lfpEnabled(false)
+, m_lfpActive(false)
+, m_resample(false)
+, m_outputPosition(0)
 {
 
 }
@@ -36,41 +69,714 @@ IntanFileSourcePlugin::~IntanFileSourcePlugin()
 
 bool IntanFileSourcePlugin::open(File file)
 {
-	bool b;
 	try
 	{
-		b = readIntanHeader(m_intanHeaderInfo)
+		m_reader.open(file.getFullPathName().toStdString());
+		m_options = IntanProcessingOptions();
+		readProcessingOptions(file.getParentDirectory().getChildFile(ProcessingOptionsFileName).getFullPathName().toStdString(), m_options);
 	}
 	catch (std::exception &e)
+	{
+		std::cerr << "IntanFileSourcePlugin: " << e.what() << std::endl;
+		return false;
+	}
+
+	// Masked channels are left out of everything below: the processing works on the channels left.
+	ChannelMaskOptions maskOptions;
+	maskOptions.minImpedance = 1000.0 * m_options.maskImpedanceMin;
+	maskOptions.maxImpedance = 1000.0 * m_options.maskImpedanceMax;
+	maskOptions.maskDead = m_options.maskDead;
+	m_channelMask = amplifierChannelMask(file.getFullPathName().toStdString(), m_reader.header(), maskOptions);
+	m_unmaskedChannels = unmaskedChannels(m_channelMask);
+	m_masking = m_unmaskedChannels.size() < m_channelMask.size();
+	m_processedInfo = maskedHeader(m_reader.header(), m_channelMask);
+	if (m_masking)
+		std::cerr << "IntanFileSourcePlugin: " << m_channelMask.size() - m_unmaskedChannels.size() << " of "
+			<< m_channelMask.size() << " channels masked" << std::endl;
+
+	const IntanHeaderInfo& info = m_processedInfo;
+	int nc = numProcessedChannels();
+	m_equalizer.setParameters(info.actualLowerBandwidth, info.actualUpperBandwidth,
+		m_options.targetLowerBandwidth, m_options.targetUpperBandwidth, m_reader.sampleRate(), nc);
+
+	m_applyNotchFilter = m_options.notchFromHeader && info.notchFilterEnabled;
+	if (m_applyNotchFilter)
+		m_notchFilter.setParameters((info.notchFilterFreq == 50.0) ? Notch50Hz : Notch60Hz, info.sampleRate, nc);
+
+	std::string refName = m_options.referenceChannelName.empty() ? info.refChannelName : m_options.referenceChannelName;
+	m_reference.setParameters(m_options.referenceMode, amplifierGroupRanges(info), amplifierChannelIndex(info, refName), nc);
+	if (m_reference.mode() != m_options.referenceMode)
+		std::cerr << "IntanFileSourcePlugin: reference channel " << refName << " not found, no re-referencing" << std::endl;
+
+	if (m_options.spikeDetection)
+	{
+		m_spikeDetector.setParameters(enabledAmplifierChannels(info), m_reader.sampleRate(), m_options.spikeRefractory / 1000.0);
+		if (!m_spikeDetector.isActive())
+			std::cerr << "IntanFileSourcePlugin: no channel has a voltage spike threshold, no spike detection" << std::endl;
+	}
+	else
+		m_spikeDetector.setParameters(std::vector<HeaderFileChannel>(), m_reader.sampleRate(), 0.0);
+	{
+		std::lock_guard<std::mutex> lock(m_spikeMutex);
+		m_spikeEvents.clear();
+	}
+	m_spikeCodeBits = 1;
+	while ((1 << m_spikeCodeBits) < m_reader.numAmplifierChannels())
+		m_spikeCodeBits++;
+	m_spikeSlots = (NumEventLines - SpikeStrobeLine) / (m_spikeCodeBits + 1);
+	m_pendingSpikes.clear();
+	m_nextSpikeTimestamp = 0;
+	m_spikesDropped = false;
+	openSpikeFile(file);
+
+	m_follower.stop();
+	if (m_options.follow)
+	{
+		try
+		{
+			m_follower.start(m_reader, m_options.followLag / 1000.0);
+		}
+		catch (std::exception &e)
+		{
+			std::cerr << "IntanFileSourcePlugin: " << e.what() << std::endl;
+		}
+	}
+
+	// The envelope of a recording that is still growing would be out of date as soon as it was built.
+	m_envelopeBuilder.cancel();
+	if (m_options.buildEnvelope && !m_follower.isActive())
+		m_envelopeBuilder.start(file.getFullPathName().toStdString());
+
+	// Likewise the channel statistics; once saved, later opens report them at once, otherwise they
+	// are reported when the scan finishes.
+	m_qcScanner.cancel();
+	if (m_options.channelQc && !m_follower.isActive())
+	{
+		double sampleRate = m_reader.sampleRate();
+		if (m_qcScanner.start(file.getFullPathName().toStdString(), 0, [this, sampleRate]() { reportChannelHealth(sampleRate); }))
+			reportChannelHealth(sampleRate);
+	}
+
+	// Montage inputs are named against all the amplifier channels; the weights of masked ones are dropped.
+	m_montage.clear();
+	if (!m_options.montageFileName.empty())
+	{
+		try
+		{
+			m_montage.load(file.getParentDirectory().getChildFile(m_options.montageFileName).getFullPathName().toStdString(),
+				enabledAmplifierChannels(m_reader.header()), m_channelMask);
+		}
+		catch (std::exception &e)
+		{
+			std::cerr << "IntanFileSourcePlugin: " << e.what() << std::endl;
+			return false;
+		}
+	}
+
+	m_lfpEnabled = m_options.lfp;
+	m_lfpActive = false;
+	if (m_lfpEnabled)
+		m_decimator.setParameters(info.sampleRate, numProcessedOutputs());
+
+	m_resample = m_options.resampleRate > 0.0 && m_options.resampleRate != m_reader.sampleRate();
+	if (m_resample)
+		m_resampler.setParameters(m_reader.sampleRate(), m_options.resampleRate, numProcessedOutputs(), ResampleBlockSize);
+
+	m_sharedRing.close();
+	createSharedRing();
+
+	// Following starts at the newest playable block, not at the start of the recording.
+	if (m_follower.isActive())
+		seekTo(liveEdge());
 	return true;
 }
 
+// A ring that cannot be created only means nothing is published.
+void IntanFileSourcePlugin::createSharedRing()
+{
+	if (m_options.sharedMemoryName.empty())
+		return;
+
+	double sampleRate = m_reader.sampleRate();
+	if (m_lfpActive)
+		sampleRate = m_decimator.outputRate();
+	else if (m_resample)
+		sampleRate = m_resampler.outputRate();
+	int numSlots = (int) std::ceil(m_options.sharedMemoryLength / 1000.0 * sampleRate / SharedRingBlockSize);
+	try
+	{
+		m_sharedRing.create(m_options.sharedMemoryName, numOutputChannels(), sampleRate, numSlots);
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << "IntanFileSourcePlugin: " << e.what() << std::endl;
+		m_sharedRing.close();
+	}
+}
+
+// Report how many channels are not healthy, of each kind, once the statistics are known. Called from
+// open(), or from the scanning thread.
+void IntanFileSourcePlugin::reportChannelHealth(double sampleRate) const
+{
+	std::string error = m_qcScanner.error();
+	if (!error.empty())
+	{
+		std::cerr << "IntanFileSourcePlugin: " << error << std::endl;
+		return;
+	}
+
+	std::vector<ChannelQc> channels = m_qcScanner.channels();
+	int counts[SaturatedChannel + 1] = {};
+	for (const ChannelQc& qc : channels)
+		counts[channelHealth(qc, sampleRate)]++;
+	int numUnhealthy = (int) channels.size() - counts[HealthyChannel];
+	if (numUnhealthy == 0)
+		return;
+	std::cerr << "IntanFileSourcePlugin: " << numUnhealthy << " of " << channels.size() << " channels not healthy ("
+		<< counts[DeadChannel] << " " << channelHealthName(DeadChannel) << ", "
+		<< counts[NoisyChannel] << " " << channelHealthName(NoisyChannel) << ", "
+		<< counts[SaturatedChannel] << " " << channelHealthName(SaturatedChannel) << ")" << std::endl;
+}
+
+// A spike file that is missing or cannot be read only means there are no spike events.
+void IntanFileSourcePlugin::openSpikeFile(const File& file)
+{
+	m_spikeFile.close();
+	m_spikeFileChannels.clear();
+	if (m_spikeDetector.isActive() || m_options.spikeFileName.empty())
+		return;
+
+	File spikeFile = file.getParentDirectory().getChildFile(m_options.spikeFileName);
+	if (!spikeFile.existsAsFile())
+		return;
+	try
+	{
+		m_spikeFile.open(spikeFile.getFullPathName().toStdString());
+	}
+	catch (std::exception &e)
+	{
+		std::cerr << "IntanFileSourcePlugin: " << e.what() << std::endl;
+		return;
+	}
+	for (const std::string& name : m_spikeFile.header().nativeChannelNames)
+	{
+		int index = amplifierChannelIndex(m_reader.header(), name);
+		m_spikeFileChannels.push_back((index >= 0 && m_channelMask[index]) ? -1 : index);
+	}
+}
+
 void IntanFileSourcePlugin::fillRecordInfo()
 {
+	RecordInfo info;
+	info.name = "Intan";
+	info.sampleRate = (float) (m_resample ? m_resampler.outputRate() : m_reader.sampleRate());
+	info.numSamples = m_resample ? numResampledSamples() : m_reader.numSamples();
+	if (m_follower.isActive())
+		info.numSamples = (int64) (FollowRecordLength * info.sampleRate);
+	info.startSampleNumber = 0;
+	if (m_montage.isLoaded())
+	{
+		for (const std::string& name : m_montage.outputNames())
+		{
+			RecordedChannelInfo c;
+			c.name = name;
+			c.bitVolts = AmplifierMicroVoltsPerBit;
+			info.channels.add(c);
+		}
+	}
+	else
+	{
+		for (const HeaderFileChannel& channel : m_reader.amplifierChannels())
+		{
+			RecordedChannelInfo c;
+			c.name = channel.customChannelName;
+			c.bitVolts = AmplifierMicroVoltsPerBit;
+			info.channels.add(c);
+		}
+	}
+	infoArray.add(info);
+	numRecords = 1;
 
+	if (m_lfpEnabled)
+	{
+		info.name = "Intan LFP";
+		info.sampleRate = (float) m_decimator.outputRate();
+		info.numSamples = m_follower.isActive() ? (int64) (FollowRecordLength * info.sampleRate) : numLfpSamples();
+		infoArray.add(info);
+		numRecords = 2;
+	}
 }
 
 void IntanFileSourcePlugin::updateActiveRecord(int index)
 {
-
+	bool wasLfpActive = m_lfpActive;
+	m_lfpActive = m_lfpEnabled && index == 1;
+	if (m_lfpActive != wasLfpActive && m_sharedRing.isOpen())
+		createSharedRing();
+	seekTo(m_follower.isActive() ? liveEdge() : 0);
 }
 
 void IntanFileSourcePlugin::seekTo(int64 sample)
 {
+	// LFP sample n is computed when the reader reaches wideband sample n * factor + delay.
+	// A resampled sample needs wideband samples from half the kernel length before it.
+	int64 widebandSample = sample;
+	if (m_lfpActive)
+	{
+		m_outputPosition = sample;
+		widebandSample = sample * m_decimator.factor() + m_decimator.delay();
+	}
+	else if (m_resample)
+	{
+		m_outputPosition = sample;
+		widebandSample = std::max<int64>(m_resampler.inputPosition(sample) - m_resampler.numTaps() / 2 + 1, 0);
+	}
+
+	// Spikes from the new position on will be detected again. Earlier ones may still be waiting
+	// for playback (the reader loops back to the start while the end is playing).
+	{
+		std::lock_guard<std::mutex> lock(m_spikeMutex);
+		m_spikeEvents.erase(std::remove_if(m_spikeEvents.begin(), m_spikeEvents.end(),
+			[widebandSample](const SpikeEvent& e) { return e.sample >= widebandSample; }), m_spikeEvents.end());
+	}
+	m_pendingSpikes.clear();
+	m_nextSpikeTimestamp = 0;
+
+	if (processingEnabled())
+		warmUp(widebandSample);
+	else
+		m_reader.seek(widebandSample);
+	if (m_resample && !m_lfpActive)
+		m_resampler.reset(widebandSample, sample);
+}
+
+bool IntanFileSourcePlugin::processingEnabled() const
+{
+	return m_equalizer.isActive() || m_applyNotchFilter || m_reference.mode() != NoReference || m_montage.isLoaded()
+		|| m_spikeDetector.isActive() || m_lfpActive || m_resample;
+}
+
+int IntanFileSourcePlugin::numOutputChannels() const
+{
+	return m_montage.isLoaded() ? m_montage.numOutputs() : m_reader.numAmplifierChannels();
+}
+
+// Channels the read-time processing works on (those not masked), and the width of its output.
+int IntanFileSourcePlugin::numProcessedChannels() const
+{
+	return m_masking ? (int) m_unmaskedChannels.size() : m_reader.numAmplifierChannels();
+}
+
+int IntanFileSourcePlugin::numProcessedOutputs() const
+{
+	return m_montage.isLoaded() ? m_montage.numOutputs() : numProcessedChannels();
+}
+
+int64 IntanFileSourcePlugin::numLfpSamples() const
+{
+	int64 n = m_reader.numSamples();
+	return (n > 0) ? (n - 1) / m_decimator.factor() + 1 : 0;
+}
+
+// Samples whose position falls within the amplifier data.
+int64 IntanFileSourcePlugin::numResampledSamples() const
+{
+	int64 n = m_reader.numSamples();
+	if (n <= 0)
+		return 0;
+	int64 k = (int64) std::floor((n - 1) * (m_resampler.outputRate() / m_resampler.inputRate()));
+	while (k > 0 && m_resampler.inputPosition(k) > n - 1)
+		k--;
+	while (m_resampler.inputPosition(k + 1) <= n - 1)
+		k++;
+	return k + 1;
+}
+
+int64 IntanFileSourcePlugin::activeNumSamples() const
+{
+	if (m_lfpActive)
+		return numLfpSamples();
+	return m_resample ? numResampledSamples() : m_reader.numSamples();
+}
+
+// Sample numbers of the active record and of the amplifier data. Wideband sample w belongs to
+// record sample fromWidebandSample(w), and record sample k starts at wideband sample toWidebandSample(k).
+int64 IntanFileSourcePlugin::toWidebandSample(int64 sample) const
+{
+	if (m_lfpActive)
+		return sample * m_decimator.factor();
+	if (m_resample)
+		return (int64) std::ceil(sample * (m_resampler.inputRate() / m_resampler.outputRate()) - 1.0e-9);
+	return sample;
+}
+
+int64 IntanFileSourcePlugin::fromWidebandSample(int64 sample) const
+{
+	if (m_lfpActive)
+		return sample / m_decimator.factor();
+	if (m_resample)
+		return (int64) std::floor(sample * (m_resampler.outputRate() / m_resampler.inputRate()) + 1.0e-9);
+	return sample;
+}
+
+// Filters are restarted on a seek. Run them over the samples preceding the new position
+// (output discarded) so that the first samples returned are already settled.
+void IntanFileSourcePlugin::warmUp(int64 sample)
+{
+	int warmUpLength = 0;
+	if (m_equalizer.isActive())
+	{
+		m_equalizer.reset();
+		warmUpLength = std::max(warmUpLength, m_equalizer.warmUpLength());
+	}
+	if (m_applyNotchFilter)
+	{
+		m_notchFilter.reset();
+		warmUpLength = std::max(warmUpLength, m_notchFilter.warmUpLength());
+	}
+	if (m_spikeDetector.isActive())
+	{
+		m_spikeDetector.reset();
+		warmUpLength = std::max(warmUpLength, m_spikeDetector.warmUpLength());
+	}
+	if (m_lfpActive)
+		warmUpLength = std::max(warmUpLength, m_decimator.numTaps());
+
+	int64 start = sample - warmUpLength;
+	if (start < 0) start = 0;
+	m_reader.seek(start);
+
+	// The decimator's next output is the one for the new position.
+	int nWarmUp = (int) (sample - start);
+	if (m_lfpActive)
+		m_decimator.reset(nWarmUp);
+
+	if (nWarmUp > 0)
+	{
+		int n = readMicroVolts(nWarmUp);
+		process(m_floatBuffer.data(), n, start, true);
+	}
+}
+
+// Spikes are detected on the re-referenced amplifier channels, before any montage.
+void IntanFileSourcePlugin::detectSpikes(const float* data, int nSamples, int64 firstSample)
+{
+	m_spikeBuffer.clear();
+	m_spikeDetector.detect(data, nSamples, firstSample, &m_spikeBuffer);
+	if (m_spikeBuffer.empty())
+		return;
+	if (m_masking)
+	{
+		for (SpikeEvent& e : m_spikeBuffer)
+			e.channel = m_unmaskedChannels[e.channel];
+	}
+
+	std::lock_guard<std::mutex> lock(m_spikeMutex);
+	m_spikeEvents.insert(m_spikeEvents.end(), m_spikeBuffer.begin(), m_spikeBuffer.end());
+}
+
+// Stateful filters, in the order they are applied to each block.
+void IntanFileSourcePlugin::filter(float* data, int nSamples)
+{
+	if (m_equalizer.isActive())
+		m_equalizer.filter(data, nSamples);
+	if (m_applyNotchFilter)
+		m_notchFilter.filter(data, nSamples);
+}
+
+// Read-time processing of nSamples frames of amplifier data (uV) starting at firstSample, in place
+// where possible. Returns the output frames (numProcessedOutputs() wide). While warming up, stages
+// without state are skipped unless a later stage with state needs their output.
+float* IntanFileSourcePlugin::process(float* data, int nSamples, int64 firstSample, bool warmingUp)
+{
+	filter(data, nSamples);
+	if (warmingUp && !m_spikeDetector.isActive() && !m_lfpActive)
+		return data;
+
+	m_reference.apply(data, nSamples);
+	if (m_spikeDetector.isActive())
+	{
+		if (warmingUp)
+			m_spikeDetector.detect(data, nSamples, firstSample, nullptr);
+		else
+			detectSpikes(data, nSamples, firstSample);
+	}
+	if (warmingUp && !m_lfpActive)
+		return data;
+
+	float* result = data;
+	if (m_montage.isLoaded())
+	{
+		size_t outCount = (size_t) nSamples * m_montage.numOutputs();
+		if (m_montageBuffer.size() < outCount)
+			m_montageBuffer.resize(outCount);
+		m_montage.apply(data, m_montageBuffer.data(), nSamples);
+		result = m_montageBuffer.data();
+	}
+
+	if (warmingUp)
+	{
+		m_lfpBuffer.resize((size_t) (nSamples / m_decimator.factor() + 1) * numProcessedOutputs());
+		m_decimator.process(result, nSamples, m_lfpBuffer.data());
+	}
+	return result;
+}
 
+// The sample of the active record to start following at: the newest one whose wideband samples,
+// including those the decimator or resampler reads ahead, are playable now.
+int64 IntanFileSourcePlugin::liveEdge()
+{
+	int64 playable = m_follower.playableSamples();
+	if (m_lfpActive)
+		playable -= m_decimator.delay();
+	else if (m_resample)
+		playable -= m_resampler.numTaps() / 2;
+	return fromWidebandSample(std::max<int64>(playable, 0));
+}
+
+// In live-follow mode, wait until the wideband samples needed for the next nSamples of the active
+// record are the follow lag behind the newest block written. After FollowReadTimeout the read goes
+// ahead with what there is, so playback catches up with a recording that has stopped growing.
+void IntanFileSourcePlugin::waitForData(int nSamples)
+{
+	int64 end = m_reader.position() + nSamples;
+	if (m_lfpActive)
+		end = toWidebandSample(m_outputPosition + nSamples) + m_decimator.delay();
+	else if (m_resample)
+		end = toWidebandSample(m_outputPosition + nSamples) + m_resampler.numTaps() / 2;
+	m_follower.waitFor(end, FollowReadTimeout);
 }
 
 int IntanFileSourcePlugin::readData(int16* buffer, int nSamples)
 {
-	return nSamples;
+	if (m_follower.isActive())
+		waitForData(nSamples);
+
+	// Other processes get the samples as played, in uV.
+	int64 firstSample = (m_lfpActive || m_resample) ? m_outputPosition : m_reader.position();
+	int n = readActiveRecord(buffer, nSamples);
+	if (m_sharedRing.isOpen() && n > 0)
+		m_sharedRing.publish(buffer, n, firstSample, (float) AmplifierMicroVoltsPerBit);
+	return n;
 }
 
-void IntanFileSourcePlugin::processChannelData(int16* inBuffer, float* outBuffer, int channel, int64 nSamples)
+int IntanFileSourcePlugin::readActiveRecord(int16* buffer, int nSamples)
+{
+	if (m_lfpActive)
+		return readLfpData(buffer, nSamples);
+	if (m_resample)
+		return readResampledData(buffer, nSamples);
+	if (!processingEnabled())
+	{
+		int n = m_reader.readAmplifierData(buffer, nSamples);
+		if (m_masking)
+			zeroMaskedChannels(buffer, n, m_channelMask);
+		return n;
+	}
+
+	int64 firstSample = m_reader.position();
+	int n = readMicroVolts(nSamples);
+	const float* result = process(m_floatBuffer.data(), n, firstSample, false);
+	writeOutput(result, buffer, n);
+	return n;
+}
+
+// Read nSamples frames at the read position, and convert the channels processed to uV in m_floatBuffer.
+int IntanFileSourcePlugin::readMicroVolts(int nSamples)
 {
+	int nc = m_reader.numAmplifierChannels();
+	size_t count = (size_t) nSamples * nc;
+	if (m_rawBuffer.size() < count)
+		m_rawBuffer.resize(count);
+	if (m_floatBuffer.size() < count)
+		m_floatBuffer.resize(count);
 
+	int n = m_reader.readAmplifierData(m_rawBuffer.data(), nSamples);
+	if (m_masking)
+		unmaskedToMicroVolts(m_rawBuffer.data(), nc, n, m_unmaskedChannels, m_floatBuffer.data());
+	else
+		amplifierToMicroVolts(m_rawBuffer.data(), m_floatBuffer.data(), (int64) n * nc);
+	return n;
 }
 
+// Convert nSamples processed frames back to amplifier words, numOutputChannels() wide.
+void IntanFileSourcePlugin::writeOutput(const float* data, int16* buffer, int nSamples)
+{
+	if (m_masking && !m_montage.isLoaded())
+		microVoltsToUnmasked(data, nSamples, m_unmaskedChannels, m_reader.numAmplifierChannels(), buffer);
+	else
+		microVoltsToAmplifier(data, buffer, (int64) nSamples * numOutputChannels());
+}
+
+// Read and process nSamples wideband frames. Frames past the end of the file repeat the last frame.
+// Returns the output frames (numProcessedOutputs() wide), or nullptr if there is no data at all.
+float* IntanFileSourcePlugin::readPadded(int nSamples)
+{
+	int nc = m_reader.numAmplifierChannels();
+	int nOutputChannels = numProcessedOutputs();
+	size_t count = (size_t) nSamples * std::max(nc, nOutputChannels);
+	if (m_rawBuffer.size() < count)
+		m_rawBuffer.resize(count);
+	if (m_floatBuffer.size() < count)
+		m_floatBuffer.resize(count);
+	if (m_montageBuffer.size() < count)
+		m_montageBuffer.resize(count);
+
+	int64 firstSample = m_reader.position();
+	int n = readMicroVolts(nSamples);
+	float* result = process(m_floatBuffer.data(), n, firstSample, false);
+
+	if (n > 0)
+		m_lastFrame.assign(result + (size_t) (n - 1) * nOutputChannels, result + (size_t) n * nOutputChannels);
+	if (m_lastFrame.empty())
+		return nullptr;
+	for (int t = n; t < nSamples; t++)
+		std::copy(m_lastFrame.begin(), m_lastFrame.end(), result + (size_t) t * nOutputChannels);
+	return result;
+}
+
+// Only the wideband samples needed for the requested LFP samples are read. The last few LFP samples
+// need wideband samples past the end of the file.
+int IntanFileSourcePlugin::readLfpData(int16* buffer, int nSamples)
+{
+	nSamples = (int) std::min<int64>(nSamples, numLfpSamples() - m_outputPosition);
+	if (nSamples <= 0)
+		return 0;
+
+	int nIn = m_decimator.inputsForOutputs(nSamples);
+	float* result = readPadded(nIn);
+	if (!result)
+		return 0;
+
+	size_t outCount = (size_t) (nSamples + 1) * numProcessedOutputs();
+	if (m_lfpBuffer.size() < outCount)
+		m_lfpBuffer.resize(outCount);
+	int nOut = m_decimator.process(result, nIn, m_lfpBuffer.data());
+	writeOutput(m_lfpBuffer.data(), buffer, nOut);
+	m_outputPosition += nOut;
+	return nOut;
+}
+
+// As for the LFP record, with the resampler in place of the decimator.
+int IntanFileSourcePlugin::readResampledData(int16* buffer, int nSamples)
+{
+	nSamples = (int) std::min<int64>(nSamples, numResampledSamples() - m_outputPosition);
+	if (nSamples <= 0)
+		return 0;
+
+	int nIn = (int) m_resampler.inputsForOutputs(nSamples);
+	float* result = readPadded(nIn);
+	if (!result)
+		return 0;
+
+	size_t outCount = (size_t) m_resampler.maxOutputs(nIn) * numProcessedOutputs();
+	if (m_resampleBuffer.size() < outCount)
+		m_resampleBuffer.resize(outCount);
+	int nOut = m_resampler.process(result, nIn, m_resampleBuffer.data());
+	writeOutput(m_resampleBuffer.data(), buffer, nOut);
+	m_outputPosition += nOut;
+	return nOut;
+}
+
+void IntanFileSourcePlugin::processChannelData(int16* inBuffer, float* outBuffer, int channel, int64 nSamples)
+{
+	int nc = numOutputChannels();
+	float bitVolts = (float) AmplifierMicroVoltsPerBit;
+	for (int64 i = 0; i < nSamples; i++)
+		outBuffer[i] = inBuffer[i * nc + channel] * bitVolts;
+}
+
+// Each spike, detected or from the spike file, is reported as a strobe pulse in a slot, with its channel
+// index coded alongside (see SpikeStrobeLine). Up to one spike per slot is reported at a sample, and the
+// pulses are two samples apart so that each has its own rising edge: spikes beyond the slots are reported
+// a few samples late, and those pushed past stopTimestamp wait for the next call. Timestamps keep
+// counting up when playback loops, as in the other file sources.
 void IntanFileSourcePlugin::processEventData(EventInfo& info, int64 startTimestamp, int64 stopTimestamp)
 {
+	int64 numSamples = activeNumSamples();
+	if (numSamples <= 0)
+		return;
+	int64 loopOffset = m_follower.isActive() ? 0 : (startTimestamp / numSamples) * numSamples;
 
+	// Spikes are kept in wideband samples; decimated and resampled records report them at the
+	// sample they fall in.
+	int64 localStart = toWidebandSample(startTimestamp - loopOffset);
+	int64 localStop = toWidebandSample(stopTimestamp - loopOffset);
+
+	m_eventScratch.clear();
+	if (m_spikeFile.isOpen())
+	{
+		// Spike file timestamps count from the first timestamp in time.dat.
+		int64 origin = m_reader.firstTimestamp();
+		for (int c = 0; c < (int) m_spikeFileChannels.size(); c++)
+		{
+			if (m_spikeFileChannels[c] < 0)
+				continue;
+			const std::vector<int32_t>& times = m_spikeFile.spikeTimes(c);
+			std::vector<int32_t>::const_iterator it = std::lower_bound(times.begin(), times.end(), localStart + origin,
+				[](int32_t t, int64 v) { return t < v; });
+			for (; it != times.end() && *it < localStop + origin; ++it)
+				m_eventScratch.push_back({ *it - origin, m_spikeFileChannels[c] });
+		}
+	}
+	else
+	{
+		// The queue is in the order the data was read, which is the order it is played. Anything
+		// queued before the last event handed out here has been played past.
+		std::lock_guard<std::mutex> lock(m_spikeMutex);
+		size_t played = 0;
+		for (size_t i = 0; i < m_spikeEvents.size(); i++)
+		{
+			const SpikeEvent& e = m_spikeEvents[i];
+			if (e.sample < localStart || e.sample >= localStop)
+				continue;
+			m_eventScratch.push_back(e);
+			played = i + 1;
+		}
+		m_spikeEvents.erase(m_spikeEvents.begin(), m_spikeEvents.begin() + played);
+	}
+
+	std::stable_sort(m_eventScratch.begin(), m_eventScratch.end(),
+		[](const SpikeEvent& a, const SpikeEvent& b) { return a.sample < b.sample; });
+	for (const SpikeEvent& e : m_eventScratch)
+	{
+		if (m_pendingSpikes.size() >= MaxPendingSpikes)
+		{
+			if (!m_spikesDropped)
+				std::cerr << "IntanFileSourcePlugin: more spikes than the event lines carry, some dropped" << std::endl;
+			m_spikesDropped = true;
+			break;
+		}
+		m_pendingSpikes.push_back({ fromWidebandSample(e.sample) + loopOffset, e.channel });
+	}
+
+	const int slotLines = m_spikeCodeBits + 1;
+	while (!m_pendingSpikes.empty())
+	{
+		int64 timestamp = std::max<int64>(m_pendingSpikes.front().sample, m_nextSpikeTimestamp);
+		if (timestamp >= stopTimestamp)
+			break;
+		m_spikeSlotChannels.clear();
+		while (!m_pendingSpikes.empty() && m_pendingSpikes.front().sample <= timestamp && (int) m_spikeSlotChannels.size() < m_spikeSlots)
+		{
+			m_spikeSlotChannels.push_back(m_pendingSpikes.front().channel);
+			m_pendingSpikes.pop_front();
+		}
+		for (int state = 1; state >= 0; state--)
+		{
+			for (int slot = 0; slot < (int) m_spikeSlotChannels.size(); slot++)
+			{
+				int strobe = SpikeStrobeLine + slot * slotLines;
+				for (int bit = -1; bit < m_spikeCodeBits; bit++)
+				{
+					if (bit >= 0 && !((m_spikeSlotChannels[slot] >> bit) & 1))
+						continue;
+					info.channels.add((int16) (strobe + 1 + bit));
+					info.channelStates.add((int16) state);
+					info.timestamps.add(timestamp + 1 - state);
+				}
+			}
+		}
+		m_nextSpikeTimestamp = timestamp + 2;
+	}
 }
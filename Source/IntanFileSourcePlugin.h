@@ -26,11 +26,133 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define FILESOURCEPLUGIN_H_DEFINED
 
 #include <FileSourceHeaders.h>
+#include <vector>
+#include <deque>
+#include <mutex>
 #include "rhx/cnsrhx.h"
+#include "rhx/cnsreader.h"
+#include "rhx/cnsfilter.h"
+#include "rhx/cnsoptions.h"
+#include "rhx/cnsreference.h"
+#include "rhx/cnsmontage.h"
+#include "rhx/cnsspikes.h"
+#include "rhx/cnsspikefile.h"
+#include "rhx/cnsenvelope.h"
+#include "rhx/cnsqc.h"
+#include "rhx/cnsmask.h"
+#include "rhx/cnsdecimate.h"
+#include "rhx/cnsresample.h"
+#include "rhx/cnsfollow.h"
+#include "rhx/cnsshm.h"
 
 class IntanFileSourcePlugin : public FileSource
 {
-	IntanHeaderInfo m_intanHeaderInfo;
+	IntanDataReader m_reader;
+	IntanProcessingOptions m_options;
+
+	// Amplifier channels masked per the options file (impedance, or dead by the saved statistics).
+	// Read-time processing runs on the channels left only, described by m_processedInfo (the header
+	// with the masked channels disabled); masked channels are output as 0.
+	bool m_masking;
+	std::vector<bool> m_channelMask;
+	std::vector<int> m_unmaskedChannels;
+	IntanHeaderInfo m_processedInfo;
+
+	// Amplifier data is converted to float (uV) for read-time processing, then written back to the int16 buffer.
+	std::vector<int16> m_rawBuffer;
+	std::vector<float> m_floatBuffer;
+	std::vector<float> m_montageBuffer;
+
+	// Software notch filter, applied when the header says the notch was enabled in RHX.
+	bool m_applyNotchFilter;
+	MultichannelNotchFilter m_notchFilter;
+
+	// Analog bandwidth equalization, per the options file.
+	BandwidthEqualizer m_equalizer;
+
+	// Software re-referencing, per the options file.
+	MultichannelReference m_reference;
+
+	// Linear montage from the options file. When loaded, its outputs replace the amplifier channels.
+	LinearMontage m_montage;
+
+	// Online threshold spike detection, per the options file. Spikes found by readData() are queued
+	// (readData runs ahead of playback) until processEventData() hands them out as events.
+	ThresholdSpikeDetector m_spikeDetector;
+	std::vector<SpikeEvent> m_spikeBuffer;
+	std::deque<SpikeEvent> m_spikeEvents;
+	std::mutex m_spikeMutex;
+
+	// Spikes saved by RHX, reported as events when spike detection is off. m_spikeFileChannels maps
+	// each spike file channel to its amplifier channel index (-1 if not an enabled amplifier channel).
+	IntanSpikeFile m_spikeFile;
+	std::vector<int> m_spikeFileChannels;
+	std::vector<SpikeEvent> m_eventScratch;
+
+	// Spikes handed out, as record timestamps, waiting for a strobe pulse (see processEventData()), the
+	// number of lines coding the channel index and of slots, and the earliest timestamp of the next pulses.
+	std::deque<SpikeEvent> m_pendingSpikes;
+	std::vector<int> m_spikeSlotChannels;
+	int m_spikeCodeBits;
+	int m_spikeSlots;
+	int64 m_nextSpikeTimestamp;
+	bool m_spikesDropped;
+
+	// Background build of the envelope file used for zoomed-out display, per the options file.
+	EnvelopeBuilder m_envelopeBuilder;
+
+	// Per-channel statistics, per the options file: loaded from info.rhd.qc, or scanned for in the
+	// background, and the unhealthy channels reported once known.
+	ChannelQcScanner m_qcScanner;
+
+	// Decimated LFP copy of the output channels, offered as a second record per the options file.
+	// LFP sample n is aligned with wideband sample n * factor (the filter delay is read ahead).
+	bool m_lfpEnabled;
+	bool m_lfpActive;
+	PolyphaseDecimator m_decimator;
+	std::vector<float> m_lfpBuffer;
+
+	// Resampling of the wideband record to the rate given in the options file.
+	bool m_resample;
+	Resampler m_resampler;
+	std::vector<float> m_resampleBuffer;
+
+	// Live-follow mode, per the options file: the recording is still being written by RHX.
+	RecordingFollower m_follower;
+
+	// Shared memory ring the samples read are published to, per the options file, for other local
+	// processes. It carries the active record, and is created again when that changes.
+	SharedSampleRing m_sharedRing;
+
+	// Position in the active record when it is decimated or resampled, and the last processed
+	// frame, which stands in for frames past the end of the file.
+	int64 m_outputPosition;
+	std::vector<float> m_lastFrame;
+
+	bool processingEnabled() const;
+	int numOutputChannels() const;
+	int numProcessedChannels() const;
+	int numProcessedOutputs() const;
+	int64 numLfpSamples() const;
+	int64 numResampledSamples() const;
+	int64 activeNumSamples() const;
+	int64 toWidebandSample(int64 sample) const;
+	int64 fromWidebandSample(int64 sample) const;
+	int64 liveEdge();
+	void waitForData(int nSamples);
+	void createSharedRing();
+	void reportChannelHealth(double sampleRate) const;
+	int readActiveRecord(int16* buffer, int nSamples);
+	int readMicroVolts(int nSamples);
+	void writeOutput(const float* data, int16* buffer, int nSamples);
+	void filter(float* data, int nSamples);
+	float* process(float* data, int nSamples, int64 firstSample, bool warmingUp);
+	void warmUp(int64 sample);
+	float* readPadded(int nSamples);
+	int readLfpData(int16* buffer, int nSamples);
+	int readResampledData(int16* buffer, int nSamples);
+	void detectSpikes(const float* data, int nSamples, int64 firstSample);
+	void openSpikeFile(const File& file);
 
 public:
 	/** The class constructor, used to initialize any members. */
@@ -30,6 +30,7 @@
 
 #include "rhxregisters.h"
 #include "abstractrhxcontroller.h"
+#include "cnscoefficients.h"
 
 #include <iostream>
 #include <iomanip>
@@ -359,61 +360,9 @@ double AbstractRHXController::getSampleRate() const
 // Return the given sample rate enum as a floating-point number.
 double AbstractRHXController::getSampleRate(AmplifierSampleRate sampleRate_)
 {
-    switch (sampleRate_) {
-    case SampleRate1000Hz:
-        return 1000.0;
-        break;
-    case SampleRate1250Hz:
-        return 1250.0;
-        break;
-    case SampleRate1500Hz:
-        return 1500.0;
-        break;
-    case SampleRate2000Hz:
-        return 2000.0;
-        break;
-    case SampleRate2500Hz:
-        return 2500.0;
-        break;
-    case SampleRate3000Hz:
-        return 3000.0;
-        break;
-    case SampleRate3333Hz:
-        return (10000.0 / 3.0);
-        break;
-    case SampleRate4000Hz:
-        return 4000.0;
-        break;
-    case SampleRate5000Hz:
-        return 5000.0;
-        break;
-    case SampleRate6250Hz:
-        return 6250.0;
-        break;
-    case SampleRate8000Hz:
-        return 8000.0;
-        break;
-    case SampleRate10000Hz:
-        return 10000.0;
-        break;
-    case SampleRate12500Hz:
-        return 12500.0;
-        break;
-    case SampleRate15000Hz:
-        return 15000.0;
-        break;
-    case SampleRate20000Hz:
-        return 20000.0;
-        break;
-    case SampleRate25000Hz:
-        return 25000.0;
-        break;
-    case SampleRate30000Hz:
-        return 30000.0;
-        break;
-    default:
+    if ((int) sampleRate_ < 0 || (int) sampleRate_ >= NumSampleRates)
         return -1.0;
-    }
+    return SampleRateTable[(int) sampleRate_];
 }
 
 int AbstractRHXController::numAnalogIO(ControllerType type_, bool expanderConnected_)
@@ -568,40 +517,11 @@ bool AbstractRHXController::approximatelyEqual(double a, double b, double percen
 
 AmplifierSampleRate AbstractRHXController::nearestSampleRate(double rate, double percentTolerance)
 {
-    if (approximatelyEqual(rate, getSampleRate(SampleRate30000Hz), percentTolerance))
-        return SampleRate30000Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate25000Hz), percentTolerance))
-        return SampleRate25000Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate20000Hz), percentTolerance))
-        return SampleRate20000Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate15000Hz), percentTolerance))
-        return SampleRate15000Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate12500Hz), percentTolerance))
-        return SampleRate12500Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate10000Hz), percentTolerance))
-        return SampleRate10000Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate8000Hz), percentTolerance))
-        return SampleRate8000Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate6250Hz), percentTolerance))
-        return SampleRate6250Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate5000Hz), percentTolerance))
-        return SampleRate5000Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate4000Hz), percentTolerance))
-        return SampleRate4000Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate3333Hz), percentTolerance))
-        return SampleRate3333Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate3000Hz), percentTolerance))
-        return SampleRate3000Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate2500Hz), percentTolerance))
-        return SampleRate2500Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate2000Hz), percentTolerance))
-        return SampleRate2000Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate1500Hz), percentTolerance))
-        return SampleRate1500Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate1250Hz), percentTolerance))
-        return SampleRate1250Hz;
-    if (approximatelyEqual(rate, getSampleRate(SampleRate1000Hz), percentTolerance))
-        return SampleRate1000Hz;
+    // Highest rate first, as in RHX.
+    for (int i = NumSampleRates - 1; i >= 0; i--) {
+        if (approximatelyEqual(rate, SampleRateTable[i], percentTolerance))
+            return (AmplifierSampleRate) i;
+    }
     return (AmplifierSampleRate) -1;
 }
 
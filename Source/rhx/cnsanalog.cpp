@@ -0,0 +1,197 @@
+/*
+ * cnsanalog.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <exception>
+#include <stdexcept>
+#include <filesystem>
+#include <algorithm>
+#include "cnsanalog.h"
+using namespace std;
+
+
+// Frames read from the data files at a time.
+static const int64_t AnalogReadBlockSize = 1 << 14;
+
+BoardAnalogDecoder boardAnalogDecoder(ControllerType type, SignalType signal)
+{
+    if (signal != BoardAdcSignal && signal != BoardDacSignal)
+        throw std::runtime_error("Analog Error: not a board ADC or DAC signal");
+    const bool adc = (signal == BoardAdcSignal);
+    switch (type)
+    {
+    case ControllerRecordUSB2:
+        return adc ? boardAnalogToVolts<ControllerRecordUSB2, BoardAdcSignal> : boardAnalogToVolts<ControllerRecordUSB2, BoardDacSignal>;
+    case ControllerRecordUSB3:
+        return adc ? boardAnalogToVolts<ControllerRecordUSB3, BoardAdcSignal> : boardAnalogToVolts<ControllerRecordUSB3, BoardDacSignal>;
+    case ControllerStimRecord:
+        return adc ? boardAnalogToVolts<ControllerStimRecord, BoardAdcSignal> : boardAnalogToVolts<ControllerStimRecord, BoardDacSignal>;
+    default:
+        throw std::runtime_error("Analog Error: unknown controller type");
+    }
+}
+
+
+BoardAnalogReader::BoardAnalogReader()
+: m_numSamples(0)
+, m_decode(nullptr)
+, m_signal(BoardAdcSignal)
+{
+}
+
+BoardAnalogReader::~BoardAnalogReader()
+{
+    close();
+}
+
+void BoardAnalogReader::open(const string& headerFilename, SignalType signal)
+{
+    close();
+    m_signal = signal;
+    IntanHeaderInfo info;
+    const bool traditional = isTraditionalIntanFile(headerFilename);
+    if (traditional)
+    {
+        m_traditional.reset(new TraditionalIntanReader());
+        m_traditional->open(headerFilename);
+        info = m_traditional->info();
+    }
+    else
+        readIntanHeader(headerFilename.c_str(), info);
+    m_decode = boardAnalogDecoder(info.controllerType, signal);
+    for (const HeaderFileGroup& group : info.groups)
+    {
+        for (const HeaderFileChannel& channel : group.channels)
+        {
+            if (channel.enabled && channel.signalType == signal)
+                m_channels.push_back(channel);
+        }
+    }
+    if (m_channels.empty())
+        return;
+
+    if (traditional)
+    {
+        const TraditionalBlockLayout& layout = m_traditional->layout();
+        const bool present = (m_traditional->signals() & ((signal == BoardAdcSignal) ? TraditionalAdcSignal : TraditionalDacSignal)) != 0;
+        if (!present || ((signal == BoardAdcSignal) ? layout.numAdcChannels : layout.numDacChannels) != numChannels())
+        {
+            close();
+            throw std::runtime_error("Analog Error: the data blocks of " + headerFilename + " do not match its " +
+                                     ((signal == BoardAdcSignal) ? "analog inputs" : "analog outputs"));
+        }
+        m_numSamples = m_traditional->numSamples();
+        return;
+    }
+
+    filesystem::path directory = filesystem::path(headerFilename).parent_path();
+    filesystem::path path = directory / ((signal == BoardAdcSignal) ? "analogin.dat" : "analogout.dat");
+    if (filesystem::exists(path))
+    {
+        m_file.open(path.string(), ios::in | ios::binary);
+        if (!m_file)
+        {
+            close();
+            throw std::runtime_error("Analog Error: cannot open " + path.string());
+        }
+        m_numSamples = (int64_t) filesystem::file_size(path) / ((int64_t) sizeof(uint16_t) * numChannels());
+        return;
+    }
+
+    // One file per channel. The files can differ in length if a recording was cut short; use the shortest.
+    m_numSamples = -1;
+    for (const HeaderFileChannel& channel : m_channels)
+    {
+        string filename = (directory / ("board-" + channel.nativeChannelName + ".dat")).string();
+        if (!filesystem::exists(filename))
+        {
+            close();
+            throw std::runtime_error("Analog Error: cannot find " + path.string() + " or " + filename);
+        }
+        m_channelFiles.emplace_back(new ifstream(filename, ios::in | ios::binary));
+        if (!*m_channelFiles.back())
+        {
+            close();
+            throw std::runtime_error("Analog Error: cannot open " + filename);
+        }
+        int64_t n = (int64_t) filesystem::file_size(filename) / (int64_t) sizeof(uint16_t);
+        m_numSamples = (m_numSamples < 0) ? n : min(m_numSamples, n);
+    }
+}
+
+void BoardAnalogReader::close()
+{
+    if (m_file.is_open())
+        m_file.close();
+    m_file.clear();
+    m_channelFiles.clear();
+    m_traditional.reset();
+    m_channels.clear();
+    m_numSamples = 0;
+    m_decode = nullptr;
+}
+
+int64_t BoardAnalogReader::readWords(int64_t firstSample, int64_t nSamples, uint16_t* frames)
+{
+    nSamples = min(nSamples, m_numSamples - firstSample);
+    if (firstSample < 0 || nSamples <= 0)
+        return 0;
+    const int nc = numChannels();
+
+    if (m_file.is_open())
+    {
+        m_file.clear();
+        m_file.seekg(firstSample * nc * (int64_t) sizeof(uint16_t), ios::beg);
+        if (!m_file.read((char *) frames, nSamples * nc * (int64_t) sizeof(uint16_t)))
+            throw std::runtime_error("Analog Error: cannot read analog data");
+        return nSamples;
+    }
+
+    if (m_traditional)
+    {
+        TraditionalSamples samples;
+        if (m_signal == BoardAdcSignal)
+            samples.boardAdc = frames;
+        else
+            samples.boardDac = frames;
+        return m_traditional->read(firstSample, nSamples, samples);
+    }
+
+    // Interleave the channel files' words, a block at a time.
+    m_words.resize((size_t) min(nSamples, AnalogReadBlockSize));
+    for (int c = 0; c < nc; c++)
+    {
+        ifstream& in = *m_channelFiles[c];
+        in.clear();
+        in.seekg(firstSample * (int64_t) sizeof(uint16_t), ios::beg);
+        for (int64_t done = 0; done < nSamples; )
+        {
+            const int64_t n = min(nSamples - done, AnalogReadBlockSize);
+            if (!in.read((char *) m_words.data(), n * (int64_t) sizeof(uint16_t)))
+                throw std::runtime_error("Analog Error: cannot read analog data");
+            uint16_t* out = frames + done * nc + c;
+            for (int64_t t = 0; t < n; t++)
+                out[t * nc] = m_words[t];
+            done += n;
+        }
+    }
+    return nSamples;
+}
+
+int64_t BoardAnalogReader::read(int64_t firstSample, int64_t nSamples, float* frames)
+{
+    const int nc = numChannels();
+    m_frames.resize((size_t) min(max<int64_t>(nSamples, 0), AnalogReadBlockSize) * nc);
+    int64_t done = 0;
+    while (done < nSamples)
+    {
+        const int64_t n = readWords(firstSample + done, min(nSamples - done, AnalogReadBlockSize), m_frames.data());
+        if (n <= 0)
+            break;
+        m_decode(m_frames.data(), frames + done * nc, n * nc);
+        done += n;
+    }
+    return done;
+}
@@ -0,0 +1,90 @@
+/*
+ * cnsanalog.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSANALOG_H_
+#define RHX_CNSANALOG_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+#include <cstdint>
+#include "cnsrhx.h"
+#include "cnstraditional.h"
+
+// Scaling of board ADC (analog input) and DAC (analog output) words: volts = VoltsPerBit * (word - Offset).
+// The RHD recording controller and the RHS stim/record controller save offset binary words (+/-10.24 V);
+// the RHD USB interface board saves its ADCs (0 to 3.3 V) unsigned.
+template <ControllerType Type, SignalType Signal>
+struct BoardAnalogScale
+{
+    static constexpr double VoltsPerBit = 312.5e-6;
+    static constexpr int32_t Offset = 32768;
+};
+
+template <>
+struct BoardAnalogScale<ControllerRecordUSB2, BoardAdcSignal>
+{
+    static constexpr double VoltsPerBit = 50.354e-6;
+    static constexpr int32_t Offset = 0;
+};
+
+// Convert count board ADC or DAC words to volts. The scale and offset are constants of the instantiation,
+// so the loop is one subtract, convert and multiply per word, with no branches, and vectorizes.
+template <ControllerType Type, SignalType Signal>
+void boardAnalogToVolts(const uint16_t* words, float* volts, int64_t count)
+{
+    const float scale = (float) BoardAnalogScale<Type, Signal>::VoltsPerBit;
+    for (int64_t i = 0; i < count; i++)
+        volts[i] = scale * (float) ((int32_t) words[i] - BoardAnalogScale<Type, Signal>::Offset);
+}
+
+typedef void (*BoardAnalogDecoder)(const uint16_t* words, float* volts, int64_t count);
+
+// The instantiation of boardAnalogToVolts() for a controller and signal type (BoardAdcSignal or
+// BoardDacSignal). Will throw() on any other signal type.
+BoardAnalogDecoder boardAnalogDecoder(ControllerType type, SignalType signal);
+
+// Reader for the board analog inputs (ADCs) or outputs (DACs) of a recording, in volts. Reads analogin.dat
+// (analogout.dat), in the one file per channel format the board-ANALOG-IN-n.dat (board-ANALOG-OUT-n.dat)
+// file of each enabled channel, or the data blocks of a traditional .rhd or .rhs file. Samples are returned in frames (channel index varying fastest), in the
+// order the channels appear in the header. The decoder is chosen once, by open(), from the header's
+// controller type.
+class BoardAnalogReader
+{
+public:
+    BoardAnalogReader();
+    ~BoardAnalogReader();
+
+    // signal is BoardAdcSignal or BoardDacSignal. Will throw() on fail.
+    void open(const std::string& headerFilename, SignalType signal = BoardAdcSignal);
+    void close();
+
+    const std::vector<HeaderFileChannel>& channels() const { return m_channels; }
+    int numChannels() const { return (int) m_channels.size(); }
+    int64_t numSamples() const { return m_numSamples; }
+
+    // Read nSamples frames of words from firstSample (>= 0) on, up to the end of the data. Returns the
+    // number of frames read.
+    int64_t readWords(int64_t firstSample, int64_t nSamples, uint16_t* frames);
+
+    // As readWords(), in volts.
+    int64_t read(int64_t firstSample, int64_t nSamples, float* frames);
+
+private:
+    std::vector<HeaderFileChannel> m_channels;
+    int64_t m_numSamples;
+    BoardAnalogDecoder m_decode;
+    std::ifstream m_file;                                       // analogin.dat or analogout.dat
+    std::vector<std::unique_ptr<std::ifstream>> m_channelFiles; // or one per channel
+    std::unique_ptr<TraditionalIntanReader> m_traditional;      // or the data blocks of the header file
+    SignalType m_signal;
+    std::vector<uint16_t> m_words;
+    std::vector<uint16_t> m_frames;
+};
+
+
+#endif /* RHX_CNSANALOG_H_ */
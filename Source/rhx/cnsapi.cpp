@@ -0,0 +1,493 @@
+/*
+ * cnsapi.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <exception>
+#include <stdexcept>
+#include <filesystem>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstring>
+#include "abstractrhxcontroller.h"
+#include "cnsreader.h"
+#include "cnsdigital.h"
+#include "cnsanalog.h"
+#include "cnsapi.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+
+// Frames gathered at a time when the data cannot be read in place.
+const int ApiReadBlockSize = 4096;
+
+// A whole file mapped read-only.
+class MappedFile
+{
+public:
+    MappedFile() : m_data(nullptr), m_size(0) {}
+    ~MappedFile() { close(); }
+
+    // Returns false if the file cannot be mapped (or is empty).
+    bool open(const string& filename)
+    {
+        close();
+        error_code ec;
+        int64_t size = (int64_t) filesystem::file_size(filename, ec);
+        if (ec || size <= 0)
+            return false;
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return false;
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping)
+            return false;
+        void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!data)
+            return false;
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        void* data = mmap(nullptr, (size_t) size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED)
+            return false;
+#endif
+        m_data = data;
+        m_size = size;
+        return true;
+    }
+
+    void close()
+    {
+        if (m_data)
+        {
+#ifdef _WIN32
+            UnmapViewOfFile(m_data);
+#else
+            munmap(m_data, (size_t) m_size);
+#endif
+        }
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    const void* data() const { return m_data; }
+    int64_t size() const { return m_size; }
+
+private:
+    void* m_data;
+    int64_t m_size;
+};
+
+struct IntanReader
+{
+    string headerFilename;
+    IntanDataReader reader;
+    vector<string> groupNames;          // per amplifier channel
+    MappedFile amplifierMap;
+    MappedFile timeMap;
+    vector<int16_t> frames;
+    vector<int32_t> allChannels;
+    unique_ptr<DigitalLineReader> digital[2];   // inputs and outputs, opened when first used
+    unique_ptr<BoardAnalogReader> analog[2];
+};
+
+static thread_local string lastError;
+
+static int fail(const char* message)
+{
+    lastError = message;
+    return INTAN_ERROR;
+}
+
+// Fill the first size bytes of out from value, so callers built against a shorter struct still work.
+template <typename T>
+static void copyStruct(const T& value, T* out, size_t size)
+{
+    memcpy(out, &value, min(size, sizeof(T)));
+}
+
+
+int intan_api_version(void)
+{
+    return INTAN_API_VERSION;
+}
+
+const char* intan_last_error(void)
+{
+    return lastError.c_str();
+}
+
+int intan_open(const char* headerFilename, IntanReader** reader)
+{
+    if (!headerFilename || !reader)
+        return fail("intan_open: null argument");
+    *reader = nullptr;
+    try
+    {
+        IntanReader* r = new IntanReader;
+        try
+        {
+            r->reader.open(headerFilename);
+            r->headerFilename = headerFilename;
+        }
+        catch (...)
+        {
+            delete r;
+            throw;
+        }
+        for (const HeaderFileGroup& group : r->reader.header().groups)
+        {
+            for (const HeaderFileChannel& channel : group.channels)
+            {
+                if (channel.enabled && channel.signalType == AmplifierSignal)
+                    r->groupNames.push_back(group.name);
+            }
+        }
+        for (int c = 0; c < r->reader.numAmplifierChannels(); c++)
+            r->allChannels.push_back(c);
+
+        // Only whole frames are mapped; the files are read normally if they cannot be.
+        if (!r->reader.isCompressed() && r->amplifierMap.open(r->reader.amplifierFilename()) &&
+            r->amplifierMap.size() < r->reader.numSamples() * BytesPerWord * r->reader.numAmplifierChannels())
+            r->amplifierMap.close();
+        filesystem::path timePath = filesystem::path(r->reader.directory()) / "time.dat";
+        if (r->timeMap.open(timePath.string()) && r->timeMap.size() < r->reader.numSamples() * (int64_t) sizeof(int32_t))
+            r->timeMap.close();
+        *reader = r;
+        return INTAN_OK;
+    }
+    catch (std::exception &e)
+    {
+        return fail(e.what());
+    }
+}
+
+void intan_close(IntanReader* reader)
+{
+    delete reader;
+}
+
+int intan_get_header(const IntanReader* reader, IntanHeader* header, size_t size)
+{
+    if (!reader || !header)
+        return fail("intan_get_header: null argument");
+    const IntanHeaderInfo& info = reader->reader.header();
+    IntanHeader h;
+    memset(&h, 0, sizeof(h));
+    h.fileType = info.fileType;
+    h.controllerType = info.controllerType;
+    h.dataFileMainVersionNumber = info.dataFileMainVersionNumber;
+    h.dataFileSecondaryVersionNumber = info.dataFileSecondaryVersionNumber;
+    h.dataFileFormat = reader->reader.format();
+    h.samplesPerDataBlock = info.samplesPerDataBlock;
+    h.sampleRateIndex = info.sampleRate;
+    h.sampleRate = reader->reader.sampleRate();
+    h.dspEnabled = info.dspEnabled;
+    h.actualDspCutoffFreq = info.actualDspCutoffFreq;
+    h.actualLowerBandwidth = info.actualLowerBandwidth;
+    h.actualLowerSettleBandwidth = info.actualLowerSettleBandwidth;
+    h.actualUpperBandwidth = info.actualUpperBandwidth;
+    h.desiredDspCutoffFreq = info.desiredDspCutoffFreq;
+    h.desiredLowerBandwidth = info.desiredLowerBandwidth;
+    h.desiredLowerSettleBandwidth = info.desiredLowerSettleBandwidth;
+    h.desiredUpperBandwidth = info.desiredUpperBandwidth;
+    h.notchFilterEnabled = info.notchFilterEnabled;
+    h.notchFilterFreq = info.notchFilterFreq;
+    h.desiredImpedanceTestFreq = info.desiredImpedanceTestFreq;
+    h.actualImpedanceTestFreq = info.actualImpedanceTestFreq;
+    h.ampSettleMode = info.ampSettleMode;
+    h.chargeRecoveryMode = info.chargeRecoveryMode;
+    h.stimDataPresent = info.stimDataPresent;
+    h.stimStepSize = info.stimStepSize;
+    h.chargeRecoveryCurrentLimit = info.chargeRecoveryCurrentLimit;
+    h.chargeRecoveryTargetVoltage = info.chargeRecoveryTargetVoltage;
+    h.note1 = info.note1.c_str();
+    h.note2 = info.note2.c_str();
+    h.note3 = info.note3.c_str();
+    h.dcAmplifierDataSaved = info.dcAmplifierDataSaved;
+    h.numTempSensors = info.numTempSensors;
+    h.boardMode = info.boardMode;
+    h.refChannelName = info.refChannelName.c_str();
+    h.numGroups = info.numGroups();
+    h.numDataStreams = info.numDataStreams;
+    h.numEnabledAmplifierChannels = reader->reader.numAmplifierChannels();
+    h.numEnabledAuxInputChannels = info.numEnabledAuxInputChannels;
+    h.numEnabledSupplyVoltageChannels = info.numEnabledSupplyVoltageChannels;
+    h.numEnabledBoardAdcChannels = info.numEnabledBoardAdcChannels;
+    h.numEnabledBoardDacChannels = info.numEnabledBoardDacChannels;
+    h.numEnabledDigitalInChannels = info.numEnabledDigitalInChannels;
+    h.numEnabledDigitalOutChannels = info.numEnabledDigitalOutChannels;
+    h.numSamples = reader->reader.numSamples();
+    h.firstTimestamp = reader->reader.firstTimestamp();
+    h.compressed = reader->reader.isCompressed();
+    copyStruct(h, header, size);
+    return INTAN_OK;
+}
+
+int intan_num_channels(const IntanReader* reader)
+{
+    return reader ? reader->reader.numAmplifierChannels() : fail("intan_num_channels: null argument");
+}
+
+int intan_get_channel(const IntanReader* reader, int index, IntanChannel* channel, size_t size)
+{
+    if (!reader || !channel)
+        return fail("intan_get_channel: null argument");
+    if (index < 0 || index >= reader->reader.numAmplifierChannels())
+        return fail("intan_get_channel: no such channel");
+    const HeaderFileChannel& c = reader->reader.amplifierChannels()[index];
+    IntanChannel ch;
+    memset(&ch, 0, sizeof(ch));
+    ch.nativeChannelName = c.nativeChannelName.c_str();
+    ch.customChannelName = c.customChannelName.c_str();
+    ch.groupName = reader->groupNames[index].c_str();
+    ch.nativeOrder = c.nativeOrder;
+    ch.customOrder = c.customOrder;
+    ch.signalType = c.signalType;
+    ch.chipChannel = c.chipChannel;
+    ch.commandStream = c.commandStream;
+    ch.boardStream = c.boardStream;
+    ch.spikeScopeTriggerMode = c.spikeScopeTriggerMode;
+    ch.spikeScopeVoltageThreshold = c.spikeScopeVoltageThreshold;
+    ch.spikeScopeTriggerChannel = c.spikeScopeTriggerChannel;
+    ch.spikeScopeTriggerPolarity = c.spikeScopeTriggerPolarity;
+    ch.impedanceMagnitude = c.impedanceMagnitude;
+    ch.impedancePhase = c.impedancePhase;
+    copyStruct(ch, channel, size);
+    return INTAN_OK;
+}
+
+// Gather the selected channels of n frames (nc words each) into out, at sample offset t0 of a
+// window of count samples.
+template <typename T>
+static void gather(const int16_t* frames, int64_t n, int nc, const int32_t* channels, int k, int32_t layout,
+                   int64_t t0, int64_t count, float scale, T* out)
+{
+    for (int64_t t = 0; t < n; t++)
+    {
+        const int16_t* frame = frames + t * nc;
+        if (layout == INTAN_PLANES)
+        {
+            for (int j = 0; j < k; j++)
+                out[j * count + t0 + t] = (T) (scale * frame[channels[j]]);
+        }
+        else
+        {
+            T* o = out + (t0 + t) * k;
+            for (int j = 0; j < k; j++)
+                o[j] = (T) (scale * frame[channels[j]]);
+        }
+    }
+}
+
+template <typename T>
+static int64_t readWindow(IntanReader* reader, int64_t firstSample, int64_t count, const int32_t* channels,
+                          int32_t numChannels, int32_t layout, float scale, T* out)
+{
+    if (!reader || !out)
+        return fail("intan_read: null argument");
+    const int nc = reader->reader.numAmplifierChannels();
+    if (!channels)
+    {
+        channels = reader->allChannels.data();
+        numChannels = nc;
+    }
+    for (int j = 0; j < numChannels; j++)
+    {
+        if (channels[j] < 0 || channels[j] >= nc)
+            return fail("intan_read: no such channel");
+    }
+    if (layout != INTAN_FRAMES && layout != INTAN_PLANES)
+        return fail("intan_read: unknown layout");
+    if (firstSample < 0)
+        return fail("intan_read: negative first sample");
+    const int64_t n = max<int64_t>(min(count, reader->reader.numSamples() - firstSample), 0);
+
+    try
+    {
+        if (reader->amplifierMap.data())
+        {
+            const int16_t* frames = (const int16_t *) reader->amplifierMap.data() + firstSample * nc;
+            gather(frames, n, nc, channels, numChannels, layout, 0, count, scale, out);
+            return n;
+        }
+        reader->frames.resize((size_t) ApiReadBlockSize * nc);
+        reader->reader.seek(firstSample);
+        for (int64_t done = 0; done < n; )
+        {
+            int m = reader->reader.readAmplifierData(reader->frames.data(), (int) min<int64_t>(n - done, ApiReadBlockSize));
+            if (m <= 0)
+                break;
+            gather(reader->frames.data(), m, nc, channels, numChannels, layout, done, count, scale, out);
+            done += m;
+        }
+        return n;
+    }
+    catch (std::exception &e)
+    {
+        return fail(e.what());
+    }
+}
+
+int64_t intan_read(IntanReader* reader, int64_t firstSample, int64_t count, const int32_t* channels,
+                   int32_t numChannels, int32_t layout, int16_t* out)
+{
+    return readWindow(reader, firstSample, count, channels, numChannels, layout, 1.0F, out);
+}
+
+int64_t intan_read_microvolts(IntanReader* reader, int64_t firstSample, int64_t count, const int32_t* channels,
+                              int32_t numChannels, int32_t layout, float* out)
+{
+    return readWindow(reader, firstSample, count, channels, numChannels, layout, (float) AmplifierMicroVoltsPerBit, out);
+}
+
+int64_t intan_read_timestamps(IntanReader* reader, int64_t firstSample, int64_t count, int32_t* out)
+{
+    if (!reader || !out)
+        return fail("intan_read_timestamps: null argument");
+    try
+    {
+        int64_t done = 0;
+        while (done < count)
+        {
+            int m = reader->reader.readTimestamps(firstSample + done, (int) min<int64_t>(count - done, 1 << 30), out + done);
+            if (m <= 0)
+                break;
+            done += m;
+        }
+        return done;
+    }
+    catch (std::exception &e)
+    {
+        return fail(e.what());
+    }
+}
+
+static DigitalLineReader& digitalReader(IntanReader* reader, int32_t outputs)
+{
+    unique_ptr<DigitalLineReader>& digital = reader->digital[outputs ? 1 : 0];
+    if (!digital)
+    {
+        unique_ptr<DigitalLineReader> d(new DigitalLineReader);
+        d->open(reader->headerFilename, outputs != 0);
+        digital = move(d);
+    }
+    return *digital;
+}
+
+int intan_digital_lines(IntanReader* reader, int32_t outputs, uint16_t* lines)
+{
+    if (!reader || !lines)
+        return fail("intan_digital_lines: null argument");
+    *lines = enabledDigitalLines(reader->reader.header(), outputs != 0);
+    return INTAN_OK;
+}
+
+int64_t intan_read_digital(IntanReader* reader, int32_t outputs, int64_t firstSample, int64_t count, uint8_t* out)
+{
+    if (!reader || !out)
+        return fail("intan_read_digital: null argument");
+    if (firstSample < 0)
+        return fail("intan_read_digital: negative first sample");
+    try
+    {
+        return digitalReader(reader, outputs).read(firstSample, count, out, count);
+    }
+    catch (std::exception &e)
+    {
+        return fail(e.what());
+    }
+}
+
+static BoardAnalogReader& analogReader(IntanReader* reader, int32_t outputs)
+{
+    unique_ptr<BoardAnalogReader>& analog = reader->analog[outputs ? 1 : 0];
+    if (!analog)
+    {
+        unique_ptr<BoardAnalogReader> a(new BoardAnalogReader);
+        a->open(reader->headerFilename, outputs ? BoardDacSignal : BoardAdcSignal);
+        analog = move(a);
+    }
+    return *analog;
+}
+
+int intan_num_analog_channels(IntanReader* reader, int32_t outputs)
+{
+    if (!reader)
+        return fail("intan_num_analog_channels: null argument");
+    try
+    {
+        return analogReader(reader, outputs).numChannels();
+    }
+    catch (std::exception &e)
+    {
+        return fail(e.what());
+    }
+}
+
+int64_t intan_read_analog(IntanReader* reader, int32_t outputs, int64_t firstSample, int64_t count, float* out)
+{
+    if (!reader || !out)
+        return fail("intan_read_analog: null argument");
+    if (firstSample < 0)
+        return fail("intan_read_analog: negative first sample");
+    try
+    {
+        return analogReader(reader, outputs).read(firstSample, count, out);
+    }
+    catch (std::exception &e)
+    {
+        return fail(e.what());
+    }
+}
+
+int intan_amplifier_view(IntanReader* reader, IntanView* view, size_t size)
+{
+    if (!reader || !view)
+        return fail("intan_amplifier_view: null argument");
+    if (!reader->amplifierMap.data())
+    {
+        lastError = "intan_amplifier_view: the amplifier data cannot be mapped";
+        return INTAN_NO_VIEW;
+    }
+    IntanView v;
+    memset(&v, 0, sizeof(v));
+    v.data = (const int16_t *) reader->amplifierMap.data();
+    v.numSamples = reader->reader.numSamples();
+    v.numChannels = reader->reader.numAmplifierChannels();
+    v.sampleStride = v.numChannels;
+    v.channelStride = 1;
+    copyStruct(v, view, size);
+    return INTAN_OK;
+}
+
+int intan_timestamp_view(IntanReader* reader, const int32_t** timestamps, int64_t* numSamples)
+{
+    if (!reader || !timestamps || !numSamples)
+        return fail("intan_timestamp_view: null argument");
+    if (!reader->timeMap.data())
+    {
+        lastError = "intan_timestamp_view: there is no time.dat to map";
+        return INTAN_NO_VIEW;
+    }
+    *timestamps = (const int32_t *) reader->timeMap.data();
+    *numSamples = reader->reader.numSamples();
+    return INTAN_OK;
+}
@@ -0,0 +1,178 @@
+/*
+ * cnsapi.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSAPI_H_
+#define RHX_CNSAPI_H_
+
+// C interface to the headless reader, for Python (ctypes, cffi), MATLAB (loadlibrary), Julia (ccall)
+// and other languages. Built as the intanreader shared library (see CMakeLists.txt).
+//
+// Structs are filled through a size argument (pass sizeof the struct as compiled against), so fields
+// can be added at the end without breaking callers built against an older header. Strings and views
+// returned are owned by the reader and valid until intan_close(). Functions return INTAN_OK (0) or a
+// negative status; intan_last_error() describes the last failure on the calling thread. One reader
+// must not be used from two threads at once.
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(_WIN32) && defined(INTAN_API_EXPORTS)
+#define INTAN_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define INTAN_API __attribute__((visibility("default")))
+#else
+#define INTAN_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define INTAN_API_VERSION 3
+
+#define INTAN_OK 0
+#define INTAN_ERROR (-1)
+#define INTAN_NO_VIEW (-2)          // the data cannot be borrowed in place (compressed, or not mapped)
+
+// Sample orders for intan_read(): frames (channel index varying fastest, as in amplifier.dat) or
+// planes (one run of samples per channel).
+#define INTAN_FRAMES 0
+#define INTAN_PLANES 1
+
+typedef struct IntanReader IntanReader;
+
+// Mirrors IntanHeaderInfo (cnsrhx.h). Enumerations are given as their integer values.
+typedef struct IntanHeader
+{
+    int32_t fileType;                       // 0 = RHD, 1 = RHS
+    int32_t controllerType;
+    int32_t dataFileMainVersionNumber;
+    int32_t dataFileSecondaryVersionNumber;
+    int32_t dataFileFormat;                 // 0 = traditional, 1 = one file per signal type, 2 = one file per channel
+    int32_t samplesPerDataBlock;
+    int32_t sampleRateIndex;                // AmplifierSampleRate
+    double sampleRate;                      // Hz
+    int32_t dspEnabled;
+    double actualDspCutoffFreq;
+    double actualLowerBandwidth;
+    double actualLowerSettleBandwidth;
+    double actualUpperBandwidth;
+    double desiredDspCutoffFreq;
+    double desiredLowerBandwidth;
+    double desiredLowerSettleBandwidth;
+    double desiredUpperBandwidth;
+    int32_t notchFilterEnabled;
+    double notchFilterFreq;
+    double desiredImpedanceTestFreq;
+    double actualImpedanceTestFreq;
+    int32_t ampSettleMode;
+    int32_t chargeRecoveryMode;
+    int32_t stimDataPresent;
+    int32_t stimStepSize;
+    double chargeRecoveryCurrentLimit;
+    double chargeRecoveryTargetVoltage;
+    const char* note1;
+    const char* note2;
+    const char* note3;
+    int32_t dcAmplifierDataSaved;
+    int32_t numTempSensors;
+    int32_t boardMode;
+    const char* refChannelName;
+    int32_t numGroups;
+    int32_t numDataStreams;
+    int32_t numEnabledAmplifierChannels;
+    int32_t numEnabledAuxInputChannels;
+    int32_t numEnabledSupplyVoltageChannels;
+    int32_t numEnabledBoardAdcChannels;
+    int32_t numEnabledBoardDacChannels;
+    int32_t numEnabledDigitalInChannels;
+    int32_t numEnabledDigitalOutChannels;
+    int64_t numSamples;                     // amplifier samples (frames) in the data files
+    int64_t firstTimestamp;
+    int32_t compressed;                     // 1 if amplifier data is read from a compressed file
+} IntanHeader;
+
+// Mirrors HeaderFileChannel, for the channels intan_read() returns.
+typedef struct IntanChannel
+{
+    const char* nativeChannelName;
+    const char* customChannelName;
+    const char* groupName;
+    int32_t nativeOrder;
+    int32_t customOrder;
+    int32_t signalType;
+    int32_t chipChannel;
+    int32_t commandStream;
+    int32_t boardStream;
+    int32_t spikeScopeTriggerMode;
+    int32_t spikeScopeVoltageThreshold;
+    int32_t spikeScopeTriggerChannel;
+    int32_t spikeScopeTriggerPolarity;
+    double impedanceMagnitude;
+    double impedancePhase;
+} IntanChannel;
+
+// Amplifier data borrowed in place: the word for sample s of channel c is
+// data[s * sampleStride + c * channelStride] (strides in words; 0.195 uV/bit).
+typedef struct IntanView
+{
+    const int16_t* data;
+    int64_t numSamples;
+    int32_t numChannels;
+    int64_t sampleStride;
+    int64_t channelStride;
+} IntanView;
+
+INTAN_API int intan_api_version(void);
+INTAN_API const char* intan_last_error(void);
+
+// Open the recording whose header file (info.rhd or info.rhs) is headerFilename.
+INTAN_API int intan_open(const char* headerFilename, IntanReader** reader);
+INTAN_API void intan_close(IntanReader* reader);
+
+INTAN_API int intan_get_header(const IntanReader* reader, IntanHeader* header, size_t size);
+
+// Amplifier channels, in the order they are stored; index is the channel number used by intan_read().
+INTAN_API int intan_num_channels(const IntanReader* reader);
+INTAN_API int intan_get_channel(const IntanReader* reader, int index, IntanChannel* channel, size_t size);
+
+// Read count samples from firstSample on, of numChannels channels (channel numbers in channels, or all
+// channels in order if channels is NULL), into out: count * numChannels values in the order given by
+// layout (INTAN_FRAMES or INTAN_PLANES). The window is clipped to the data; returns the number of
+// samples read, or a negative status. intan_read_microvolts() scales to uV.
+INTAN_API int64_t intan_read(IntanReader* reader, int64_t firstSample, int64_t count, const int32_t* channels,
+                             int32_t numChannels, int32_t layout, int16_t* out);
+INTAN_API int64_t intan_read_microvolts(IntanReader* reader, int64_t firstSample, int64_t count, const int32_t* channels,
+                                        int32_t numChannels, int32_t layout, float* out);
+
+// Read the timestamps of count samples from firstSample on. Returns the number read, or a negative status.
+INTAN_API int64_t intan_read_timestamps(IntanReader* reader, int64_t firstSample, int64_t count, int32_t* out);
+
+// Board digital inputs, or outputs if outputs is nonzero. intan_digital_lines() gives the lines enabled
+// in the header as a bit mask (bit k for line k). intan_read_digital() reads count samples from
+// firstSample on of every enabled line, as one run of count 0/1 values per line, in line order (so
+// count * number of lines values). Returns the number of samples read, or a negative status.
+INTAN_API int intan_digital_lines(IntanReader* reader, int32_t outputs, uint16_t* lines);
+INTAN_API int64_t intan_read_digital(IntanReader* reader, int32_t outputs, int64_t firstSample, int64_t count, uint8_t* out);
+
+// Board analog inputs (ADCs), or outputs (DACs) if outputs is nonzero, in volts, scaled for the header's
+// controller type. intan_read_analog() reads count samples from firstSample on of all
+// intan_num_analog_channels() channels, as frames (channel index varying fastest). Returns the number of
+// samples read, or a negative status.
+INTAN_API int intan_num_analog_channels(IntanReader* reader, int32_t outputs);
+INTAN_API int64_t intan_read_analog(IntanReader* reader, int32_t outputs, int64_t firstSample, int64_t count, float* out);
+
+// Borrow the amplifier data (or time.dat timestamps) in place, memory-mapped. Returns INTAN_NO_VIEW
+// if the layout does not allow it, e.g. for compressed files.
+INTAN_API int intan_amplifier_view(IntanReader* reader, IntanView* view, size_t size);
+INTAN_API int intan_timestamp_view(IntanReader* reader, const int32_t** timestamps, int64_t* numSamples);
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif /* RHX_CNSAPI_H_ */
@@ -0,0 +1,373 @@
+/*
+ * cnsbatch.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <fstream>
+#include <exception>
+#include <stdexcept>
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include "cnschunked.h"
+#include "cnscodec.h"
+#include "cnszstd.h"
+#include "cnstranscode.h"
+#include "cnsbatch.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define HAVE_PREAD
+#endif
+using namespace std;
+
+
+// Reads at an offset, from any number of threads at once: pread() where there is one, otherwise a
+// stream shared under a lock.
+class BatchWindowReader::PositionalFile
+{
+public:
+    explicit PositionalFile(const string& filename)
+    : m_filename(filename)
+    {
+#ifdef HAVE_PREAD
+        m_fd = ::open(filename.c_str(), O_RDONLY);
+        if (m_fd < 0)
+#else
+        m_file.open(filename, ios::in | ios::binary);
+        if (!m_file)
+#endif
+            throw std::runtime_error("Batch Error: cannot open " + filename);
+    }
+
+    ~PositionalFile()
+    {
+#ifdef HAVE_PREAD
+        ::close(m_fd);
+#endif
+    }
+
+    void read(int64_t offset, int64_t bytes, void* out)
+    {
+#ifdef HAVE_PREAD
+        for (int64_t done = 0; done < bytes; )
+        {
+            ssize_t n = pread(m_fd, (char *) out + done, (size_t) (bytes - done), (off_t) (offset + done));
+            if (n <= 0)
+                throw std::runtime_error("Batch Error: cannot read " + m_filename);
+            done += n;
+        }
+#else
+        lock_guard<mutex> lock(m_mutex);
+        m_file.clear();
+        m_file.seekg(offset, ios::beg);
+        if (!m_file.read((char *) out, (streamsize) bytes))
+            throw std::runtime_error("Batch Error: cannot read " + m_filename);
+#endif
+    }
+
+private:
+    string m_filename;
+#ifdef HAVE_PREAD
+    int m_fd;
+#else
+    ifstream m_file;
+    mutex m_mutex;
+#endif
+};
+
+namespace {
+
+// Where a span's samples go: a column (channel list entry) of a window, or all of its columns.
+struct SpanTarget
+{
+    int window;
+    int column;                     // -1: every column, from frames
+};
+
+// Samples [start, end) of one file, and the windows they are read for.
+struct Span
+{
+    int file;
+    int64_t start;
+    int64_t end;
+    vector<SpanTarget> targets;
+};
+
+struct WindowRange
+{
+    int64_t first;                  // clipped to the recording
+    int64_t last;
+    int numColumns;
+    vector<int> columns;            // with a channel mask: the columns whose channel is not masked
+};
+
+}
+
+
+BatchWindowReader::BatchWindowReader()
+: m_format(FilePerSignalTypeFormat)
+, m_numSamples(0)
+, m_numThreads(1)
+{
+}
+
+BatchWindowReader::~BatchWindowReader()
+{
+    close();
+}
+
+void BatchWindowReader::open(const string& headerFilename, int numThreads)
+{
+    close();
+    m_numThreads = ChunkedFileReader::numThreadsToUse(numThreads);
+
+    if (isTraditionalIntanFile(headerFilename))
+    {
+        m_format = TraditionalIntanFormat;
+        m_traditional.open(headerFilename);
+        m_info = m_traditional.info();
+        m_numSamples = m_traditional.numSamples();
+    }
+    else
+        readIntanHeader(headerFilename.c_str(), m_info);
+    m_channels = enabledAmplifierChannels(m_info);
+    for (int c = 0; c < numAmplifierChannels(); c++)
+        m_allChannels.push_back(c);
+
+    filesystem::path directory = filesystem::path(headerFilename).parent_path();
+    filesystem::path amplifierPath = directory / "amplifier.dat";
+    if (m_format == TraditionalIntanFormat)
+    {
+        if (m_traditional.layout().numAmplifierChannels != numAmplifierChannels())
+            throw std::runtime_error("Batch Error: the data blocks of " + headerFilename + " do not match its amplifier channels");
+    }
+    else if (filesystem::exists(amplifierPath))
+    {
+        m_format = FilePerSignalTypeFormat;
+        m_files.emplace_back(new PositionalFile(amplifierPath.string()));
+        int64_t bytesPerFrame = BytesPerWord * (int64_t) numAmplifierChannels();
+        m_numSamples = (bytesPerFrame > 0) ? (int64_t) filesystem::file_size(amplifierPath) / bytesPerFrame : 0;
+    }
+    else if (filesystem::exists(directory / ("amplifier.dat" + string(CompressedFileExtension))) ||
+             filesystem::exists(directory / ("amplifier.dat" + string(ZstdFileExtension))))
+    {
+        m_format = FilePerSignalTypeFormat;
+        m_reader.open(headerFilename);
+        m_numSamples = m_reader.numSamples();
+    }
+    else if (!m_channels.empty() && filesystem::exists(directory / perChannelFilename(m_channels[0])))
+    {
+        // The channel files can differ in length if a recording was cut short; use the shortest.
+        m_format = FilePerChannelFormat;
+        m_numSamples = -1;
+        for (const HeaderFileChannel& channel : m_channels)
+        {
+            filesystem::path path = directory / perChannelFilename(channel);
+            m_files.emplace_back(new PositionalFile(path.string()));
+            int64_t n = (int64_t) filesystem::file_size(path) / BytesPerWord;
+            m_numSamples = (m_numSamples < 0) ? n : min(m_numSamples, n);
+        }
+    }
+    else
+        throw std::runtime_error("Batch Error: cannot find the amplifier data next to " + headerFilename);
+}
+
+void BatchWindowReader::close()
+{
+    m_format = FilePerSignalTypeFormat;
+    m_reader.close();
+    m_traditional.close();
+    m_files.clear();
+    m_channels.clear();
+    m_allChannels.clear();
+    m_mask.clear();
+    m_numSamples = 0;
+}
+
+void BatchWindowReader::setChannelMask(const vector<bool>& mask)
+{
+    if (!mask.empty() && mask.size() != m_channels.size())
+        throw std::runtime_error("Batch Error: channel mask does not match the channels");
+    m_mask.clear();
+    if (find(mask.begin(), mask.end(), true) != mask.end())
+        m_mask = mask;
+}
+
+void BatchWindowReader::read(const vector<BatchWindow>& windows, vector<int16_t>& out, vector<int64_t>& offsets)
+{
+    const int nc = numAmplifierChannels();
+    const bool perChannel = (m_format == FilePerChannelFormat);
+    const int64_t bytesPerSample = BytesPerWord * (perChannel ? 1 : (int64_t) nc);
+
+    // Lay the results out in caller order, all zero to start with.
+    vector<WindowRange> ranges(windows.size());
+    offsets.assign(windows.size(), 0);
+    int64_t total = 0;
+    for (size_t i = 0; i < windows.size(); i++)
+    {
+        const BatchWindow& w = windows[i];
+        if (w.length < 0)
+            throw std::runtime_error("Batch Error: negative window length");
+        for (int c : w.channels)
+        {
+            if (c < 0 || c >= nc)
+                throw std::runtime_error("Batch Error: no such channel");
+        }
+        ranges[i].first = max<int64_t>(w.start, 0);
+        ranges[i].last = min(w.start + w.length, m_numSamples);
+        ranges[i].numColumns = w.channels.empty() ? nc : (int) w.channels.size();
+        if (!m_mask.empty())
+        {
+            for (int j = 0; j < ranges[i].numColumns; j++)
+            {
+                if (!m_mask[w.channels.empty() ? j : w.channels[j]])
+                    ranges[i].columns.push_back(j);
+            }
+            if (ranges[i].columns.empty())
+                ranges[i].last = ranges[i].first;
+        }
+        offsets[i] = total;
+        total += w.length * ranges[i].numColumns;
+    }
+    out.assign((size_t) total, 0);
+
+    // Sort each file's reads by offset and coalesce them into spans.
+    vector<vector<SpanTarget>> fileTargets(perChannel ? nc : 1);
+    for (size_t i = 0; i < windows.size(); i++)
+    {
+        if (ranges[i].first >= ranges[i].last)
+            continue;
+        if (!perChannel)
+            fileTargets[0].push_back({ (int) i, -1 });
+        else
+        {
+            for (int j = 0; j < ranges[i].numColumns; j++)
+            {
+                int c = windows[i].channels.empty() ? j : windows[i].channels[j];
+                if (m_mask.empty() || !m_mask[c])
+                    fileTargets[c].push_back({ (int) i, j });
+            }
+        }
+    }
+    vector<Span> spans;
+    for (int file = 0; file < (int) fileTargets.size(); file++)
+    {
+        vector<SpanTarget>& targets = fileTargets[file];
+        stable_sort(targets.begin(), targets.end(),
+                    [&ranges](const SpanTarget& a, const SpanTarget& b) { return ranges[a.window].first < ranges[b.window].first; });
+        for (const SpanTarget& target : targets)
+        {
+            const WindowRange& r = ranges[target.window];
+            if (!spans.empty() && spans.back().file == file && (r.first - spans.back().end) * bytesPerSample <= BatchCoalesceGapBytes &&
+                (max(spans.back().end, r.last) - spans.back().start) * bytesPerSample <= BatchMaxSpanBytes)
+            {
+                spans.back().end = max(spans.back().end, r.last);
+                spans.back().targets.push_back(target);
+            }
+            else
+                spans.push_back({ file, r.first, r.last, vector<SpanTarget>(1, target) });
+        }
+    }
+
+    // Copy a span's samples (frames of nc words, or one channel) to the windows it was read for.
+    auto scatter = [&](const Span& span, const int16_t* data)
+    {
+        for (const SpanTarget& target : span.targets)
+        {
+            const BatchWindow& w = windows[target.window];
+            const WindowRange& r = ranges[target.window];
+            const int k = r.numColumns;
+            const int* channels = w.channels.empty() ? m_allChannels.data() : w.channels.data();
+            int16_t* o = out.data() + offsets[target.window] + (r.first - w.start) * k;
+            const int16_t* in = data + (r.first - span.start) * (perChannel ? 1 : nc);
+            const int64_t n = r.last - r.first;
+            if (perChannel)
+            {
+                for (int64_t t = 0; t < n; t++)
+                    o[t * k + target.column] = in[t];
+            }
+            else if (!m_mask.empty())
+            {
+                for (int64_t t = 0; t < n; t++, in += nc, o += k)
+                {
+                    for (int j : r.columns)
+                        o[j] = in[channels[j]];
+                }
+            }
+            else if (k == nc && channels == m_allChannels.data())
+                copy(in, in + n * nc, o);
+            else
+            {
+                for (int64_t t = 0; t < n; t++, in += nc, o += k)
+                {
+                    for (int j = 0; j < k; j++)
+                        o[j] = in[channels[j]];
+                }
+            }
+        }
+    };
+
+    if (m_files.empty())
+    {
+        // Compressed or traditional: in file order through the reader.
+        vector<int16_t> buffer;
+        TraditionalSamples samples;
+        for (const Span& span : spans)
+        {
+            const int64_t n = span.end - span.start;
+            buffer.resize((size_t) (n * nc));
+            int64_t numRead;
+            if (m_format == TraditionalIntanFormat)
+            {
+                samples.amplifier = buffer.data();
+                numRead = m_traditional.read(span.start, n, samples);
+            }
+            else
+            {
+                m_reader.seek(span.start);
+                numRead = m_reader.readAmplifierData(buffer.data(), (int) n);
+            }
+            if (numRead != n)
+                throw std::runtime_error("Batch Error: cannot read amplifier data");
+            scatter(span, buffer.data());
+        }
+        return;
+    }
+
+    // The spans are shared out over the threads, which write to disjoint words of out.
+    atomic<size_t> next(0);
+    mutex errorMutex;
+    string error;
+    auto work = [&]()
+    {
+        vector<int16_t> buffer;
+        try
+        {
+            for (size_t s = next++; s < spans.size(); s = next++)
+            {
+                const Span& span = spans[s];
+                buffer.resize((size_t) ((span.end - span.start) * bytesPerSample / BytesPerWord));
+                m_files[span.file]->read(span.start * bytesPerSample, (span.end - span.start) * bytesPerSample, buffer.data());
+                scatter(span, buffer.data());
+            }
+        }
+        catch (std::exception &e)
+        {
+            lock_guard<mutex> lock(errorMutex);
+            error = e.what();
+            next = spans.size();
+        }
+    };
+    vector<thread> threads;
+    for (int t = 1; t < min<int>(m_numThreads, (int) spans.size()); t++)
+        threads.emplace_back(work);
+    work();
+    for (thread& t : threads)
+        t.join();
+    if (!error.empty())
+        throw std::runtime_error(error);
+}
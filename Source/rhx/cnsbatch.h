@@ -0,0 +1,83 @@
+/*
+ * cnsbatch.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSBATCH_H_
+#define RHX_CNSBATCH_H_
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include "cnsrhx.h"
+#include "cnsreader.h"
+#include "cnstraditional.h"
+
+// Windows closer than this in a file are read as one span, the gap read and thrown away.
+const int64_t BatchCoalesceGapBytes = (int64_t) 256 << 10;
+
+// Windows are not coalesced into spans larger than this (a single longer window is read whole).
+const int64_t BatchMaxSpanBytes = (int64_t) 8 << 20;
+
+// One window of a batch read: length samples from start on, of the amplifier channels listed (indices
+// into the reader's channel table, any order, repeats allowed; empty for all channels).
+struct BatchWindow
+{
+    int64_t start;
+    int64_t length;
+    std::vector<int> channels;
+};
+
+// Random access to many short windows of amplifier data at once, e.g. around thousands of TTL edges.
+// The windows of a batch are sorted by file offset and coalesced into spans (per channel file in the
+// "one file per channel" format), and the spans are read by numThreads threads with positional reads,
+// so the I/O for the whole batch is in flight together rather than one seek at a time. Compressed files
+// are read span by span in file order, which lets their decoder work ahead, and so are traditional
+// files, whose spans are decoded block range by block range.
+class BatchWindowReader
+{
+public:
+    BatchWindowReader();
+    ~BatchWindowReader();
+
+    // Open the recording of headerFilename, in the one file per signal type format (amplifier.dat, or a
+    // compressed copy), the one file per channel format (amp-A-000.dat, ...) or the traditional format
+    // (headerFilename holds the data blocks). Will throw() on fail.
+    void open(const std::string& headerFilename, int numThreads = 0);
+    void close();
+
+    DataFileFormat format() const { return m_format; }
+    const IntanHeaderInfo& header() const { return m_info; }
+    const std::vector<HeaderFileChannel>& amplifierChannels() const { return m_channels; }
+    int numAmplifierChannels() const { return (int) m_channels.size(); }
+    int64_t numSamples() const { return m_numSamples; }
+
+    // Amplifier channels to leave out (one entry per channel; see cnsmask.h), until the next open().
+    // Masked channels read as 0, and are not read at all in the one file per channel format; in the
+    // other formats, a window that lists only masked channels is not read.
+    void setChannelMask(const std::vector<bool>& mask);
+
+    // Read every window, in the order given: window i is written to out from offsets[i] on, as frames of
+    // its channels (channel varying fastest, in the order listed). Samples outside the recording read as
+    // 0. Will throw() on fail.
+    void read(const std::vector<BatchWindow>& windows, std::vector<int16_t>& out, std::vector<int64_t>& offsets);
+
+private:
+    class PositionalFile;
+
+    IntanHeaderInfo m_info;
+    DataFileFormat m_format;
+    std::vector<HeaderFileChannel> m_channels;
+    int64_t m_numSamples;
+    int m_numThreads;
+    std::vector<int> m_allChannels;
+    std::vector<bool> m_mask;                               // empty: no channel masked
+    IntanDataReader m_reader;                               // compressed data
+    TraditionalIntanReader m_traditional;                   // traditional file
+    std::vector<std::unique_ptr<PositionalFile>> m_files;   // amplifier.dat, or one per channel
+};
+
+
+#endif /* RHX_CNSBATCH_H_ */
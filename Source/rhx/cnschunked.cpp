@@ -0,0 +1,190 @@
+/*
+ * cnschunked.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <exception>
+#include <algorithm>
+#include <cstring>
+#include "cnschunked.h"
+using namespace std;
+
+
+ChunkedFileReader::ChunkedFileReader()
+: m_stopping(false)
+, m_useCount(0)
+{
+}
+
+ChunkedFileReader::~ChunkedFileReader()
+{
+    close();
+}
+
+int ChunkedFileReader::numThreadsToUse(int numThreads)
+{
+    return max(1, (numThreads > 0) ? numThreads : (int) thread::hardware_concurrency());
+}
+
+void ChunkedFileReader::start(const vector<int64_t>& starts, int numThreads)
+{
+    close();
+
+    m_starts = starts;
+
+    // A chunk being copied out, numWorkers being decoded, and as many decoded ahead. Slot buffers
+    // grow as chunks are decoded into them, so a file of one huge chunk only needs one.
+    int numWorkers = numThreadsToUse(numThreads);
+    m_slots = vector<Slot>(2 * numWorkers + 1);
+    m_queue.clear();
+    m_stopping = false;
+    m_error.clear();
+    for (int w = 0; w < numWorkers; w++)
+        m_workers.emplace_back(&ChunkedFileReader::workerLoop, this, w);
+}
+
+void ChunkedFileReader::close()
+{
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_changed.notify_all();
+    for (thread& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+    m_slots.clear();
+    m_queue.clear();
+    m_starts.clear();
+}
+
+int ChunkedFileReader::findSlot(int64_t chunk) const
+{
+    for (size_t i = 0; i < m_slots.size(); i++)
+    {
+        if (m_slots[i].chunk == chunk && m_slots[i].state != EmptySlot)
+            return (int) i;
+    }
+    return -1;
+}
+
+// Queue chunk for decoding, if it is not cached or queued already. The slot reused is the least
+// recently used one that is not busy and does not hold a chunk in keepFirst .. keepLast. (Chunks
+// still queued from an earlier position may be dropped.) Called with m_mutex held.
+void ChunkedFileReader::schedule(int64_t chunk, int64_t keepFirst, int64_t keepLast)
+{
+    if (chunk < 0 || chunk >= numChunks() || findSlot(chunk) >= 0)
+        return;
+
+    int victim = -1;
+    for (size_t i = 0; i < m_slots.size(); i++)
+    {
+        const Slot& slot = m_slots[i];
+        if (slot.state == DecodingSlot || (slot.state != EmptySlot && slot.chunk >= keepFirst && slot.chunk <= keepLast))
+            continue;
+        if (victim < 0 || slot.state == EmptySlot ||
+            (m_slots[victim].state != EmptySlot && slot.lastUse < m_slots[victim].lastUse))
+            victim = (int) i;
+    }
+    if (victim < 0)
+        return;
+
+    Slot& slot = m_slots[victim];
+    if (slot.state == QueuedSlot)
+        m_queue.erase(find(m_queue.begin(), m_queue.end(), victim));
+    slot.chunk = chunk;
+    slot.state = QueuedSlot;
+    slot.lastUse = ++m_useCount;
+    m_queue.push_back(victim);
+    m_changed.notify_all();
+}
+
+// Wait until chunk is decoded, scheduling it if needed.
+const ChunkedFileReader::Slot& ChunkedFileReader::waitFor(unique_lock<mutex>& lock, int64_t chunk, int64_t keepLast)
+{
+    while (true)
+    {
+        int i = findSlot(chunk);
+        if (i < 0)
+        {
+            schedule(chunk, chunk, keepLast);
+            i = findSlot(chunk);
+        }
+        if (i >= 0 && m_slots[i].state == ReadySlot)
+        {
+            m_slots[i].lastUse = ++m_useCount;
+            return m_slots[i];
+        }
+        if (i >= 0 && m_slots[i].state == FailedSlot)
+        {
+            m_slots[i].state = EmptySlot;
+            throw std::runtime_error(m_error);
+        }
+        m_changed.wait(lock);
+    }
+}
+
+int64_t ChunkedFileReader::read(int64_t offset, int64_t bytes, void* out)
+{
+    int64_t n = min(bytes, size() - offset);
+    if (n <= 0 || offset < 0 || !isOpen())
+        return 0;
+
+    const int64_t ahead = (int64_t) m_workers.size();
+    int64_t chunk = (int64_t) (upper_bound(m_starts.begin(), m_starts.end(), offset) - m_starts.begin()) - 1;
+    int64_t done = 0;
+    while (done < n)
+    {
+        const Slot* slot;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            for (int64_t c = chunk; c <= chunk + ahead; c++)
+                schedule(c, chunk, chunk + ahead);
+            slot = &waitFor(lock, chunk, chunk + ahead);
+        }
+
+        // Only this thread reuses slots, so a ready slot can be copied out without the lock.
+        const int64_t position = offset + done - m_starts[chunk];
+        const int64_t count = min(n - done, chunkSize(chunk) - position);
+        memcpy((uint8_t *) out + done, slot->data.data() + position, (size_t) count);
+        done += count;
+        chunk++;
+    }
+    return n;
+}
+
+void ChunkedFileReader::workerLoop(int worker)
+{
+    unique_lock<mutex> lock(m_mutex);
+    while (true)
+    {
+        m_changed.wait(lock, [this]() { return m_stopping || !m_queue.empty(); });
+        if (m_stopping)
+            return;
+        const int i = m_queue.front();
+        m_queue.erase(m_queue.begin());
+        Slot& slot = m_slots[i];
+        slot.state = DecodingSlot;
+        const int64_t chunk = slot.chunk;
+        lock.unlock();
+
+        string error;
+        try
+        {
+            if ((int64_t) slot.data.size() < chunkSize(chunk))
+                slot.data.resize((size_t) chunkSize(chunk));
+            decode(worker, chunk, slot.data.data());
+        }
+        catch (std::exception &e)
+        {
+            error = e.what();
+        }
+
+        lock.lock();
+        slot.state = error.empty() ? ReadySlot : FailedSlot;
+        if (!error.empty())
+            m_error = error;
+        m_changed.notify_all();
+    }
+}
@@ -0,0 +1,80 @@
+/*
+ * cnschunked.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSCHUNKED_H_
+#define RHX_CNSCHUNKED_H_
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+
+// Random access to a file stored as chunks that decode independently (compressed data files,
+// zstd frames). Chunks are decoded by a pool of worker threads into a small cache: a read schedules
+// every chunk it covers and as many chunks after it as there are workers, so the chunks of a long
+// read are decoded in parallel, and sequential reads find the next chunks already decoded.
+// Reads are not thread safe; only the decoding is spread over threads.
+class ChunkedFileReader
+{
+public:
+    ChunkedFileReader();
+    virtual ~ChunkedFileReader();
+
+    void close();
+    bool isOpen() const { return !m_workers.empty(); }
+
+    // Decoded size in bytes.
+    int64_t size() const { return m_starts.empty() ? 0 : m_starts.back(); }
+
+    // Read bytes decoded bytes from offset on. Returns the number read. Will throw() on fail.
+    int64_t read(int64_t offset, int64_t bytes, void* out);
+
+    // numThreads, or one per hardware thread if 0.
+    static int numThreadsToUse(int numThreads);
+
+protected:
+    // Start the workers, given the decoded offset of each chunk and the decoded size (numChunks + 1
+    // offsets). Derived classes set up the state each worker needs first.
+    void start(const std::vector<int64_t>& starts, int numThreads);
+
+    int64_t numChunks() const { return (int64_t) m_starts.size() - 1; }
+    int64_t chunkSize(int64_t chunk) const { return m_starts[chunk + 1] - m_starts[chunk]; }
+
+    // Decode chunk into out (chunkSize(chunk) bytes), on worker thread number worker. May throw().
+    // Derived classes must close() in their destructor, so no worker calls this during destruction.
+    virtual void decode(int worker, int64_t chunk, uint8_t* out) = 0;
+
+private:
+    enum SlotState { EmptySlot, QueuedSlot, DecodingSlot, ReadySlot, FailedSlot };
+
+    struct Slot
+    {
+        int64_t chunk = -1;
+        SlotState state = EmptySlot;
+        uint64_t lastUse = 0;
+        std::vector<uint8_t> data;
+    };
+
+    std::vector<int64_t> m_starts;
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::vector<Slot> m_slots;
+    std::vector<int> m_queue;           // slots to decode, oldest first
+    bool m_stopping;
+    uint64_t m_useCount;
+    std::string m_error;
+
+    int findSlot(int64_t chunk) const;
+    void schedule(int64_t chunk, int64_t keepFirst, int64_t keepLast);
+    const Slot& waitFor(std::unique_lock<std::mutex>& lock, int64_t chunk, int64_t keepLast);
+    void workerLoop(int worker);
+};
+
+
+#endif /* RHX_CNSCHUNKED_H_ */
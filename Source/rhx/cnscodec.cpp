@@ -0,0 +1,366 @@
+/*
+ * cnscodec.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <exception>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include "cnstranscode.h"
+#include "cnscodec.h"
+using namespace std;
+
+
+static const uint32_t CompressedFileMagicNumber = 0x2a6b17c5;
+static const uint32_t CompressedFileVersionNumber = 1;
+
+// Residuals of 16-bit samples under second-order prediction need up to 18 bits when zigzag coded.
+static const int MaxResidualBits = 18;
+
+enum Predictor {
+    DeltaPredictor = 0,                 // x[i - 1]
+    LinearPredictor = 1                 // 2 x[i - 1] - x[i - 2]
+};
+
+struct CompressedFileHeader
+{
+    uint32_t magicNumber;
+    uint32_t versionNumber;
+    int32_t numChannels;
+    int32_t chunkSize;
+    int64_t numSamples;
+    int64_t numChunks;
+    int64_t indexOffset;                // numChunks + 1 chunk offsets, the last one the end of the chunks
+};
+
+static inline uint32_t zigzag(int32_t r) { return ((uint32_t) r << 1) ^ (uint32_t) (r >> 31); }
+static inline int32_t unzigzag(uint32_t u) { return (int32_t) (u >> 1) ^ -(int32_t) (u & 1); }
+
+static void encodeChannel(const int16_t* x, int n, vector<int32_t>& residuals, vector<uint8_t>& out)
+{
+    out.push_back((uint8_t) ((uint16_t) x[0] & 0xff));
+    out.push_back((uint8_t) ((uint16_t) x[0] >> 8));
+    if (n < 2)
+        return;
+
+    // Pick the predictor with the smaller sum of absolute residuals.
+    int64_t deltaSum = 0;
+    int64_t linearSum = 0;
+    for (int i = 2; i < n; i++)
+    {
+        int32_t d = x[i] - x[i - 1];
+        int32_t l = d - (x[i - 1] - x[i - 2]);
+        deltaSum += abs(d);
+        linearSum += abs(l);
+    }
+    Predictor predictor = (linearSum < deltaSum) ? LinearPredictor : DeltaPredictor;
+    out.push_back((uint8_t) predictor);
+
+    residuals.resize(n);
+    residuals[1] = x[1] - x[0];
+    for (int i = 2; i < n; i++)
+        residuals[i] = (predictor == LinearPredictor) ? x[i] - 2 * x[i - 1] + x[i - 2] : x[i] - x[i - 1];
+
+    for (int start = 1; start < n; start += CodecBlockSize)
+    {
+        const int end = min(start + CodecBlockSize, n);
+        uint32_t all = 0;
+        for (int i = start; i < end; i++)
+            all |= zigzag(residuals[i]);
+        int width = 0;
+        while (all >> width)
+            width++;
+        out.push_back((uint8_t) width);
+        if (width == 0)
+            continue;
+
+        uint64_t accumulator = 0;
+        int bits = 0;
+        for (int i = start; i < end; i++)
+        {
+            accumulator |= (uint64_t) zigzag(residuals[i]) << bits;
+            bits += width;
+            while (bits >= 8)
+            {
+                out.push_back((uint8_t) accumulator);
+                accumulator >>= 8;
+                bits -= 8;
+            }
+        }
+        if (bits > 0)
+            out.push_back((uint8_t) accumulator);
+    }
+}
+
+void encodeChunk(const int16_t* frames, int numChannels, int nSamples, vector<uint8_t>& out)
+{
+    vector<int16_t> planes((size_t) numChannels * nSamples);
+    vector<int32_t> residuals;
+    framesToPlanes(frames, numChannels, nSamples, 0, numChannels, planes.data(), nSamples);
+    for (int c = 0; c < numChannels; c++)
+        encodeChannel(planes.data() + (size_t) c * nSamples, nSamples, residuals, out);
+}
+
+static const uint8_t* decodeChannel(const uint8_t* p, const uint8_t* end, int n, int16_t* x)
+{
+    if (end - p < 2)
+        throw std::runtime_error("Codec Error: corrupt chunk");
+    x[0] = (int16_t) (p[0] | (p[1] << 8));
+    p += 2;
+    if (n < 2)
+        return p;
+    if (p >= end || *p > LinearPredictor)
+        throw std::runtime_error("Codec Error: corrupt chunk");
+    Predictor predictor = (Predictor) *p++;
+
+    int32_t previous = x[0];
+    int32_t slope = 0;
+    int32_t residuals[CodecBlockSize];
+    for (int start = 1; start < n; start += CodecBlockSize)
+    {
+        const int count = min(start + CodecBlockSize, n) - start;
+        if (p >= end || *p > MaxResidualBits)
+            throw std::runtime_error("Codec Error: corrupt chunk");
+        const int width = *p++;
+        const int bytes = (count * width + 7) / 8;
+        if (end - p < bytes)
+            throw std::runtime_error("Codec Error: corrupt chunk");
+
+        // Unpack the block, eight bytes at a time when they are all within the chunk.
+        const uint32_t mask = (1U << width) - 1U;
+        if (end - p >= bytes + 8)
+        {
+            for (int j = 0; j < count; j++)
+            {
+                const unsigned bit = (unsigned) (j * width);
+                uint64_t word;
+                memcpy(&word, p + (bit >> 3), sizeof(word));
+                residuals[j] = unzigzag((uint32_t) (word >> (bit & 7)) & mask);
+            }
+        }
+        else
+        {
+            uint64_t accumulator = 0;
+            int bits = 0;
+            const uint8_t* q = p;
+            for (int j = 0; j < count; j++)
+            {
+                while (bits < width)
+                {
+                    accumulator |= (uint64_t) *q++ << bits;
+                    bits += 8;
+                }
+                residuals[j] = unzigzag((uint32_t) accumulator & mask);
+                accumulator >>= width;
+                bits -= width;
+            }
+        }
+
+        // The first residual is always a delta; slope is x[i] - x[i - 1].
+        int j = 0;
+        if (start == 1)
+        {
+            slope = residuals[0];
+            previous += slope;
+            x[1] = (int16_t) previous;
+            j = 1;
+        }
+        if (predictor == LinearPredictor)
+        {
+            for (; j < count; j++)
+            {
+                slope += residuals[j];
+                previous += slope;
+                x[start + j] = (int16_t) previous;
+            }
+        }
+        else
+        {
+            for (; j < count; j++)
+            {
+                previous += residuals[j];
+                x[start + j] = (int16_t) previous;
+            }
+        }
+        p += bytes;
+    }
+    return p;
+}
+
+void decodeChunk(const uint8_t* data, size_t size, int numChannels, int nSamples, int16_t* frames, int16_t* planes)
+{
+    const uint8_t* p = data;
+    const uint8_t* end = data + size;
+    for (int c = 0; c < numChannels; c++)
+        p = decodeChannel(p, end, nSamples, planes + (size_t) c * nSamples);
+    planesToFrames(planes, nSamples, numChannels, nSamples, 0, numChannels, frames);
+}
+
+void compressDataFile(const string& source, const string& destination, int numChannels, int numThreads,
+                      const atomic<bool>* cancel, atomic<double>* progress)
+{
+    if (numChannels <= 0)
+        throw std::runtime_error("Codec Error: no channels");
+    ifstream in(source, ios::in | ios::binary);
+    if (!in)
+        throw std::runtime_error("Codec Error: cannot open " + source);
+    const int64_t frameBytes = (int64_t) numChannels * (int64_t) sizeof(int16_t);
+    const int64_t numSamples = (int64_t) filesystem::file_size(source) / frameBytes;
+
+    CompressedFileHeader header = {};
+    header.magicNumber = CompressedFileMagicNumber;
+    header.versionNumber = CompressedFileVersionNumber;
+    header.numChannels = numChannels;
+    header.chunkSize = CodecChunkSize;
+    header.numSamples = numSamples;
+    header.numChunks = (numSamples + CodecChunkSize - 1) / CodecChunkSize;
+
+    string tempFilename = destination + ".tmp";
+    ofstream out(tempFilename, ios::out | ios::binary | ios::trunc);
+    if (!out)
+        throw std::runtime_error("Codec Error: cannot create " + tempFilename);
+    out.write((const char *)&header, sizeof(header));
+
+    // Read a batch of chunks, encode them in parallel, and write them in order.
+    const int batch = max(1, (numThreads > 0) ? numThreads : (int) thread::hardware_concurrency());
+    vector<int16_t> frames((size_t) batch * CodecChunkSize * numChannels);
+    vector<vector<uint8_t>> encoded(batch);
+    vector<int64_t> offsets;
+    int64_t offset = sizeof(header);
+    for (int64_t chunk = 0; chunk < header.numChunks; chunk += batch)
+    {
+        if (cancel && *cancel)
+        {
+            out.close();
+            error_code ec;
+            filesystem::remove(tempFilename, ec);
+            return;
+        }
+        const int numInBatch = (int) min<int64_t>(batch, header.numChunks - chunk);
+        const int64_t samples = min<int64_t>((int64_t) numInBatch * CodecChunkSize, numSamples - chunk * CodecChunkSize);
+        if (!in.read((char *)frames.data(), (streamsize) (samples * frameBytes)))
+            throw std::runtime_error("Codec Error: cannot read " + source);
+
+        vector<thread> threads;
+        for (int b = 0; b < numInBatch; b++)
+        {
+            const int n = (int) min<int64_t>(CodecChunkSize, samples - (int64_t) b * CodecChunkSize);
+            threads.emplace_back([&, b, n]()
+            {
+                encoded[b].clear();
+                encodeChunk(frames.data() + (size_t) b * CodecChunkSize * numChannels, numChannels, n, encoded[b]);
+            });
+        }
+        for (thread& t : threads)
+            t.join();
+
+        for (int b = 0; b < numInBatch; b++)
+        {
+            offsets.push_back(offset);
+            out.write((const char *)encoded[b].data(), (streamsize) encoded[b].size());
+            offset += (int64_t) encoded[b].size();
+        }
+        if (progress)
+            *progress = (double) (chunk + numInBatch) / (double) header.numChunks;
+    }
+    offsets.push_back(offset);
+
+    header.indexOffset = offset;
+    out.write((const char *)offsets.data(), (streamsize) (offsets.size() * sizeof(int64_t)));
+    out.seekp(0, ios::beg);
+    out.write((const char *)&header, sizeof(header));
+    out.close();
+    if (!out)
+        throw std::runtime_error("Codec Error: cannot write " + tempFilename);
+
+    error_code ec;
+    filesystem::rename(tempFilename, destination, ec);
+    if (ec)
+        throw std::runtime_error("Codec Error: cannot rename " + tempFilename);
+}
+
+
+CompressedDataFile::CompressedDataFile()
+: m_numChannels(0)
+, m_chunkSize(CodecChunkSize)
+, m_numSamples(0)
+{
+}
+
+CompressedDataFile::~CompressedDataFile()
+{
+    close();
+}
+
+void CompressedDataFile::open(const string& filename, int numThreads)
+{
+    close();
+
+    ifstream in(filename, ios::in | ios::binary);
+    CompressedFileHeader header;
+    if (!in || !in.read((char *)&header, sizeof(header)))
+        throw std::runtime_error("Codec Error: cannot read " + filename);
+    if (header.magicNumber != CompressedFileMagicNumber || header.versionNumber != CompressedFileVersionNumber ||
+        header.numChannels <= 0 || header.chunkSize <= 0 || header.numChunks < 0 ||
+        header.numChunks != (header.numSamples + header.chunkSize - 1) / header.chunkSize)
+    {
+        throw std::runtime_error("Codec Error: " + filename + " is not a compressed data file");
+    }
+    m_offsets.resize((size_t) header.numChunks + 1);
+    in.seekg(header.indexOffset, ios::beg);
+    if (!in.read((char *)m_offsets.data(), (streamsize) (m_offsets.size() * sizeof(int64_t))))
+        throw std::runtime_error("Codec Error: cannot read the index of " + filename);
+
+    m_filename = filename;
+    m_numChannels = header.numChannels;
+    m_chunkSize = header.chunkSize;
+    m_numSamples = header.numSamples;
+
+    const int64_t frameBytes = (int64_t) m_numChannels * (int64_t) sizeof(int16_t);
+    vector<int64_t> starts;
+    for (int64_t chunk = 0; chunk <= header.numChunks; chunk++)
+        starts.push_back(min(chunk * m_chunkSize, m_numSamples) * frameBytes);
+
+    int numWorkers = numThreadsToUse(numThreads);
+    m_files = vector<ifstream>(numWorkers);
+    m_data = vector<vector<uint8_t>>(numWorkers);
+    m_planes = vector<vector<int16_t>>(numWorkers, vector<int16_t>((size_t) m_chunkSize * m_numChannels));
+    for (ifstream& file : m_files)
+        file.open(filename, ios::in | ios::binary);
+    start(starts, numWorkers);
+}
+
+void CompressedDataFile::close()
+{
+    ChunkedFileReader::close();
+    m_files.clear();
+    m_data.clear();
+    m_planes.clear();
+    m_offsets.clear();
+    m_numSamples = 0;
+}
+
+int CompressedDataFile::read(int64_t firstSample, int nSamples, int16_t* frames)
+{
+    int64_t available = m_numSamples - firstSample;
+    int n = (int) ((nSamples < available) ? nSamples : available);
+    if (n <= 0 || firstSample < 0)
+        return 0;
+    const int64_t frameBytes = (int64_t) m_numChannels * (int64_t) sizeof(int16_t);
+    return (int) (ChunkedFileReader::read(firstSample * frameBytes, n * frameBytes, frames) / frameBytes);
+}
+
+void CompressedDataFile::decode(int worker, int64_t chunk, uint8_t* out)
+{
+    ifstream& in = m_files[worker];
+    vector<uint8_t>& data = m_data[worker];
+    const int n = (int) min<int64_t>(m_chunkSize, m_numSamples - chunk * m_chunkSize);
+    data.resize((size_t) (m_offsets[chunk + 1] - m_offsets[chunk]));
+    in.clear();
+    in.seekg(m_offsets[chunk], ios::beg);
+    if (!in.read((char *)data.data(), (streamsize) data.size()))
+        throw std::runtime_error("Codec Error: cannot read " + m_filename);
+    decodeChunk(data.data(), data.size(), m_numChannels, n, (int16_t *) out, m_planes[worker].data());
+}
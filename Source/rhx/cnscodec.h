@@ -0,0 +1,78 @@
+/*
+ * cnscodec.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSCODEC_H_
+#define RHX_CNSCODEC_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <atomic>
+#include <cstdint>
+#include "cnschunked.h"
+
+// Extension of a compressed data file: amplifier.dat compresses to amplifier.dat.icd.
+const char * const CompressedFileExtension = ".icd";
+
+// Samples per chunk, the unit of random access.
+const int CodecChunkSize = 2048;
+
+// Residuals per bit width.
+const int CodecBlockSize = 128;
+
+// Lossless compression of 16-bit multichannel data in frames (one frame per sample, channel index
+// varying fastest), as in amplifier.dat.
+// The file is a header, chunks of CodecChunkSize frames and an index of chunk offsets. Within a chunk
+// each channel is coded on its own: its first sample, then the residuals of a first-order (delta) or
+// second-order linear prediction, whichever is smaller, zigzag coded and bit-packed in blocks of
+// CodecBlockSize with one bit width per block.
+
+// Code nSamples frames of numChannels channels as one chunk, appended to out.
+void encodeChunk(const int16_t* frames, int numChannels, int nSamples, std::vector<uint8_t>& out);
+
+// Decode a chunk. planes is scratch space for numChannels * nSamples words. Will throw() on corrupt data.
+void decodeChunk(const uint8_t* data, size_t size, int numChannels, int nSamples, int16_t* frames, int16_t* planes);
+
+// Compress a raw data file of numChannels channels, encoding numThreads chunks at a time (0: one per
+// hardware thread). Will throw() on fail; cancel and progress may be null.
+void compressDataFile(const std::string& source, const std::string& destination, int numChannels, int numThreads,
+                      const std::atomic<bool>* cancel, std::atomic<double>* progress);
+
+// Random access to a compressed data file, decoding chunks in parallel (see ChunkedFileReader).
+class CompressedDataFile : public ChunkedFileReader
+{
+public:
+    CompressedDataFile();
+    ~CompressedDataFile();
+
+    // Will throw() on fail. numThreads 0: one per hardware thread.
+    void open(const std::string& filename, int numThreads = 0);
+    void close();
+
+    int numChannels() const { return m_numChannels; }
+    int64_t numSamples() const { return m_numSamples; }
+
+    // Read nSamples frames from firstSample on. Returns the number read. Will throw() on fail.
+    int read(int64_t firstSample, int nSamples, int16_t* frames);
+
+protected:
+    void decode(int worker, int64_t chunk, uint8_t* out) override;
+
+private:
+    std::string m_filename;
+    int m_numChannels;
+    int m_chunkSize;
+    int64_t m_numSamples;
+    std::vector<int64_t> m_offsets;     // numChunks + 1, in the file
+
+    // Per worker
+    std::vector<std::ifstream> m_files;
+    std::vector<std::vector<uint8_t>> m_data;
+    std::vector<std::vector<int16_t>> m_planes;
+};
+
+
+#endif /* RHX_CNSCODEC_H_ */
@@ -0,0 +1,264 @@
+/*
+ * cnscoefficients.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSCOEFFICIENTS_H_
+#define RHX_CNSCOEFFICIENTS_H_
+
+#include <utility>
+#include "rhxglobals.h"
+
+// Per-sample-rate constants and filter coefficients, computed at compile time and indexed by
+// AmplifierSampleRate, so that setting up a filter stage when a file is opened is a table lookup.
+
+const int NumSampleRates = 17;
+
+// The <cmath> functions are not constexpr, so tables are built with these. Arguments are reduced
+// to a small range and then summed as series; results agree with <cmath> to about 1e-15.
+namespace ConstexprMath
+{
+    constexpr double Ln2 = 0.693147180559945309417;
+    constexpr double PiD = 3.14159265358979323846;
+
+    constexpr double abs(double x)
+    {
+        return (x < 0.0) ? -x : x;
+    }
+
+    constexpr double exp(double x)
+    {
+        // x = k ln2 + r, |r| <= ln2 / 2
+        int k = (int) (x / Ln2 + ((x < 0.0) ? -0.5 : 0.5));
+        double r = x - k * Ln2;
+        double term = 1.0;
+        double sum = 1.0;
+        for (int n = 1; n < 30; n++)
+        {
+            term *= r / n;
+            sum += term;
+        }
+        for (; k > 0; k--) sum *= 2.0;
+        for (; k < 0; k++) sum *= 0.5;
+        return sum;
+    }
+
+    constexpr double log(double x)
+    {
+        // x = m 2^e, 1 <= m < 2; log(m) = 2 atanh((m - 1) / (m + 1))
+        int e = 0;
+        while (x >= 2.0) { x *= 0.5; e++; }
+        while (x < 1.0) { x *= 2.0; e--; }
+        double z = (x - 1.0) / (x + 1.0);
+        double z2 = z * z;
+        double term = z;
+        double sum = 0.0;
+        for (int n = 1; n < 60; n += 2)
+        {
+            sum += term / n;
+            term *= z2;
+        }
+        return 2.0 * sum + e * Ln2;
+    }
+
+    constexpr double sin(double x)
+    {
+        // reduce to [-pi, pi]
+        double twoPi = 2.0 * PiD;
+        long long k = (long long) (x / twoPi + ((x < 0.0) ? -0.5 : 0.5));
+        x -= k * twoPi;
+        double term = x;
+        double sum = x;
+        for (int n = 1; n < 30 && abs(term) > 1.0e-17 * abs(sum); n++)
+        {
+            term *= -x * x / ((2 * n) * (2 * n + 1));
+            sum += term;
+        }
+        return sum;
+    }
+
+    constexpr double cos(double x)
+    {
+        return sin(x + PiD / 2.0);
+    }
+}
+
+// Sample rate in Hz.
+inline constexpr double SampleRateTable[NumSampleRates] = {
+    1000.0, 1250.0, 1500.0, 2000.0, 2500.0, 3000.0, 10000.0 / 3.0, 4000.0, 5000.0,
+    6250.0, 8000.0, 10000.0, 12500.0, 15000.0, 20000.0, 25000.0, 30000.0
+};
+
+constexpr double sampleRateHz(AmplifierSampleRate rate)
+{
+    return SampleRateTable[(int) rate];
+}
+
+// Cutoff frequencies (Hz) of the on-chip DSP offset removal filter, for each DSP cutoff register
+// value (index 0 is not used). RHXRegisters::getDspFreqTable and setDspCutoffFreq read them from here.
+struct DspCutoffTable
+{
+    double fCutoff[16];
+};
+
+constexpr DspCutoffTable makeDspCutoffTable(double sampleRate)
+{
+    DspCutoffTable table = {};
+    double x = 1.0;
+    for (int n = 1; n < 16; n++)
+    {
+        x *= 2.0;
+        table.fCutoff[n] = sampleRate * ConstexprMath::log(x / (x - 1.0)) / (2.0 * ConstexprMath::PiD);
+    }
+    return table;
+}
+
+// Notch filter biquad (see MultichannelNotchFilter), for a notch bandwidth of 10 Hz.
+struct NotchCoefficients
+{
+    double b0, b1, b2, a1, a2;
+    int warmUpLength;
+};
+
+constexpr NotchCoefficients makeNotchCoefficients(double notchFreq, double bandwidth, double sampleRate)
+{
+    double d = ConstexprMath::exp(-ConstexprMath::PiD * bandwidth / sampleRate);
+    double c = ConstexprMath::cos(2.0 * ConstexprMath::PiD * notchFreq / sampleRate);
+    double a = (1.0 + d * d) / 2.0;
+    double w = -3.0 / ConstexprMath::log(d);
+    int warmUpLength = (int) w;
+    if (warmUpLength < w) warmUpLength++;
+    return { a, -2.0 * a * c, a, -(1.0 + d * d) * c, d * d, warmUpLength };
+}
+
+enum NotchFrequency {
+    Notch50Hz = 0,
+    Notch60Hz = 1
+};
+
+// LFP decimation (see PolyphaseDecimator): the integer factor that brings the sample rate closest
+// to LfpTargetRate, and a linear-phase anti-aliasing low-pass with DecimationTapsPerPhase taps per
+// polyphase branch (plus one, so that the delay is a whole number of output samples).
+constexpr double LfpTargetRate = 2000.0;
+const int DecimationTapsPerPhase = 16;
+const int MaxDecimationFactor = 15;
+const int MaxDecimationTaps = MaxDecimationFactor * DecimationTapsPerPhase + 1;
+
+// Low-pass cutoff as a fraction of the output sample rate.
+constexpr double DecimationCutoff = 0.4;
+
+struct DecimationCoefficients
+{
+    int factor;
+    int numTaps;
+    double taps[MaxDecimationTaps];
+};
+
+constexpr int lfpDecimationFactor(double sampleRate)
+{
+    int factor = (int) (sampleRate / LfpTargetRate + 0.5);
+    return (factor < 1) ? 1 : ((factor > MaxDecimationFactor) ? MaxDecimationFactor : factor);
+}
+
+constexpr int decimationTapCount(int factor)
+{
+    return (factor == 1) ? 1 : factor * DecimationTapsPerPhase + 1;
+}
+
+// Tap n of a Blackman-windowed sinc, before normalization. The taps are symmetric, so tap n and
+// tap numTaps - 1 - n are the same constant.
+constexpr int decimationTapIndex(int factor, int n)
+{
+    return (2 * n < decimationTapCount(factor)) ? n : decimationTapCount(factor) - 1 - n;
+}
+
+constexpr double decimationTap(int factor, int n)
+{
+    if (factor == 1)
+        return 1.0;
+    int numTaps = decimationTapCount(factor);
+    double fc = DecimationCutoff / factor;
+    double x = n - (numTaps - 1) / 2.0;
+    double sinc = (x == 0.0) ? 2.0 * fc : ConstexprMath::sin(2.0 * ConstexprMath::PiD * fc * x) / (ConstexprMath::PiD * x);
+    double phase = 2.0 * ConstexprMath::PiD * n / (numTaps - 1);
+    double window = 0.42 - 0.5 * ConstexprMath::cos(phase) + 0.08 * ConstexprMath::cos(2.0 * phase);
+    return sinc * window;
+}
+
+struct RateCoefficients
+{
+    double sampleRate;
+    DspCutoffTable dsp;
+    NotchCoefficients notch[2];
+    DecimationCoefficients lfp;
+};
+
+// Every filter design is a constant of its own, and a decimation filter is assembled from one
+// constant per tap, so that no one constant evaluation does much work: compilers cap that work
+// (MSVC's /constexpr:steps is 100000 by default, GCC's -fconstexpr-ops-limit), and the whole table
+// in one initializer exceeds it. The constants are inline, so a program holds one copy of them
+// however many files include this.
+template <int Factor, int N>
+inline constexpr double DecimationTapFor = decimationTap(Factor, N);
+
+// The taps normalized to unity gain at DC.
+template <int Factor, int... N>
+constexpr DecimationCoefficients makeDecimationCoefficients(std::integer_sequence<int, N...>)
+{
+    DecimationCoefficients d = { Factor, (int) sizeof...(N), { DecimationTapFor<Factor, decimationTapIndex(Factor, N)>... } };
+    double sum = 0.0;
+    for (int n = 0; n < d.numTaps; n++)
+        sum += d.taps[n];
+    for (int n = 0; n < d.numTaps; n++)
+        d.taps[n] /= sum;
+    return d;
+}
+
+template <int Factor>
+inline constexpr DecimationCoefficients DecimationCoefficientsFor =
+    makeDecimationCoefficients<Factor>(std::make_integer_sequence<int, decimationTapCount(Factor)>());
+
+template <int Rate>
+inline constexpr RateCoefficients RateCoefficientsFor = {
+    SampleRateTable[Rate],
+    makeDspCutoffTable(SampleRateTable[Rate]),
+    { makeNotchCoefficients(50.0, 10.0, SampleRateTable[Rate]),
+      makeNotchCoefficients(60.0, 10.0, SampleRateTable[Rate]) },
+    DecimationCoefficientsFor<lfpDecimationFactor(SampleRateTable[Rate])>
+};
+
+inline constexpr RateCoefficients RateCoefficientTable[NumSampleRates] = {
+    RateCoefficientsFor<0>, RateCoefficientsFor<1>, RateCoefficientsFor<2>, RateCoefficientsFor<3>,
+    RateCoefficientsFor<4>, RateCoefficientsFor<5>, RateCoefficientsFor<6>, RateCoefficientsFor<7>,
+    RateCoefficientsFor<8>, RateCoefficientsFor<9>, RateCoefficientsFor<10>, RateCoefficientsFor<11>,
+    RateCoefficientsFor<12>, RateCoefficientsFor<13>, RateCoefficientsFor<14>, RateCoefficientsFor<15>,
+    RateCoefficientsFor<16>
+};
+
+constexpr const RateCoefficients& rateCoefficients(AmplifierSampleRate rate)
+{
+    return RateCoefficientTable[(int) rate];
+}
+
+// DSP cutoff table for a sample rate in Hz: the precomputed one if it is a controller sample rate,
+// computed otherwise.
+inline DspCutoffTable dspCutoffTable(double sampleRate)
+{
+    for (int i = 0; i < NumSampleRates; i++)
+    {
+        if (ConstexprMath::abs(sampleRate - SampleRateTable[i]) <= 1.0e-9 * SampleRateTable[i])
+            return RateCoefficientTable[i].dsp;
+    }
+    return makeDspCutoffTable(sampleRate);
+}
+
+static_assert(ConstexprMath::abs(RateCoefficientTable[SampleRate30000Hz].dsp.fCutoff[1] - 3309.0) < 1.0,
+              "DSP cutoff table");
+static_assert(ConstexprMath::abs(RateCoefficientTable[SampleRate20000Hz].notch[Notch60Hz].a2 - 0.996863) < 1.0e-6,
+              "notch coefficient table");
+static_assert(RateCoefficientTable[SampleRate30000Hz].lfp.factor == 15 && RateCoefficientTable[SampleRate30000Hz].lfp.numTaps == 241,
+              "LFP decimation table");
+
+
+#endif /* RHX_CNSCOEFFICIENTS_H_ */
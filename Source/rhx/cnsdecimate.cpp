@@ -0,0 +1,94 @@
+/*
+ * cnsdecimate.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include <cstring>
+#include "cnsdecimate.h"
+using namespace std;
+
+
+PolyphaseDecimator::PolyphaseDecimator()
+: m_numChannels(0)
+, m_factor(1)
+, m_numTaps(1)
+, m_outputRate(0.0)
+, m_primed(false)
+, m_nextOutput(0)
+{
+}
+
+void PolyphaseDecimator::setParameters(AmplifierSampleRate rate, int numChannels)
+{
+    const RateCoefficients& coefficients = rateCoefficients(rate);
+    const DecimationCoefficients& d = coefficients.lfp;
+    m_numChannels = numChannels;
+    m_factor = d.factor;
+    m_numTaps = d.numTaps;
+    m_outputRate = coefficients.sampleRate / d.factor;
+    m_taps.resize(m_numTaps);
+    for (int k = 0; k < m_numTaps; k++)
+        m_taps[k] = (float) d.taps[m_numTaps - 1 - k];
+    m_work.assign((size_t) (m_numTaps - 1) * numChannels, 0.0F);
+    reset();
+}
+
+void PolyphaseDecimator::reset(int firstOutput)
+{
+    m_primed = false;
+    m_nextOutput = max(firstOutput, 0);
+}
+
+int PolyphaseDecimator::inputsForOutputs(int nOutputs) const
+{
+    return (nOutputs <= 0) ? 0 : m_nextOutput + (nOutputs - 1) * m_factor + 1;
+}
+
+int PolyphaseDecimator::process(const float* in, int nSamples, float* out)
+{
+    const int nc = m_numChannels;
+    const int history = m_numTaps - 1;
+    if (nSamples <= 0 || nc == 0)
+        return 0;
+
+    size_t needed = (size_t) (history + nSamples) * nc;
+    if (m_work.size() < needed)
+        m_work.resize(needed);
+    float* work = m_work.data();
+
+    // The taps have unity gain at DC, so a history equal to the first input is a steady state.
+    if (!m_primed)
+    {
+        for (int t = 0; t < history; t++)
+            memcpy(work + (size_t) t * nc, in, nc * sizeof(float));
+        m_primed = true;
+    }
+    memcpy(work + (size_t) history * nc, in, (size_t) nSamples * nc * sizeof(float));
+
+    const float* taps = m_taps.data();
+    int nOut = 0;
+    int p = m_nextOutput;
+    for (; p < nSamples; p += m_factor)
+    {
+        // Input p is work frame history + p; its window starts history frames earlier.
+        const float* window = work + (size_t) p * nc;
+        float* o = out + (size_t) nOut * nc;
+        for (int c = 0; c < nc; c++)
+            o[c] = 0.0F;
+        for (int k = 0; k < m_numTaps; k++)
+        {
+            const float h = taps[k];
+            const float* frame = window + (size_t) k * nc;
+            for (int c = 0; c < nc; c++)
+                o[c] += h * frame[c];
+        }
+        nOut++;
+    }
+    m_nextOutput = p - nSamples;
+
+    // Keep the last numTaps() - 1 inputs for the next block.
+    memmove(work, work + (size_t) nSamples * nc, (size_t) history * nc * sizeof(float));
+    return nOut;
+}
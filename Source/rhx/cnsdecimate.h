@@ -0,0 +1,56 @@
+/*
+ * cnsdecimate.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSDECIMATE_H_
+#define RHX_CNSDECIMATE_H_
+
+#include <vector>
+#include "cnscoefficients.h"
+
+// Decimation by an integer factor with a linear-phase FIR anti-aliasing filter, applied to blocks
+// of multichannel data in frames (one frame per sample, channel index varying fastest).
+// Only the retained outputs are computed, i.e. each output uses the polyphase branch that lines up
+// with it, so the cost per input sample is numTaps() / factor() multiply-adds per channel. The inner
+// loop runs across channels, so the compiler can vectorize it.
+// Output n is produced when input firstOutput + n * factor() is consumed (see reset()), and is the
+// filter output for that input, so it lags the input by delay() samples.
+class PolyphaseDecimator
+{
+public:
+    PolyphaseDecimator();
+
+    // LFP decimation for the given amplifier sample rate, from the precomputed coefficient table.
+    void setParameters(AmplifierSampleRate rate, int numChannels);
+
+    int factor() const { return m_factor; }
+    int numTaps() const { return m_numTaps; }
+    int delay() const { return (m_numTaps - 1) / 2; }
+    double outputRate() const { return m_outputRate; }
+
+    // Clear the filter state. The first input after reset is taken as the steady-state history;
+    // the first output is produced by input number firstOutput (counting from 0) after reset.
+    void reset(int firstOutput = 0);
+
+    // Inputs needed to produce the next nOutputs outputs.
+    int inputsForOutputs(int nOutputs) const;
+
+    // Filter nSamples input frames; the outputs produced are written to out, which must have room for
+    // (nSamples / factor() + 1) frames. Returns the number of output frames.
+    int process(const float* in, int nSamples, float* out);
+
+private:
+    int m_numChannels;
+    int m_factor;
+    int m_numTaps;
+    double m_outputRate;
+    bool m_primed;
+    int m_nextOutput;                   // inputs to consume before the one producing the next output
+    std::vector<float> m_taps;          // time reversed, so taps and inputs run in the same direction
+    std::vector<float> m_work;          // numTaps() - 1 frames of history, then the current block
+};
+
+
+#endif /* RHX_CNSDECIMATE_H_ */
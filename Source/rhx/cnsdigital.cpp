@@ -0,0 +1,243 @@
+/*
+ * cnsdigital.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <exception>
+#include <stdexcept>
+#include <filesystem>
+#include <algorithm>
+#include "cnsdigital.h"
+using namespace std;
+
+
+// Words read from the data files at a time.
+static const int64_t DigitalReadBlockSize = 1 << 16;
+
+uint16_t enabledDigitalLines(const IntanHeaderInfo& info, bool outputs)
+{
+    const SignalType type = outputs ? BoardDigitalOutSignal : BoardDigitalInSignal;
+    uint16_t lines = 0;
+    for (const HeaderFileGroup& group : info.groups)
+    {
+        for (const HeaderFileChannel& channel : group.channels)
+        {
+            if (channel.enabled && channel.signalType == type && channel.chipChannel >= 0 && channel.chipChannel < NumDigitalLines)
+                lines |= (uint16_t) (1 << channel.chipChannel);
+        }
+    }
+
+    // A header that counts enabled lines without listing them: the lowest lines.
+    const int numEnabled = outputs ? info.numEnabledDigitalOutChannels : info.numEnabledDigitalInChannels;
+    if (lines == 0 && numEnabled > 0)
+        lines = (uint16_t) ((1 << min(numEnabled, NumDigitalLines)) - 1);
+    return lines;
+}
+
+template <typename T>
+static void expand(const uint16_t* words, int64_t nSamples, uint16_t lines, T* planes, int64_t planeStride)
+{
+    for (int64_t first = 0; first < nSamples; first += DigitalExpandBlockSize)
+    {
+        const int64_t n = min(DigitalExpandBlockSize, nSamples - first);
+        const uint16_t* in = words + first;
+        T* plane = planes + first;
+        for (int line = 0; line < NumDigitalLines; line++)
+        {
+            if (!(lines & (1 << line)))
+                continue;
+            for (int64_t t = 0; t < n; t++)
+                plane[t] = (T) ((in[t] >> line) & 1);
+            plane += planeStride;
+        }
+    }
+}
+
+void expandDigitalWords(const uint16_t* words, int64_t nSamples, uint16_t lines, float* planes, int64_t planeStride)
+{
+    expand(words, nSamples, lines, planes, planeStride);
+}
+
+void expandDigitalWords(const uint16_t* words, int64_t nSamples, uint16_t lines, uint8_t* planes, int64_t planeStride)
+{
+    expand(words, nSamples, lines, planes, planeStride);
+}
+
+
+DigitalLineReader::DigitalLineReader()
+: m_lines(0)
+, m_outputs(false)
+, m_numSamples(0)
+{
+}
+
+DigitalLineReader::~DigitalLineReader()
+{
+    close();
+}
+
+void DigitalLineReader::open(const string& headerFilename, bool outputs)
+{
+    close();
+    m_outputs = outputs;
+    if (isTraditionalIntanFile(headerFilename))
+    {
+        m_traditional.reset(new TraditionalIntanReader());
+        m_traditional->open(headerFilename);
+        m_lines = enabledDigitalLines(m_traditional->info(), outputs);
+        if (m_traditional->signals() & (outputs ? TraditionalDigitalOutSignal : TraditionalDigitalInSignal))
+            m_numSamples = m_traditional->numSamples();
+        else if (m_lines != 0)
+        {
+            close();
+            throw std::runtime_error(string("Digital Error: the data blocks of ") + headerFilename + " hold no digital " +
+                                     (outputs ? "outputs" : "inputs"));
+        }
+        return;
+    }
+
+    IntanHeaderInfo info;
+    readIntanHeader(headerFilename.c_str(), info);
+    m_lines = enabledDigitalLines(info, outputs);
+
+    filesystem::path directory = filesystem::path(headerFilename).parent_path();
+    filesystem::path path = directory / (outputs ? "digitalout.dat" : "digitalin.dat");
+    if (filesystem::exists(path))
+    {
+        m_file.open(path.string(), ios::in | ios::binary);
+        if (!m_file)
+            throw std::runtime_error("Digital Error: cannot open " + path.string());
+        m_numSamples = (int64_t) filesystem::file_size(path) / (int64_t) sizeof(uint16_t);
+        return;
+    }
+
+    // One file per line, 0 or 1 in each word. The files can differ in length if a recording was cut
+    // short; use the shortest.
+    const SignalType type = outputs ? BoardDigitalOutSignal : BoardDigitalInSignal;
+    vector<string> lineFilenames(NumDigitalLines);
+    for (const HeaderFileGroup& group : info.groups)
+    {
+        for (const HeaderFileChannel& channel : group.channels)
+        {
+            if (channel.enabled && channel.signalType == type && channel.chipChannel >= 0 && channel.chipChannel < NumDigitalLines)
+                lineFilenames[channel.chipChannel] = (directory / ("board-" + channel.nativeChannelName + ".dat")).string();
+        }
+    }
+    m_numSamples = -1;
+    for (int line = 0; line < NumDigitalLines; line++)
+    {
+        if (!(m_lines & (1 << line)))
+            continue;
+        if (lineFilenames[line].empty() || !filesystem::exists(lineFilenames[line]))
+        {
+            close();
+            throw std::runtime_error(string("Digital Error: cannot find the digital ") + (outputs ? "output" : "input") +
+                                     " data next to " + headerFilename);
+        }
+        m_lineFiles.emplace_back(new ifstream(lineFilenames[line], ios::in | ios::binary));
+        if (!*m_lineFiles.back())
+        {
+            close();
+            throw std::runtime_error("Digital Error: cannot open " + lineFilenames[line]);
+        }
+        int64_t n = (int64_t) filesystem::file_size(lineFilenames[line]) / (int64_t) sizeof(uint16_t);
+        m_numSamples = (m_numSamples < 0) ? n : min(m_numSamples, n);
+    }
+    m_numSamples = max<int64_t>(m_numSamples, 0);
+}
+
+void DigitalLineReader::close()
+{
+    if (m_file.is_open())
+        m_file.close();
+    m_file.clear();
+    m_lineFiles.clear();
+    m_traditional.reset();
+    m_lines = 0;
+    m_numSamples = 0;
+}
+
+int DigitalLineReader::numLines() const
+{
+    int n = 0;
+    for (int line = 0; line < NumDigitalLines; line++)
+        n += (m_lines >> line) & 1;
+    return n;
+}
+
+int64_t DigitalLineReader::readWords(int64_t firstSample, int64_t nSamples, uint16_t* words)
+{
+    nSamples = min(nSamples, m_numSamples - firstSample);
+    if (firstSample < 0 || nSamples <= 0)
+        return 0;
+
+    if (m_file.is_open())
+    {
+        m_file.clear();
+        m_file.seekg(firstSample * (int64_t) sizeof(uint16_t), ios::beg);
+        if (!m_file.read((char *) words, nSamples * (int64_t) sizeof(uint16_t)))
+            throw std::runtime_error("Digital Error: cannot read digital data");
+        return nSamples;
+    }
+
+    if (m_traditional)
+    {
+        TraditionalSamples samples;
+        if (m_outputs)
+            samples.digitalOut = words;
+        else
+            samples.digitalIn = words;
+        return m_traditional->read(firstSample, nSamples, samples);
+    }
+
+    // Pack the line files' words, a block at a time.
+    fill(words, words + nSamples, (uint16_t) 0);
+    m_lineWords.resize((size_t) min(nSamples, DigitalReadBlockSize));
+    size_t file = 0;
+    for (int line = 0; line < NumDigitalLines; line++)
+    {
+        if (!(m_lines & (1 << line)))
+            continue;
+        ifstream& in = *m_lineFiles[file++];
+        in.clear();
+        in.seekg(firstSample * (int64_t) sizeof(uint16_t), ios::beg);
+        for (int64_t done = 0; done < nSamples; )
+        {
+            const int64_t n = min(nSamples - done, DigitalReadBlockSize);
+            if (!in.read((char *) m_lineWords.data(), n * (int64_t) sizeof(uint16_t)))
+                throw std::runtime_error("Digital Error: cannot read digital data");
+            uint16_t* out = words + done;
+            for (int64_t t = 0; t < n; t++)
+                out[t] |= (uint16_t) ((m_lineWords[t] != 0) << line);
+            done += n;
+        }
+    }
+    return nSamples;
+}
+
+template <typename T>
+int64_t DigitalLineReader::readPlanes(int64_t firstSample, int64_t nSamples, T* planes, int64_t planeStride)
+{
+    m_words.resize((size_t) min(max<int64_t>(nSamples, 0), DigitalReadBlockSize));
+    int64_t done = 0;
+    while (done < nSamples)
+    {
+        const int64_t n = readWords(firstSample + done, min(nSamples - done, DigitalReadBlockSize), m_words.data());
+        if (n <= 0)
+            break;
+        expand(m_words.data(), n, m_lines, planes + done, planeStride);
+        done += n;
+    }
+    return done;
+}
+
+int64_t DigitalLineReader::read(int64_t firstSample, int64_t nSamples, float* planes, int64_t planeStride)
+{
+    return readPlanes(firstSample, nSamples, planes, planeStride);
+}
+
+int64_t DigitalLineReader::read(int64_t firstSample, int64_t nSamples, uint8_t* planes, int64_t planeStride)
+{
+    return readPlanes(firstSample, nSamples, planes, planeStride);
+}
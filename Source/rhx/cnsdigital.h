@@ -0,0 +1,75 @@
+/*
+ * cnsdigital.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSDIGITAL_H_
+#define RHX_CNSDIGITAL_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+#include <cstdint>
+#include "cnsrhx.h"
+#include "cnstraditional.h"
+
+// Lines in a digital input (or output) word.
+const int NumDigitalLines = 16;
+
+// Words expanded at a time: a block stays in L1 cache while each line is pulled out of it.
+const int64_t DigitalExpandBlockSize = 4096;
+
+// Bit mask (bit k for line k) of the board digital inputs, or outputs, enabled in the header.
+uint16_t enabledDigitalLines(const IntanHeaderInfo& info, bool outputs = false);
+
+// Expand nSamples packed digital words into one plane per line set in lines, in line order: the plane
+// of the k-th line set starts at planes + k * planeStride, and holds 1 where the line is high and 0
+// where it is low. Lines not set are skipped. The inner loop is a shift, mask and convert per word
+// with no branches, which the compiler vectorizes (8 or 16 words per instruction).
+void expandDigitalWords(const uint16_t* words, int64_t nSamples, uint16_t lines, float* planes, int64_t planeStride);
+void expandDigitalWords(const uint16_t* words, int64_t nSamples, uint16_t lines, uint8_t* planes, int64_t planeStride);
+
+// Reader for the board digital inputs (or outputs) of a recording, as packed words or as one 0/1 plane
+// per enabled line. Reads digitalin.dat (digitalout.dat), in the one file per channel format the
+// board-DIGITAL-IN-xx.dat (board-DIGITAL-OUT-xx.dat) file of each enabled line, or the data blocks of a
+// traditional .rhd or .rhs file.
+class DigitalLineReader
+{
+public:
+    DigitalLineReader();
+    ~DigitalLineReader();
+
+    // Will throw() on fail.
+    void open(const std::string& headerFilename, bool outputs = false);
+    void close();
+
+    uint16_t lines() const { return m_lines; }
+    int numLines() const;
+    int64_t numSamples() const { return m_numSamples; }
+
+    // Read nSamples words from firstSample (>= 0) on, up to the end of the data. Returns the number read.
+    int64_t readWords(int64_t firstSample, int64_t nSamples, uint16_t* words);
+
+    // Read nSamples samples of every enabled line from firstSample on, as planes (see expandDigitalWords()).
+    // Returns the number of samples read.
+    int64_t read(int64_t firstSample, int64_t nSamples, float* planes, int64_t planeStride);
+    int64_t read(int64_t firstSample, int64_t nSamples, uint8_t* planes, int64_t planeStride);
+
+private:
+    uint16_t m_lines;
+    bool m_outputs;
+    int64_t m_numSamples;
+    std::ifstream m_file;                                       // digitalin.dat or digitalout.dat
+    std::vector<std::unique_ptr<std::ifstream>> m_lineFiles;    // or one per enabled line, in line order
+    std::unique_ptr<TraditionalIntanReader> m_traditional;      // or the data blocks of the header file
+    std::vector<uint16_t> m_words;
+    std::vector<uint16_t> m_lineWords;
+
+    template <typename T>
+    int64_t readPlanes(int64_t firstSample, int64_t nSamples, T* planes, int64_t planeStride);
+};
+
+
+#endif /* RHX_CNSDIGITAL_H_ */
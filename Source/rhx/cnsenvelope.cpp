@@ -0,0 +1,437 @@
+/*
+ * cnsenvelope.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <sstream>
+#include <exception>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+#include "cnsreader.h"
+#include "cnscodec.h"
+#include "cnszstd.h"
+#include "cnsenvelope.h"
+using namespace std;
+
+
+static const uint32_t EnvelopeFileMagicNumber = 0x18f8e4e1;
+static const uint32_t EnvelopeFileVersionNumber = 1;
+
+// Bins of the finest level read from the data file at a time.
+static const int EnvelopeBinsPerChunk = 64;
+
+// Bins of each level buffered before being written.
+static const int EnvelopeBinsPerWrite = 64;
+
+// Identity of the data file an envelope was built from.
+struct EnvelopeFileHeader
+{
+    uint32_t magicNumber;
+    uint32_t versionNumber;
+    int64_t dataFileSize;
+    int64_t dataFileTime;
+    int32_t numChannels;
+    int32_t baseBinSize;
+    int32_t numLevels;
+    int32_t reserved;
+};
+
+static void dataFileIdentity(const string& dataFilename, int64_t& size, int64_t& time)
+{
+    size = (int64_t) filesystem::file_size(dataFilename);
+    time = (int64_t) filesystem::last_write_time(dataFilename).time_since_epoch().count();
+}
+
+// Level k has ceil(numBins(k - 1) / 2) bins, down to a single bin.
+static vector<int64_t> levelSizes(int64_t numSamples)
+{
+    vector<int64_t> sizes;
+    int64_t n = (numSamples + EnvelopeBaseBinSize - 1) / EnvelopeBaseBinSize;
+    if (n == 0)
+        return sizes;
+    sizes.push_back(n);
+    while (n > 1)
+    {
+        n = (n + 1) / 2;
+        sizes.push_back(n);
+    }
+    return sizes;
+}
+
+
+IntanEnvelope::IntanEnvelope()
+: m_numChannels(0)
+{
+}
+
+bool IntanEnvelope::open(const string& dataFilename)
+{
+    close();
+
+    error_code ec;
+    string filename = envelopeFilename(dataFilename);
+    if (!filesystem::exists(filename, ec) || !filesystem::exists(dataFilename, ec))
+        return false;
+
+    m_file.open(filename, ios::in | ios::binary);
+    EnvelopeFileHeader header;
+    if (!m_file || !m_file.read((char *)&header, sizeof(header)))
+    {
+        close();
+        return false;
+    }
+
+    int64_t size, time;
+    dataFileIdentity(dataFilename, size, time);
+    if (header.magicNumber != EnvelopeFileMagicNumber || header.versionNumber != EnvelopeFileVersionNumber
+            || header.dataFileSize != size || header.dataFileTime != time || header.baseBinSize != EnvelopeBaseBinSize
+            || header.numChannels <= 0 || header.numLevels < 0 || header.numLevels > 64)
+    {
+        close();
+        return false;
+    }
+
+    m_numChannels = header.numChannels;
+    m_levels.resize(header.numLevels);
+    if (header.numLevels > 0 && !m_file.read((char *)m_levels.data(), header.numLevels * sizeof(Level)))
+    {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void IntanEnvelope::close()
+{
+    if (m_file.is_open())
+        m_file.close();
+    m_file.clear();
+    m_numChannels = 0;
+    m_levels.clear();
+}
+
+int IntanEnvelope::selectLevel(int64_t numSamples, int maxBins) const
+{
+    maxBins = max(maxBins, 1);
+    for (int level = 0; level < numLevels(); level++)
+    {
+        if ((numSamples + binSize(level) - 1) / binSize(level) <= maxBins)
+            return level;
+    }
+    return numLevels() - 1;
+}
+
+int64_t IntanEnvelope::read(int level, int64_t firstBin, int64_t nBins, vector<EnvelopeBin>& bins)
+{
+    const Level& l = m_levels[level];
+    firstBin = max<int64_t>(firstBin, 0);
+    nBins = min(nBins, l.numBins - firstBin);
+    if (nBins <= 0)
+    {
+        bins.clear();
+        return 0;
+    }
+
+    bins.resize((size_t) nBins * m_numChannels);
+    m_file.clear();
+    m_file.seekg(l.offset + firstBin * m_numChannels * (int64_t) sizeof(EnvelopeBin), ios::beg);
+    if (!m_file.read((char *)bins.data(), nBins * m_numChannels * (int64_t) sizeof(EnvelopeBin)))
+        throw std::runtime_error("Envelope Error: cannot read envelope file");
+    return nBins;
+}
+
+int IntanEnvelope::query(int64_t startSample, int64_t numSamples, int maxBins, vector<EnvelopeBin>& bins, int64_t& firstBinSample)
+{
+    bins.clear();
+    firstBinSample = startSample;
+    if (numLevels() == 0 || numSamples <= 0)
+        return 0;
+
+    // Bins that overlap the span; a span not aligned to the bins may need one more.
+    int level = selectLevel(numSamples, max(maxBins - 1, 1));
+    int64_t size = binSize(level);
+    int64_t firstBin = max<int64_t>(startSample, 0) / size;
+    int64_t lastBin = (startSample + numSamples - 1) / size;
+    read(level, firstBin, lastBin - firstBin + 1, bins);
+    firstBinSample = firstBin * size;
+    return level;
+}
+
+
+// Running min/max/sum of squares of each channel over a bin.
+namespace
+{
+    struct Accumulator
+    {
+        vector<int16_t> min;
+        vector<int16_t> max;
+        vector<double> sumSquares;
+        int64_t numSamples;
+        int numBins;
+
+        void reset(int nc)
+        {
+            min.assign(nc, 32767);
+            max.assign(nc, -32768);
+            sumSquares.assign(nc, 0.0);
+            numSamples = 0;
+            numBins = 0;
+        }
+    };
+
+    class PyramidWriter
+    {
+    public:
+        PyramidWriter(fstream& out, int nc, const vector<int64_t>& sizes, const vector<int64_t>& offsets)
+        : m_out(out), m_numChannels(nc), m_offsets(offsets)
+        {
+            int numLevels = (int) sizes.size();
+            m_pending.resize(numLevels);
+            m_buffers.resize(numLevels);
+            m_written.assign(numLevels, 0);
+            for (int level = 0; level < numLevels; level++)
+                m_pending[level].reset(nc);
+        }
+
+        // Add a finished bin at level: write it out, and merge it into the bin above.
+        void push(int level, const Accumulator& bin)
+        {
+            const int nc = m_numChannels;
+            vector<EnvelopeBin>& buffer = m_buffers[level];
+            double scale = 1.0 / (double) bin.numSamples;
+            for (int c = 0; c < nc; c++)
+                buffer.push_back({ bin.min[c], bin.max[c], (float) sqrt(bin.sumSquares[c] * scale) });
+            if (buffer.size() >= (size_t) EnvelopeBinsPerWrite * nc)
+                flush(level);
+
+            if (level + 1 >= (int) m_pending.size())
+                return;
+            Accumulator& above = m_pending[level + 1];
+            for (int c = 0; c < nc; c++)
+            {
+                above.min[c] = std::min(above.min[c], bin.min[c]);
+                above.max[c] = std::max(above.max[c], bin.max[c]);
+                above.sumSquares[c] += bin.sumSquares[c];
+            }
+            above.numSamples += bin.numSamples;
+            if (++above.numBins == 2)
+            {
+                push(level + 1, above);
+                above.reset(nc);
+            }
+        }
+
+        // Emit the partial bins left at the end of the data, finest level first.
+        void finish()
+        {
+            for (int level = 1; level < (int) m_pending.size(); level++)
+            {
+                if (m_pending[level].numBins > 0)
+                {
+                    Accumulator bin = m_pending[level];
+                    m_pending[level].reset(m_numChannels);
+                    push(level, bin);
+                }
+            }
+            for (int level = 0; level < (int) m_buffers.size(); level++)
+                flush(level);
+        }
+
+    private:
+        fstream& m_out;
+        int m_numChannels;
+        vector<int64_t> m_offsets;
+        vector<Accumulator> m_pending;
+        vector<vector<EnvelopeBin>> m_buffers;
+        vector<int64_t> m_written;
+
+        void flush(int level)
+        {
+            vector<EnvelopeBin>& buffer = m_buffers[level];
+            if (buffer.empty())
+                return;
+            m_out.seekp(m_offsets[level] + m_written[level] * (int64_t) sizeof(EnvelopeBin), ios::beg);
+            if (!m_out.write((const char *)buffer.data(), buffer.size() * sizeof(EnvelopeBin)))
+                throw std::runtime_error("Envelope Error: cannot write envelope file");
+            m_written[level] += (int64_t) buffer.size();
+            buffer.clear();
+        }
+    };
+}
+
+void EnvelopeBuilder::build(const string& headerFilename, const atomic<bool>* cancel, atomic<double>* progress)
+{
+    IntanDataReader reader;
+    reader.open(headerFilename);
+    const int nc = reader.numAmplifierChannels();
+    const int64_t numSamples = reader.numSamples();
+    string dataFilename = reader.amplifierFilename();
+    string filename = IntanEnvelope::envelopeFilename(dataFilename);
+    string tempFilename = filename + ".tmp";
+    if (nc == 0)
+        throw std::runtime_error("Envelope Error: no amplifier channels");
+
+    vector<int64_t> sizes = levelSizes(numSamples);
+    EnvelopeFileHeader header = {};
+    header.magicNumber = EnvelopeFileMagicNumber;
+    header.versionNumber = EnvelopeFileVersionNumber;
+    dataFileIdentity(dataFilename, header.dataFileSize, header.dataFileTime);
+    header.numChannels = nc;
+    header.baseBinSize = EnvelopeBaseBinSize;
+    header.numLevels = (int32_t) sizes.size();
+
+    // Levels follow the header and level table, finest first.
+    vector<int64_t> offsets(sizes.size());
+    int64_t offset = sizeof(header) + sizes.size() * 2 * sizeof(int64_t);
+    for (size_t level = 0; level < sizes.size(); level++)
+    {
+        offsets[level] = offset;
+        offset += sizes[level] * nc * (int64_t) sizeof(EnvelopeBin);
+    }
+
+    {
+        fstream out(tempFilename, ios::in | ios::out | ios::binary | ios::trunc);
+        if (!out)
+            throw std::runtime_error("Envelope Error: cannot create " + tempFilename);
+        out.write((const char *)&header, sizeof(header));
+        for (size_t level = 0; level < sizes.size(); level++)
+        {
+            out.write((const char *)&sizes[level], sizeof(int64_t));
+            out.write((const char *)&offsets[level], sizeof(int64_t));
+        }
+
+        PyramidWriter writer(out, nc, sizes, offsets);
+        vector<int16_t> chunk((size_t) EnvelopeBinsPerChunk * EnvelopeBaseBinSize * nc);
+        vector<float> sumSquares(nc);
+        Accumulator bin;
+        bin.reset(nc);
+
+        for (int64_t position = 0; position < numSamples; )
+        {
+            if (cancel && *cancel)
+            {
+                out.close();
+                error_code ec;
+                filesystem::remove(tempFilename, ec);
+                return;
+            }
+            int n = reader.readAmplifierData(chunk.data(), EnvelopeBinsPerChunk * EnvelopeBaseBinSize);
+            if (n <= 0)
+                break;
+
+            for (int b = 0; b * EnvelopeBaseBinSize < n; b++)
+            {
+                int binSamples = min(EnvelopeBaseBinSize, n - b * EnvelopeBaseBinSize);
+                int16_t* mn = bin.min.data();
+                int16_t* mx = bin.max.data();
+                float* ss = sumSquares.data();
+                fill(bin.min.begin(), bin.min.end(), (int16_t) 32767);
+                fill(bin.max.begin(), bin.max.end(), (int16_t) -32768);
+                fill(sumSquares.begin(), sumSquares.end(), 0.0F);
+
+                // Channels innermost, so min, max and sum of squares vectorize across channels.
+                const int16_t* frames = chunk.data() + (size_t) b * EnvelopeBaseBinSize * nc;
+                for (int t = 0; t < binSamples; t++)
+                {
+                    const int16_t* frame = frames + (size_t) t * nc;
+                    for (int c = 0; c < nc; c++)
+                    {
+                        int16_t x = frame[c];
+                        mn[c] = (x < mn[c]) ? x : mn[c];
+                        mx[c] = (x > mx[c]) ? x : mx[c];
+                        float xf = (float) x;
+                        ss[c] += xf * xf;
+                    }
+                }
+                for (int c = 0; c < nc; c++)
+                    bin.sumSquares[c] = ss[c];
+                bin.numSamples = binSamples;
+                writer.push(0, bin);
+            }
+            position += n;
+            if (progress)
+                *progress = (double) position / (double) numSamples;
+        }
+        writer.finish();
+        out.flush();
+        if (!out)
+            throw std::runtime_error("Envelope Error: cannot write " + tempFilename);
+    }
+
+    // The data file is not expected to change while the envelope is built; if it did, the
+    // envelope is still renamed into place and rejected on open.
+    error_code ec;
+    filesystem::rename(tempFilename, filename, ec);
+    if (ec)
+        throw std::runtime_error("Envelope Error: cannot rename " + tempFilename);
+}
+
+
+EnvelopeBuilder::EnvelopeBuilder()
+: m_running(false)
+, m_cancel(false)
+, m_progress(0.0)
+{
+}
+
+EnvelopeBuilder::~EnvelopeBuilder()
+{
+    cancel();
+    wait();
+}
+
+void EnvelopeBuilder::start(const string& headerFilename)
+{
+    cancel();
+    wait();
+
+    IntanEnvelope envelope;
+    string dataFilename = (filesystem::path(headerFilename).parent_path() / "amplifier.dat").string();
+    if (!filesystem::exists(dataFilename))
+        dataFilename += filesystem::exists(dataFilename + CompressedFileExtension) ? CompressedFileExtension : ZstdFileExtension;
+    if (envelope.open(dataFilename))
+    {
+        m_progress = 1.0;
+        return;
+    }
+
+    m_cancel = false;
+    m_progress = 0.0;
+    m_running = true;
+    {
+        lock_guard<mutex> lock(m_errorMutex);
+        m_error.clear();
+    }
+    m_thread = thread([this, headerFilename]()
+    {
+        try
+        {
+            build(headerFilename, &m_cancel, &m_progress);
+        }
+        catch (std::exception &e)
+        {
+            lock_guard<mutex> lock(m_errorMutex);
+            m_error = e.what();
+        }
+        m_running = false;
+    });
+}
+
+void EnvelopeBuilder::cancel()
+{
+    m_cancel = true;
+}
+
+void EnvelopeBuilder::wait()
+{
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+string EnvelopeBuilder::error() const
+{
+    lock_guard<mutex> lock(m_errorMutex);
+    return m_error;
+}
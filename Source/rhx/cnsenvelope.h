@@ -0,0 +1,107 @@
+/*
+ * cnsenvelope.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSENVELOPE_H_
+#define RHX_CNSENVELOPE_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+
+// Samples per bin at the finest envelope level. Each level above halves the number of bins.
+const int EnvelopeBaseBinSize = 256;
+
+// Extension of the envelope file written next to amplifier.dat.
+const char * const EnvelopeFileExtension = ".envelope";
+
+// Envelope of one channel over one bin, in amplifier units (0.195 uV/bit).
+struct EnvelopeBin
+{
+    int16_t min;
+    int16_t max;
+    float rms;
+};
+
+// Min/max/RMS envelope pyramid of amplifier.dat, read back from its envelope file.
+// Level k has bins of EnvelopeBaseBinSize << k samples; bins are stored in frames (one frame
+// per bin, channel index varying fastest), so a time span of all channels is one contiguous read.
+// The envelope file records the size and modification time of the data file it was built from,
+// and is ignored once they no longer match.
+class IntanEnvelope
+{
+public:
+    IntanEnvelope();
+
+    // Open the envelope file of dataFilename. Returns false if there is none, or it is out of date.
+    bool open(const std::string& dataFilename);
+    void close();
+    bool isOpen() const { return m_file.is_open(); }
+
+    int numChannels() const { return m_numChannels; }
+    int numLevels() const { return (int) m_levels.size(); }
+    int64_t binSize(int level) const { return (int64_t) EnvelopeBaseBinSize << level; }
+    int64_t numBins(int level) const { return m_levels[level].numBins; }
+
+    // Finest level that covers numSamples samples in at most maxBins bins.
+    int selectLevel(int64_t numSamples, int maxBins) const;
+
+    // Read bins [firstBin, firstBin + nBins) of a level (clipped to the level) into bins.
+    // Returns the number of bins read.
+    int64_t read(int level, int64_t firstBin, int64_t nBins, std::vector<EnvelopeBin>& bins);
+
+    // Envelope of samples [startSample, startSample + numSamples) at the resolution that gives at
+    // most maxBins bins. Returns the level used; firstBinSample is the first sample of bins[0].
+    int query(int64_t startSample, int64_t numSamples, int maxBins, std::vector<EnvelopeBin>& bins, int64_t& firstBinSample);
+
+    static std::string envelopeFilename(const std::string& dataFilename) { return dataFilename + EnvelopeFileExtension; }
+
+private:
+    struct Level
+    {
+        int64_t numBins;
+        int64_t offset;
+    };
+
+    std::ifstream m_file;
+    int m_numChannels;
+    std::vector<Level> m_levels;
+};
+
+// Builds the envelope file of the amplifier data next to a header file, on a background thread.
+// The data file is read once; every level is computed in the same pass.
+class EnvelopeBuilder
+{
+public:
+    EnvelopeBuilder();
+    ~EnvelopeBuilder();
+
+    // Start building, unless the envelope file is already up to date. Returns immediately.
+    void start(const std::string& headerFilename);
+    void cancel();
+    void wait();
+
+    bool isRunning() const { return m_running; }
+    double progress() const { return m_progress; }      // 0 to 1
+    std::string error() const;
+
+    // Build the envelope file in the calling thread. Will throw() on fail.
+    static void build(const std::string& headerFilename, const std::atomic<bool>* cancel, std::atomic<double>* progress);
+
+private:
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_cancel;
+    std::atomic<double> m_progress;
+    mutable std::mutex m_errorMutex;
+    std::string m_error;
+};
+
+
+#endif /* RHX_CNSENVELOPE_H_ */
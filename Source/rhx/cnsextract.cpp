@@ -0,0 +1,202 @@
+/*
+ * cnsextract.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <fstream>
+#include <exception>
+#include <filesystem>
+#include <algorithm>
+#include <vector>
+#include <map>
+#include <cerrno>
+#ifdef __linux__
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "cnsrhx.h"
+#include "cnsreader.h"
+#include "cnsextract.h"
+using namespace std;
+
+
+// Buffer size of the plain copy, when the file system cannot copy ranges itself.
+static const int64_t ExtractCopyBufferSize = 1 << 20;
+
+static void copyRangeBuffered(const string& source, const string& destination, int64_t offset, int64_t length)
+{
+    ifstream in(source, ios::in | ios::binary);
+    ofstream out(destination, ios::out | ios::binary | ios::trunc);
+    if (!in || !out)
+        throw std::runtime_error("Extract Error: cannot copy " + source);
+    in.seekg(offset, ios::beg);
+    vector<char> buffer((size_t) min(length, ExtractCopyBufferSize));
+    while (length > 0)
+    {
+        streamsize n = (streamsize) min<int64_t>(length, (int64_t) buffer.size());
+        if (!in.read(buffer.data(), n) || !out.write(buffer.data(), n))
+            throw std::runtime_error("Extract Error: cannot copy " + source);
+        length -= n;
+    }
+}
+
+// Copy length bytes from offset in source to a new destination file.
+static void copyRange(const string& source, const string& destination, int64_t offset, int64_t length)
+{
+#ifdef __linux__
+    int in = open(source.c_str(), O_RDONLY);
+    if (in < 0)
+        throw std::runtime_error("Extract Error: cannot open " + source);
+    int out = open(destination.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0)
+    {
+        ::close(in);
+        throw std::runtime_error("Extract Error: cannot create " + destination);
+    }
+
+    loff_t inOffset = offset;
+    loff_t outOffset = 0;
+    int64_t remaining = length;
+    bool unsupported = false;
+    while (remaining > 0)
+    {
+        ssize_t n = copy_file_range(in, &inOffset, out, &outOffset, (size_t) remaining, 0);
+        if (n < 0 && remaining == length && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP))
+        {
+            unsupported = true;
+            break;
+        }
+        if (n <= 0)
+        {
+            ::close(in);
+            ::close(out);
+            throw std::runtime_error("Extract Error: cannot copy " + source);
+        }
+        remaining -= n;
+    }
+    ::close(in);
+    ::close(out);
+    if (!unsupported)
+        return;
+#endif
+    copyRangeBuffered(source, destination, offset, length);
+}
+
+static void writeRebasedTimestamps(const string& source, const string& destination, int64_t firstSample, int64_t numSamples)
+{
+    vector<int32_t> timestamps((size_t) numSamples);
+    ifstream in(source, ios::in | ios::binary);
+    in.seekg(firstSample * (int64_t) sizeof(int32_t), ios::beg);
+    if (!in.read((char *)timestamps.data(), (streamsize) numSamples * sizeof(int32_t)))
+        throw std::runtime_error("Extract Error: cannot read " + source);
+    if (numSamples > 0)
+    {
+        const int32_t first = timestamps[0];
+        for (int32_t& t : timestamps)
+            t -= first;
+    }
+    ofstream out(destination, ios::out | ios::binary | ios::trunc);
+    if (!out.write((const char *)timestamps.data(), (streamsize) numSamples * sizeof(int32_t)))
+        throw std::runtime_error("Extract Error: cannot write " + destination);
+}
+
+// Bytes per sample of the data file of each signal type, from the header's enabled channels; 0 for a
+// signal type the recording has no channels of.
+static map<string, int64_t> dataFileFrameSizes(const IntanHeaderInfo& info)
+{
+    const int64_t word = (int64_t) sizeof(int16_t);
+    const int64_t amplifier = word * (int64_t) enabledAmplifierChannels(info).size();
+    map<string, int64_t> sizes;
+    sizes["time.dat"] = (int64_t) sizeof(int32_t);
+    sizes["amplifier.dat"] = amplifier;
+    sizes["auxiliary.dat"] = word * info.numEnabledAuxInputChannels;
+    sizes["supply.dat"] = word * info.numEnabledSupplyVoltageChannels;
+    sizes["analogin.dat"] = word * info.numEnabledBoardAdcChannels;
+    sizes["analogout.dat"] = word * info.numEnabledBoardDacChannels;
+    sizes["digitalin.dat"] = (info.numEnabledDigitalInChannels > 0) ? word : 0;
+    sizes["digitalout.dat"] = (info.numEnabledDigitalOutChannels > 0) ? word : 0;
+    sizes["stim.dat"] = (info.fileType == RHSHeaderFile) ? amplifier : 0;
+    sizes["dcamplifier.dat"] = (info.fileType == RHSHeaderFile && info.dcAmplifierDataSaved) ? amplifier : 0;
+    return sizes;
+}
+
+ExtractResult extractTimeRange(const string& headerFilename, const string& outputDirectory,
+                               int64_t firstSample, int64_t numSamples, const ExtractOptions& options)
+{
+    IntanHeaderInfo info;
+    readIntanHeader(headerFilename.c_str(), info);
+    if (!info.headerOnly)
+        throw std::runtime_error("Extract Error: the header file holds data. Only the one file per signal type format is implemented.");
+    filesystem::path header(headerFilename);
+    filesystem::path directory = header.parent_path();
+    filesystem::path output(outputDirectory);
+
+    // Length of the recording, from time.dat or else amplifier.dat.
+    const map<string, int64_t> frameSizes = dataFileFrameSizes(info);
+    const int64_t amplifierFrameSize = frameSizes.at("amplifier.dat");
+    if (amplifierFrameSize > 0 && !filesystem::exists(directory / "amplifier.dat"))
+        throw std::runtime_error("Extract Error: cannot find amplifier.dat. Only the uncompressed one file per signal type format is implemented.");
+    int64_t totalSamples = -1;
+    error_code ec;
+    if (filesystem::exists(directory / "time.dat"))
+        totalSamples = (int64_t) filesystem::file_size(directory / "time.dat") / (int64_t) sizeof(int32_t);
+    else if (amplifierFrameSize > 0)
+        totalSamples = (int64_t) filesystem::file_size(directory / "amplifier.dat") / amplifierFrameSize;
+    if (totalSamples < 0)
+        throw std::runtime_error("Extract Error: cannot find time.dat or amplifier.dat. Only the one file per signal type format is implemented.");
+
+    // Every data file must hold a frame for each sample, before anything is written.
+    vector<filesystem::path> sources;
+    vector<string> skipped;
+    for (const filesystem::directory_entry& entry : filesystem::directory_iterator(directory))
+    {
+        if (!entry.is_regular_file() || entry.path().extension() != ".dat")
+            continue;
+        const string name = entry.path().filename().string();
+        auto it = frameSizes.find(name);
+        if (it == frameSizes.end())
+        {
+            skipped.push_back(name);
+            continue;
+        }
+        const int64_t size = (int64_t) entry.file_size();
+        if (it->second == 0 || size != totalSamples * it->second)
+            throw std::runtime_error("Extract Error: " + name + " does not hold one frame of " + to_string(it->second) +
+                                     " bytes (per the header's channels) for each of the " + to_string(totalSamples) + " samples");
+        sources.push_back(entry.path());
+    }
+    sort(skipped.begin(), skipped.end());
+
+    ExtractResult result;
+    int64_t first = max<int64_t>(0, min(firstSample, totalSamples));
+    int64_t end = max(first, min(firstSample + max<int64_t>(numSamples, 0), totalSamples));
+    if (options.alignToDataBlocks && info.samplesPerDataBlock > 0)
+    {
+        const int64_t block = info.samplesPerDataBlock;
+        first = first / block * block;
+        end = min((end + block - 1) / block * block, totalSamples);
+    }
+    result.firstSample = first;
+    result.numSamples = end - first;
+
+    filesystem::create_directories(output);
+    if (filesystem::equivalent(directory, output, ec))
+        throw std::runtime_error("Extract Error: the output directory must not be the recording directory");
+    filesystem::copy_file(header, output / header.filename(), filesystem::copy_options::overwrite_existing);
+
+    for (const filesystem::path& path : sources)
+    {
+        const int64_t bytesPerFrame = frameSizes.at(path.filename().string());
+        string source = path.string();
+        string destination = (output / path.filename()).string();
+        if (options.rebaseTimestamps && path.filename() == "time.dat")
+            writeRebasedTimestamps(source, destination, result.firstSample, result.numSamples);
+        else
+            copyRange(source, destination, result.firstSample * bytesPerFrame, result.numSamples * bytesPerFrame);
+        result.numFiles++;
+        result.bytesCopied += result.numSamples * bytesPerFrame;
+    }
+    result.skippedFiles = skipped;
+    return result;
+}
@@ -0,0 +1,43 @@
+/*
+ * cnsextract.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSEXTRACT_H_
+#define RHX_CNSEXTRACT_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+struct ExtractOptions
+{
+    bool alignToDataBlocks = true;      // widen the window to whole data blocks of the recording
+    bool rebaseTimestamps = false;      // make the first timestamp of the segment 0
+};
+
+struct ExtractResult
+{
+    int64_t firstSample = 0;            // window actually extracted
+    int64_t numSamples = 0;
+    int numFiles = 0;                   // data files cut, including time.dat
+    int64_t bytesCopied = 0;
+    std::vector<std::string> skippedFiles;  // .dat files next to the header that were not cut (spike.dat, ...)
+};
+
+// Cut samples firstSample .. firstSample + numSamples - 1 out of a "one file per signal type" recording
+// into outputDirectory: the header file, and each data file of a signal type next to it (amplifier.dat,
+// auxiliary.dat, supply.dat, analogin.dat, analogout.dat, digitalin.dat, digitalout.dat, stim.dat,
+// dcamplifier.dat and time.dat). Each holds one frame per sample, of a size set by the header's enabled
+// channels, so the segment of each file is a single byte range; it is copied with copy_file_range() where the system
+// has it, which shares the extents instead of copying them on copy-on-write file systems (btrfs, XFS).
+// time.dat is rewritten rather than copied when the timestamps are rebased.
+// Other .dat files are not cut, and are listed in skippedFiles: spike.dat holds spike records, not frames.
+// The window is clipped to the recording. Will throw() on fail, including when a data file does not hold
+// as many whole frames as time.dat (or amplifier.dat) has samples.
+ExtractResult extractTimeRange(const std::string& headerFilename, const std::string& outputDirectory,
+                               int64_t firstSample, int64_t numSamples, const ExtractOptions& options);
+
+
+#endif /* RHX_CNSEXTRACT_H_ */
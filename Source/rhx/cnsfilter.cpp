@@ -0,0 +1,293 @@
+/*
+ * cnsfilter.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <cmath>
+#include <algorithm>
+#include "rhxglobals.h"
+#include "cnsfilter.h"
+using namespace std;
+
+
+// Biquad over frames, shared by the runtime and compile-time coefficient paths. Inlined, so that
+// constant coefficients are folded into the loop.
+static inline void biquadFrames(float* data, int nSamples, int nc,
+                               float b0, float b1, float b2, float a1, float a2,
+                               float* in1, float* in2, float* out1, float* out2)
+{
+    for (int t = 0; t < nSamples; t++)
+    {
+        float* frame = data + (size_t) t * nc;
+        for (int c = 0; c < nc; c++)
+        {
+            float x = frame[c];
+            float y = b0 * x + b1 * in1[c] + b2 * in2[c] - a1 * out1[c] - a2 * out2[c];
+            in2[c] = in1[c];
+            in1[c] = x;
+            out2[c] = out1[c];
+            out1[c] = y;
+            frame[c] = y;
+        }
+    }
+}
+
+
+MultichannelNotchFilter::MultichannelNotchFilter()
+: m_numChannels(0)
+, m_warmUpLength(0)
+, m_primed(false)
+, m_b0(1.0F), m_b1(0.0F), m_b2(0.0F), m_a1(0.0F), m_a2(0.0F)
+, m_rate(-1)
+, m_notch(-1)
+{
+}
+
+// Coefficients are those of the RHX software notch filter.
+void MultichannelNotchFilter::setParameters(double notchFreq, double bandwidth, double sampleRate, int numChannels)
+{
+    double d = exp(-Pi * bandwidth / sampleRate);
+    double b = (1.0 + d * d) * cos(TwoPi * notchFreq / sampleRate);
+    double a = (1.0 + d * d) / 2.0;
+
+    m_b0 = (float) a;
+    m_b1 = (float) (-2.0 * a * cos(TwoPi * notchFreq / sampleRate));
+    m_b2 = (float) a;
+    m_a1 = (float) -b;
+    m_a2 = (float) (d * d);
+
+    // Pole radius is d, so the transient decays as d^n.
+    m_warmUpLength = (int) ceil(-3.0 / log(d));
+
+    m_rate = -1;
+    m_notch = -1;
+    resizeState(numChannels);
+}
+
+void MultichannelNotchFilter::setParameters(NotchFrequency notch, AmplifierSampleRate rate, int numChannels)
+{
+    const NotchCoefficients& k = rateCoefficients(rate).notch[notch];
+    m_b0 = (float) k.b0;
+    m_b1 = (float) k.b1;
+    m_b2 = (float) k.b2;
+    m_a1 = (float) k.a1;
+    m_a2 = (float) k.a2;
+    m_warmUpLength = k.warmUpLength;
+
+    m_rate = (int) rate;
+    m_notch = (int) notch;
+    resizeState(numChannels);
+}
+
+void MultichannelNotchFilter::resizeState(int numChannels)
+{
+    m_numChannels = numChannels;
+    m_in1.assign(numChannels, 0.0F);
+    m_in2.assign(numChannels, 0.0F);
+    m_out1.assign(numChannels, 0.0F);
+    m_out2.assign(numChannels, 0.0F);
+    reset();
+}
+
+template <int Rate, int Notch>
+void MultichannelNotchFilter::filterTabulated(float* data, int nSamples)
+{
+    constexpr NotchCoefficients k = RateCoefficientTable[Rate].notch[Notch];
+    biquadFrames(data, nSamples, m_numChannels, (float) k.b0, (float) k.b1, (float) k.b2, (float) k.a1, (float) k.a2,
+                m_in1.data(), m_in2.data(), m_out1.data(), m_out2.data());
+}
+
+void MultichannelNotchFilter::reset()
+{
+    m_primed = false;
+}
+
+void MultichannelNotchFilter::filter(float* data, int nSamples)
+{
+    const int nc = m_numChannels;
+    if (nSamples <= 0 || nc == 0)
+        return;
+
+    float* in1 = m_in1.data();
+    float* in2 = m_in2.data();
+    float* out1 = m_out1.data();
+    float* out2 = m_out2.data();
+
+    // The notch has unity gain at DC, so a constant history equal to the first input is a steady state.
+    if (!m_primed)
+    {
+        for (int c = 0; c < nc; c++)
+            in1[c] = in2[c] = out1[c] = out2[c] = data[c];
+        m_primed = true;
+    }
+
+    // Common sample rates get their own instantiation of the kernel.
+    switch ((m_notch < 0) ? -1 : m_rate * 2 + m_notch)
+    {
+    case SampleRate20000Hz * 2 + Notch50Hz: filterTabulated<SampleRate20000Hz, Notch50Hz>(data, nSamples); break;
+    case SampleRate20000Hz * 2 + Notch60Hz: filterTabulated<SampleRate20000Hz, Notch60Hz>(data, nSamples); break;
+    case SampleRate25000Hz * 2 + Notch50Hz: filterTabulated<SampleRate25000Hz, Notch50Hz>(data, nSamples); break;
+    case SampleRate25000Hz * 2 + Notch60Hz: filterTabulated<SampleRate25000Hz, Notch60Hz>(data, nSamples); break;
+    case SampleRate30000Hz * 2 + Notch50Hz: filterTabulated<SampleRate30000Hz, Notch50Hz>(data, nSamples); break;
+    case SampleRate30000Hz * 2 + Notch60Hz: filterTabulated<SampleRate30000Hz, Notch60Hz>(data, nSamples); break;
+    default:
+        biquadFrames(data, nSamples, nc, m_b0, m_b1, m_b2, m_a1, m_a2, in1, in2, out1, out2);
+        break;
+    }
+}
+
+
+BandwidthEqualizer::BandwidthEqualizer()
+: m_numChannels(0)
+, m_numSections(0)
+, m_warmUpLength(0)
+, m_primed(false)
+{
+}
+
+void BandwidthEqualizer::setParameters(double actualLower, double actualUpper, double targetLower, double targetUpper,
+                                       double sampleRate, int numChannels)
+{
+    m_numChannels = numChannels;
+    m_numSections = 0;
+    m_warmUpLength = 0;
+
+    if (targetLower > 0.0 && actualLower > 0.0 && targetLower != actualLower)
+        addSection(actualLower, targetLower, false, sampleRate);
+    if (targetUpper > 0.0 && actualUpper > 0.0 && targetUpper != actualUpper)
+        addSection(actualUpper, targetUpper, true, sampleRate);
+
+    for (int i = 0; i < m_numSections; i++)
+    {
+        m_in1[i].assign(numChannels, 0.0F);
+        m_out1[i].assign(numChannels, 0.0F);
+    }
+    m_warmUpLength = min(m_warmUpLength, (int) sampleRate);
+    reset();
+}
+
+// High-pass corner: H(s) = (s + wA) / (s + wT), unity at high frequencies.
+// Low-pass corner: H(s) = (wT / wA) (s + wA) / (s + wT), unity at DC.
+void BandwidthEqualizer::addSection(double fActual, double fTarget, bool lowPass, double sampleRate)
+{
+    // Corners at or above Nyquist cannot be represented; keep them just below.
+    double fMax = 0.45 * sampleRate;
+    fActual = min(fActual, fMax);
+    fTarget = min(fTarget, fMax);
+
+    double k = 2.0 * sampleRate;
+    double wA = k * tan(Pi * fActual / sampleRate);
+    double wT = k * tan(Pi * fTarget / sampleRate);
+    double g = lowPass ? wT / wA : 1.0;
+
+    Section& section = m_sections[m_numSections++];
+    section.b0 = (float) (g * (k + wA) / (k + wT));
+    section.b1 = (float) (g * (wA - k) / (k + wT));
+    section.a1 = (float) ((wT - k) / (k + wT));
+    section.dcGain = (float) (g * wA / wT);
+
+    // The section pole sits at the target corner.
+    m_warmUpLength = max(m_warmUpLength, (int) ceil(3.0 * sampleRate / (TwoPi * fTarget)));
+}
+
+void BandwidthEqualizer::reset()
+{
+    m_primed = false;
+}
+
+void BandwidthEqualizer::filter(float* data, int nSamples)
+{
+    const int nc = m_numChannels;
+    if (nSamples <= 0 || nc == 0)
+        return;
+
+    for (int i = 0; i < m_numSections; i++)
+    {
+        const Section& section = m_sections[i];
+        float* in1 = m_in1[i].data();
+        float* out1 = m_out1[i].data();
+
+        // Start each channel from the DC steady state of its first input.
+        if (!m_primed)
+        {
+            for (int c = 0; c < nc; c++)
+            {
+                float x = data[c];
+                in1[c] = x;
+                out1[c] = section.dcGain * x;
+            }
+        }
+
+        const float b0 = section.b0, b1 = section.b1, a1 = section.a1;
+        for (int t = 0; t < nSamples; t++)
+        {
+            float* frame = data + (size_t) t * nc;
+            for (int c = 0; c < nc; c++)
+            {
+                float x = frame[c];
+                float y = b0 * x + b1 * in1[c] - a1 * out1[c];
+                in1[c] = x;
+                out1[c] = y;
+                frame[c] = y;
+            }
+        }
+    }
+    m_primed = true;
+}
+
+
+MultichannelHighpassFilter::MultichannelHighpassFilter()
+: m_numChannels(0)
+, m_warmUpLength(0)
+, m_primed(false)
+, m_b0(1.0F), m_b1(0.0F), m_b2(0.0F), m_a1(0.0F), m_a2(0.0F)
+{
+}
+
+// Second-order Butterworth, from the bilinear transform with the cutoff prewarped.
+void MultichannelHighpassFilter::setParameters(double cutoffFreq, double sampleRate, int numChannels)
+{
+    double k = tan(Pi * cutoffFreq / sampleRate);
+    double q = 1.0 / sqrt(2.0);
+    double norm = 1.0 / (1.0 + k / q + k * k);
+    m_b0 = (float) norm;
+    m_b1 = (float) (-2.0 * norm);
+    m_b2 = (float) norm;
+    m_a1 = (float) (2.0 * (k * k - 1.0) * norm);
+    m_a2 = (float) ((1.0 - k / q + k * k) * norm);
+
+    m_warmUpLength = (int) ceil(3.0 * sampleRate / (TwoPi * cutoffFreq));
+
+    m_numChannels = numChannels;
+    m_in1.assign(numChannels, 0.0F);
+    m_in2.assign(numChannels, 0.0F);
+    m_out1.assign(numChannels, 0.0F);
+    m_out2.assign(numChannels, 0.0F);
+    reset();
+}
+
+void MultichannelHighpassFilter::reset()
+{
+    m_primed = false;
+}
+
+void MultichannelHighpassFilter::filter(float* data, int nSamples)
+{
+    const int nc = m_numChannels;
+    if (nSamples <= 0 || nc == 0)
+        return;
+
+    // Zero output is the steady state for a constant input.
+    if (!m_primed)
+    {
+        for (int c = 0; c < nc; c++)
+        {
+            m_in1[c] = m_in2[c] = data[c];
+            m_out1[c] = m_out2[c] = 0.0F;
+        }
+        m_primed = true;
+    }
+    biquadFrames(data, nSamples, nc, m_b0, m_b1, m_b2, m_a1, m_a2,
+                 m_in1.data(), m_in2.data(), m_out1.data(), m_out2.data());
+}
@@ -0,0 +1,122 @@
+/*
+ * cnsfilter.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSFILTER_H_
+#define RHX_CNSFILTER_H_
+
+#include <vector>
+#include "cnscoefficients.h"
+
+// Bandwidth (in Hz) of the software notch filter used by the RHX software.
+const double NotchFilterBandwidth = 10.0;
+
+// Second-order IIR notch filter applied to blocks of multichannel data, in place.
+// Blocks are in frames (one frame per sample, channel index varying fastest). Filter state
+// is kept per channel, so consecutive blocks are filtered as one continuous signal. The inner
+// loop runs across channels with no dependencies between them, so the compiler can vectorize it.
+class MultichannelNotchFilter
+{
+public:
+    MultichannelNotchFilter();
+
+    // Set notch frequency, bandwidth and sample rate (all in Hz), and clear the filter state.
+    void setParameters(double notchFreq, double bandwidth, double sampleRate, int numChannels);
+
+    // Same, for a 50 or 60 Hz notch of NotchFilterBandwidth, using the precomputed coefficient table.
+    // Filtering at 20, 25 and 30 kHz then runs with the coefficients as compile-time constants.
+    void setParameters(NotchFrequency notch, AmplifierSampleRate rate, int numChannels);
+    int numChannels() const { return m_numChannels; }
+
+    // Clear the filter state. The next sample filtered on each channel is taken as the
+    // steady-state (DC) history, which keeps the start-up transient small.
+    void reset();
+
+    // Number of samples to run through the filter after reset() before its output has settled
+    // (three time constants of the notch poles).
+    int warmUpLength() const { return m_warmUpLength; }
+
+    void filter(float* data, int nSamples);
+
+private:
+    int m_numChannels;
+    int m_warmUpLength;
+    bool m_primed;
+    float m_b0, m_b1, m_b2, m_a1, m_a2;
+    std::vector<float> m_in1, m_in2, m_out1, m_out2;
+
+    // Table entry when set from the coefficient table, or -1.
+    int m_rate;
+    int m_notch;
+
+    void resizeState(int numChannels);
+    template <int Rate, int Notch> void filterTabulated(float* data, int nSamples);
+};
+
+// Second-order Butterworth high-pass filter applied to blocks of multichannel data, in place.
+// Blocks and filter state are handled as in MultichannelNotchFilter.
+class MultichannelHighpassFilter
+{
+public:
+    MultichannelHighpassFilter();
+
+    void setParameters(double cutoffFreq, double sampleRate, int numChannels);
+    void reset();
+    int warmUpLength() const { return m_warmUpLength; }
+    void filter(float* data, int nSamples);
+
+private:
+    int m_numChannels;
+    int m_warmUpLength;
+    bool m_primed;
+    float m_b0, m_b1, m_b2, m_a1, m_a2;
+    std::vector<float> m_in1, m_in2, m_out1, m_out2;
+};
+
+// Equalizer that makes the amplifier's analog passband look as if it had been recorded with
+// different bandwidth settings. The amplifier is modeled as a first-order high-pass at the
+// lower bandwidth and a first-order low-pass at the upper bandwidth; each corner that is moved
+// is replaced with a first-order section H(s) = g (s + wActual) / (s + wTarget), made digital
+// with the (prewarped) bilinear transform. The on-chip DSP offset removal filter is left alone.
+// Blocks and filter state are handled as in MultichannelNotchFilter.
+class BandwidthEqualizer
+{
+public:
+    BandwidthEqualizer();
+
+    // Bandwidths in Hz. A target of zero (or equal to the actual value) leaves that corner alone.
+    void setParameters(double actualLower, double actualUpper, double targetLower, double targetUpper,
+                       double sampleRate, int numChannels);
+    bool isActive() const { return m_numSections > 0; }
+
+    void reset();
+
+    // Three time constants of the slowest section, at most one second of samples.
+    int warmUpLength() const { return m_warmUpLength; }
+
+    void filter(float* data, int nSamples);
+
+private:
+    static const int MaxSections = 2;
+
+    struct Section
+    {
+        float b0, b1, a1;
+        float dcGain;
+    };
+
+    int m_numChannels;
+    int m_numSections;
+    int m_warmUpLength;
+    bool m_primed;
+    Section m_sections[MaxSections];
+    std::vector<float> m_in1[MaxSections];
+    std::vector<float> m_out1[MaxSections];
+
+    void addSection(double fActual, double fTarget, bool lowPass, double sampleRate);
+};
+
+
+#endif /* RHX_CNSFILTER_H_ */
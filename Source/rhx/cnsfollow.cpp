@@ -0,0 +1,129 @@
+/*
+ * cnsfollow.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <exception>
+#include <filesystem>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cmath>
+#include "cnsfollow.h"
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+
+FileWriteWatcher::FileWriteWatcher()
+: m_fd(-1)
+{
+}
+
+FileWriteWatcher::~FileWriteWatcher()
+{
+    close();
+}
+
+void FileWriteWatcher::watch(const vector<string>& filenames)
+{
+    close();
+#ifdef __linux__
+    m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_fd < 0)
+        throw std::runtime_error("Follow Error: cannot start inotify");
+    for (const string& filename : filenames)
+    {
+        if (filesystem::exists(filename) && inotify_add_watch(m_fd, filename.c_str(), IN_MODIFY | IN_CLOSE_WRITE) < 0)
+            throw std::runtime_error("Follow Error: cannot watch " + filename);
+    }
+#else
+    (void) filenames;
+#endif
+}
+
+void FileWriteWatcher::close()
+{
+#ifdef __linux__
+    if (m_fd >= 0)
+        ::close(m_fd);
+#endif
+    m_fd = -1;
+}
+
+bool FileWriteWatcher::wait(int timeout)
+{
+#ifdef __linux__
+    if (m_fd >= 0)
+    {
+        pollfd p = { m_fd, POLLIN, 0 };
+        if (poll(&p, 1, max(timeout, 0)) <= 0)
+            return false;
+
+        // Drain the events; which file was written does not matter.
+        char events[4096];
+        while (read(m_fd, events, sizeof(events)) > 0)
+            ;
+        return true;
+    }
+#endif
+    this_thread::sleep_for(chrono::milliseconds(max(timeout, 0)));
+    return false;
+}
+
+
+RecordingFollower::RecordingFollower()
+: m_reader(nullptr)
+, m_lag(DefaultFollowLag)
+, m_lagSamples(0)
+{
+}
+
+void RecordingFollower::start(IntanDataReader& reader, double lag)
+{
+    stop();
+    if (reader.isCompressed())
+        throw std::runtime_error("Follow Error: " + reader.amplifierFilename() + " is compressed and cannot grow");
+
+    vector<string> filenames(1, reader.amplifierFilename());
+    filenames.push_back((filesystem::path(reader.directory()) / "time.dat").string());
+    m_watcher.watch(filenames);
+
+    m_reader = &reader;
+    m_lag = max(lag, 0.0);
+    m_lagSamples = (int64_t) llround(m_lag * reader.sampleRate());
+    m_reader->refresh();
+}
+
+void RecordingFollower::stop()
+{
+    m_watcher.close();
+    m_reader = nullptr;
+}
+
+int64_t RecordingFollower::playableSamples()
+{
+    if (!m_reader)
+        return 0;
+    m_reader->refresh();
+    return max<int64_t>(m_reader->numSamples() - m_lagSamples, 0);
+}
+
+int64_t RecordingFollower::waitFor(int64_t end, int timeout)
+{
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout);
+    int64_t playable = playableSamples();
+    while (m_reader && playable < end)
+    {
+        int remaining = (int) chrono::duration_cast<chrono::milliseconds>(deadline - chrono::steady_clock::now()).count();
+        if (remaining <= 0)
+            break;
+        m_watcher.wait(min(remaining, FollowPollInterval));
+        playable = playableSamples();
+    }
+    return playable;
+}
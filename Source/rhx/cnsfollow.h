@@ -0,0 +1,71 @@
+/*
+ * cnsfollow.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSFOLLOW_H_
+#define RHX_CNSFOLLOW_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "cnsreader.h"
+
+// Default distance kept between playback and the newest block written.
+const double DefaultFollowLag = 0.3;    // seconds
+
+// Longest wait between checks of the file sizes. inotify only reports writes made through the local
+// kernel, so a recording written by another machine (NFS, SMB) is picked up by this poll instead.
+const int FollowPollInterval = 50;      // ms
+
+// Waits for writes to a set of files: inotify on Linux, a plain sleep elsewhere.
+class FileWriteWatcher
+{
+public:
+    FileWriteWatcher();
+    ~FileWriteWatcher();
+
+    // Watch filenames for writes. Files that do not exist are skipped. Will throw() on fail.
+    void watch(const std::vector<std::string>& filenames);
+    void close();
+
+    // Wait until a watched file is written to, or timeout (ms) passes. Returns true if a write was seen.
+    bool wait(int timeout);
+
+private:
+    int m_fd;
+};
+
+// Follows a recording that RHX is still writing (live-follow mode). The reader's sample count is
+// extended as whole data blocks are written, and playback is held lag seconds behind the newest block,
+// so that a block is only read once it is complete in every file, with latency bounded by the lag
+// plus FollowPollInterval.
+class RecordingFollower
+{
+public:
+    RecordingFollower();
+
+    // Start following the recording open in reader, which must outlive the follower (or be stopped
+    // first). Will throw() if the reader is reading compressed files.
+    void start(IntanDataReader& reader, double lag = DefaultFollowLag);
+    void stop();
+    bool isActive() const { return m_reader != nullptr; }
+
+    double lag() const { return m_lag; }
+
+    // Samples that may be played: those written, less the lag. Refreshes the reader first.
+    int64_t playableSamples();
+
+    // Wait until sample end - 1 is playable, or timeout (ms) passes. Returns playableSamples().
+    int64_t waitFor(int64_t end, int timeout);
+
+private:
+    IntanDataReader* m_reader;
+    FileWriteWatcher m_watcher;
+    double m_lag;
+    int64_t m_lagSamples;
+};
+
+
+#endif /* RHX_CNSFOLLOW_H_ */
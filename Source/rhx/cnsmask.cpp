@@ -0,0 +1,112 @@
+/*
+ * cnsmask.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include "abstractrhxcontroller.h"
+#include "cnsreader.h"
+#include "cnsmask.h"
+using namespace std;
+
+
+vector<bool> amplifierChannelMask(const string& headerFilename, const IntanHeaderInfo& info, const ChannelMaskOptions& options)
+{
+    vector<HeaderFileChannel> channels = enabledAmplifierChannels(info);
+    vector<bool> mask(channels.size(), false);
+    for (size_t c = 0; c < channels.size(); c++)
+    {
+        double impedance = channels[c].impedanceMagnitude;
+        if (impedance <= 0.0)
+            continue;
+        if ((options.minImpedance > 0.0 && impedance < options.minImpedance) ||
+            (options.maxImpedance > 0.0 && impedance > options.maxImpedance))
+            mask[c] = true;
+    }
+
+    vector<ChannelQc> qc;
+    if (options.maskDead && loadChannelQc(headerFilename, qc) && qc.size() == channels.size())
+    {
+        double sampleRate = AbstractRHXController::getSampleRate(info.sampleRate);
+        for (size_t c = 0; c < qc.size(); c++)
+        {
+            if (channelHealth(qc[c], sampleRate, options.thresholds) == DeadChannel)
+                mask[c] = true;
+        }
+    }
+    return mask;
+}
+
+IntanHeaderInfo maskedHeader(const IntanHeaderInfo& info, const vector<bool>& mask)
+{
+    IntanHeaderInfo masked = info;
+    size_t index = 0;
+    for (HeaderFileGroup& group : masked.groups)
+    {
+        for (HeaderFileChannel& channel : group.channels)
+        {
+            if (!channel.enabled || channel.signalType != AmplifierSignal)
+                continue;
+            if (index < mask.size() && mask[index])
+            {
+                channel.enabled = false;
+                masked.numEnabledAmplifierChannels--;
+            }
+            index++;
+        }
+    }
+    return masked;
+}
+
+vector<int> unmaskedChannels(const vector<bool>& mask)
+{
+    vector<int> channels;
+    for (size_t c = 0; c < mask.size(); c++)
+    {
+        if (!mask[c])
+            channels.push_back((int) c);
+    }
+    return channels;
+}
+
+void unmaskedToMicroVolts(const int16_t* frames, int numChannels, int nSamples, const vector<int>& channels, float* out)
+{
+    const float scale = (float) AmplifierMicroVoltsPerBit;
+    const int nk = (int) channels.size();
+    const int* kept = channels.data();
+    for (int t = 0; t < nSamples; t++, frames += numChannels, out += nk)
+    {
+        for (int k = 0; k < nk; k++)
+            out[k] = scale * frames[kept[k]];
+    }
+}
+
+void microVoltsToUnmasked(const float* in, int nSamples, const vector<int>& channels, int numChannels, int16_t* frames)
+{
+    const int nk = (int) channels.size();
+    vector<int16_t> frame(nk);
+    fill(frames, frames + (size_t) nSamples * numChannels, (int16_t) 0);
+    for (int t = 0; t < nSamples; t++, in += nk, frames += numChannels)
+    {
+        microVoltsToAmplifier(in, frame.data(), nk);
+        for (int k = 0; k < nk; k++)
+            frames[channels[k]] = frame[k];
+    }
+}
+
+void zeroMaskedChannels(int16_t* frames, int nSamples, const vector<bool>& mask)
+{
+    vector<int> masked;
+    for (size_t c = 0; c < mask.size(); c++)
+    {
+        if (mask[c])
+            masked.push_back((int) c);
+    }
+    const int nc = (int) mask.size();
+    for (int t = 0; t < nSamples; t++, frames += nc)
+    {
+        for (int c : masked)
+            frames[c] = 0;
+    }
+}
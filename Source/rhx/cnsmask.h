@@ -0,0 +1,51 @@
+/*
+ * cnsmask.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSMASK_H_
+#define RHX_CNSMASK_H_
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "cnsrhx.h"
+#include "cnsqc.h"
+
+// Which amplifier channels to leave out of reads: masked channels are not read where the data layout
+// allows it (the one file per channel format), are not converted or processed, and read as 0.
+struct ChannelMaskOptions
+{
+    double minImpedance = 0.0;          // ohms; channels with a measured impedance outside
+    double maxImpedance = 0.0;          // [minImpedance, maxImpedance] are masked; 0 = no limit
+    bool maskDead = false;              // mask channels the saved statistics (cnsqc.h) find dead
+    ChannelQcThresholds thresholds;
+
+    bool isActive() const { return minImpedance > 0.0 || maxImpedance > 0.0 || maskDead; }
+};
+
+// One entry per amplifier channel (in frame order), true if the channel is masked. The impedance is
+// from the header's last impedance test; channels never measured (impedance 0) are not masked for
+// it. The statistics are only loaded, not computed: without an up to date info.rhd.qc, no channel is
+// masked as dead.
+std::vector<bool> amplifierChannelMask(const std::string& headerFilename, const IntanHeaderInfo& info,
+                                       const ChannelMaskOptions& options);
+
+// Copy of info with the masked amplifier channels disabled, so that enabledAmplifierChannels(),
+// amplifierGroupRanges() and amplifierChannelIndex() on it give the channels left, in frame order.
+IntanHeaderInfo maskedHeader(const IntanHeaderInfo& info, const std::vector<bool>& mask);
+
+// Indices of the channels left.
+std::vector<int> unmaskedChannels(const std::vector<bool>& mask);
+
+// Convert the channels listed of nSamples frames of numChannels amplifier words to frames of
+// channels.size() values in uV, and back again (masked channels set to 0).
+void unmaskedToMicroVolts(const int16_t* frames, int numChannels, int nSamples, const std::vector<int>& channels, float* out);
+void microVoltsToUnmasked(const float* in, int nSamples, const std::vector<int>& channels, int numChannels, int16_t* frames);
+
+// Set the masked channels of nSamples frames to 0.
+void zeroMaskedChannels(int16_t* frames, int nSamples, const std::vector<bool>& mask);
+
+
+#endif /* RHX_CNSMASK_H_ */
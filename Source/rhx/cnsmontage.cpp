@@ -0,0 +1,263 @@
+/*
+ * cnsmontage.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <fstream>
+#include <sstream>
+#include <exception>
+#include <algorithm>
+#include <map>
+#include "cnsmontage.h"
+using namespace std;
+
+// Cache blocking for the dense kernel: a block of weights (MontageInputBlock x MontageOutputBlock
+// floats, 128 kB) is reused across all samples of the block while it is in L2, and the output row
+// segment being accumulated (MontageOutputBlock floats) stays in L1.
+const int MontageInputBlock = 128;
+const int MontageOutputBlock = 256;
+
+// Dense matrices with fewer nonzero weights than this fraction are run as sparse.
+const double MontageSparseDensity = 0.125;
+
+
+static vector<string> tokenize(const string& line)
+{
+    vector<string> tokens;
+    istringstream iss(line.substr(0, line.find('#')));
+    string token;
+    while (iss >> token)
+        tokens.push_back(token);
+    return tokens;
+}
+
+static float toWeight(const string& s, int lineNumber)
+{
+    try
+    {
+        size_t pos = 0;
+        float w = stof(s, &pos);
+        if (pos == s.size())
+            return w;
+    }
+    catch (std::exception &)
+    {
+    }
+    ostringstream oss;
+    oss << "Montage Error: line " << lineNumber << ": invalid weight " << s;
+    throw std::runtime_error(oss.str());
+}
+
+
+LinearMontage::LinearMontage()
+: m_numInputs(0)
+, m_numOutputs(0)
+, m_sparse(false)
+{
+}
+
+void LinearMontage::clear()
+{
+    m_numInputs = 0;
+    m_numOutputs = 0;
+    m_sparse = false;
+    m_outputNames.clear();
+    m_weightsT.clear();
+    m_rowStart.clear();
+    m_column.clear();
+    m_value.clear();
+}
+
+void LinearMontage::load(const string& filename, const vector<HeaderFileChannel>& inputChannels, const vector<bool>& mask)
+{
+    clear();
+    if (!mask.empty() && mask.size() != inputChannels.size())
+        throw std::runtime_error("Montage Error: channel mask does not match the channels");
+
+    // Column of each channel among those left, -1 if masked.
+    vector<int> column(inputChannels.size());
+    int numInputs = 0;
+    for (size_t i = 0; i < inputChannels.size(); i++)
+        column[i] = (!mask.empty() && mask[i]) ? -1 : numInputs++;
+
+    map<string, int> inputIndex;
+    for (int i = 0; i < (int) inputChannels.size(); i++)
+    {
+        inputIndex.emplace(inputChannels[i].customChannelName, i);
+    }
+    for (int i = 0; i < (int) inputChannels.size(); i++)
+    {
+        inputIndex[inputChannels[i].nativeChannelName] = i;
+    }
+    auto lookup = [&inputIndex](const string& name, int lineNumber) {
+        auto it = inputIndex.find(name);
+        if (it == inputIndex.end())
+        {
+            ostringstream oss;
+            oss << "Montage Error: line " << lineNumber << ": unknown channel " << name;
+            throw std::runtime_error(oss.str());
+        }
+        return it->second;
+    };
+
+    ifstream in(filename);
+    if (!in)
+        throw std::runtime_error("Cannot open montage file " + filename);
+
+    // Weights are collected as (output, input, weight) and packed at the end.
+    struct Entry { int output; int input; float weight; };
+    vector<Entry> entries;
+    vector<int> denseColumns;
+    bool sawKeyword = false;
+    bool dense = false;
+
+    string line;
+    int lineNumber = 0;
+    while (getline(in, line))
+    {
+        lineNumber++;
+        vector<string> tokens = tokenize(line);
+        if (tokens.empty())
+            continue;
+
+        if (!sawKeyword)
+        {
+            if (tokens[0] == "dense")
+            {
+                dense = true;
+                for (size_t i = 1; i < tokens.size(); i++)
+                    denseColumns.push_back(lookup(tokens[i], lineNumber));
+            }
+            else if (tokens[0] != "sparse" || tokens.size() != 1)
+            {
+                ostringstream oss;
+                oss << "Montage Error: line " << lineNumber << ": expected dense or sparse";
+                throw std::runtime_error(oss.str());
+            }
+            sawKeyword = true;
+            continue;
+        }
+
+        int output = (int) m_outputNames.size();
+        m_outputNames.push_back(tokens[0]);
+        if (dense)
+        {
+            if (tokens.size() != denseColumns.size() + 1)
+            {
+                ostringstream oss;
+                oss << "Montage Error: line " << lineNumber << ": expected " << denseColumns.size() << " weights";
+                throw std::runtime_error(oss.str());
+            }
+            for (size_t i = 0; i < denseColumns.size(); i++)
+            {
+                float w = toWeight(tokens[i + 1], lineNumber);
+                if (w != 0.0F && column[denseColumns[i]] >= 0)
+                    entries.push_back({ output, column[denseColumns[i]], w });
+            }
+        }
+        else
+        {
+            if (tokens.size() % 2 != 1)
+            {
+                ostringstream oss;
+                oss << "Montage Error: line " << lineNumber << ": expected channel / weight pairs";
+                throw std::runtime_error(oss.str());
+            }
+            for (size_t i = 1; i < tokens.size(); i += 2)
+            {
+                int input = column[lookup(tokens[i], lineNumber)];
+                float w = toWeight(tokens[i + 1], lineNumber);
+                if (input >= 0)
+                    entries.push_back({ output, input, w });
+            }
+        }
+    }
+    if (m_outputNames.empty())
+        throw std::runtime_error("Montage Error: no output channels in " + filename);
+
+    m_numInputs = numInputs;
+    m_numOutputs = (int) m_outputNames.size();
+    double density = (double) entries.size() / max((double) m_numInputs * m_numOutputs, 1.0);
+    m_sparse = !dense || density < MontageSparseDensity;
+
+    if (m_sparse)
+    {
+        stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.output < b.output; });
+        m_rowStart.assign(m_numOutputs + 1, 0);
+        for (const Entry& e : entries)
+        {
+            m_rowStart[e.output + 1]++;
+            m_column.push_back(e.input);
+            m_value.push_back(e.weight);
+        }
+        for (int m = 0; m < m_numOutputs; m++)
+            m_rowStart[m + 1] += m_rowStart[m];
+    }
+    else
+    {
+        m_weightsT.assign((size_t) m_numInputs * m_numOutputs, 0.0F);
+        for (const Entry& e : entries)
+            m_weightsT[(size_t) e.input * m_numOutputs + e.output] += e.weight;
+    }
+}
+
+void LinearMontage::apply(const float* in, float* out, int nSamples) const
+{
+    if (m_sparse)
+        applySparse(in, out, nSamples);
+    else
+        applyDense(in, out, nSamples);
+}
+
+// Blocked matrix multiply. The innermost loop is an axpy along a contiguous output row segment,
+// which the compiler vectorizes.
+void LinearMontage::applyDense(const float* in, float* out, int nSamples) const
+{
+    const int nIn = m_numInputs;
+    const int nOut = m_numOutputs;
+    fill(out, out + (size_t) nSamples * nOut, 0.0F);
+
+    for (int m0 = 0; m0 < nOut; m0 += MontageOutputBlock)
+    {
+        const int mb = min(MontageOutputBlock, nOut - m0);
+        for (int k0 = 0; k0 < nIn; k0 += MontageInputBlock)
+        {
+            const int k1 = min(k0 + MontageInputBlock, nIn);
+            for (int t = 0; t < nSamples; t++)
+            {
+                const float* x = in + (size_t) t * nIn;
+                float* y = out + (size_t) t * nOut + m0;
+                for (int k = k0; k < k1; k++)
+                {
+                    const float xk = x[k];
+                    const float* w = m_weightsT.data() + (size_t) k * nOut + m0;
+                    for (int m = 0; m < mb; m++)
+                        y[m] += xk * w[m];
+                }
+            }
+        }
+    }
+}
+
+void LinearMontage::applySparse(const float* in, float* out, int nSamples) const
+{
+    const int nIn = m_numInputs;
+    const int nOut = m_numOutputs;
+    const int* rowStart = m_rowStart.data();
+    const int* column = m_column.data();
+    const float* value = m_value.data();
+
+    for (int t = 0; t < nSamples; t++)
+    {
+        const float* x = in + (size_t) t * nIn;
+        float* y = out + (size_t) t * nOut;
+        for (int m = 0; m < nOut; m++)
+        {
+            float sum = 0.0F;
+            for (int j = rowStart[m]; j < rowStart[m + 1]; j++)
+                sum += value[j] * x[column[j]];
+            y[m] = sum;
+        }
+    }
+}
@@ -0,0 +1,71 @@
+/*
+ * cnsmontage.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSMONTAGE_H_
+#define RHX_CNSMONTAGE_H_
+
+#include "cnsrhx.h"
+#include <string>
+#include <vector>
+
+// Linear transform of the amplifier channels (bipolar montage, whitening matrix, ...), applied
+// to blocks of frames: out[t][m] = sum over k of W[m][k] * in[t][k].
+//
+// The montage file is plain text; '#' starts a comment. A dense matrix is given as
+//
+//   dense  A-000 A-001 A-002 ...        (input channel names)
+//   OUT-0  w00   w01   w02   ...        (output channel name, then one weight per input)
+//   ...
+//
+// and a sparse one as
+//
+//   sparse
+//   A-000-A-001  A-000 1  A-001 -1      (output channel name, then input name / weight pairs)
+//   ...
+//
+// Input names are native channel names (custom names are accepted too). Outputs are written
+// back as amplifier words, so whitening matrices should be scaled to give outputs in uV.
+class LinearMontage
+{
+public:
+    LinearMontage();
+
+    // Load the matrix, resolving input names against the amplifier channels. With a channel mask (one
+    // entry per input channel, true if masked; see cnsmask.h), the inputs are the channels left, in
+    // order, and the weights of masked channels are dropped. Will throw() on fail.
+    void load(const std::string& filename, const std::vector<HeaderFileChannel>& inputChannels,
+              const std::vector<bool>& mask = std::vector<bool>());
+    void clear();
+    bool isLoaded() const { return m_numOutputs > 0; }
+    bool isSparse() const { return m_sparse; }
+
+    int numInputs() const { return m_numInputs; }
+    int numOutputs() const { return m_numOutputs; }
+    const std::vector<std::string>& outputNames() const { return m_outputNames; }
+
+    // in holds nSamples frames of numInputs() channels, out receives nSamples frames of numOutputs().
+    void apply(const float* in, float* out, int nSamples) const;
+
+private:
+    int m_numInputs;
+    int m_numOutputs;
+    bool m_sparse;
+    std::vector<std::string> m_outputNames;
+
+    // Dense: weights transposed, numInputs rows of numOutputs.
+    std::vector<float> m_weightsT;
+
+    // Sparse: compressed sparse rows, one row per output.
+    std::vector<int> m_rowStart;
+    std::vector<int> m_column;
+    std::vector<float> m_value;
+
+    void applyDense(const float* in, float* out, int nSamples) const;
+    void applySparse(const float* in, float* out, int nSamples) const;
+};
+
+
+#endif /* RHX_CNSMONTAGE_H_ */
@@ -0,0 +1,180 @@
+/*
+ * cnsoptions.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <fstream>
+#include <sstream>
+#include <exception>
+#include "cnsoptions.h"
+using namespace std;
+
+
+static string trim(const string& s)
+{
+    size_t b = s.find_first_not_of(" \t\r\n");
+    if (b == string::npos)
+        return "";
+    size_t e = s.find_last_not_of(" \t\r\n");
+    return s.substr(b, e - b + 1);
+}
+
+static void badValue(int lineNumber, const string& key, const string& value)
+{
+    ostringstream oss;
+    oss << "Options Error: line " << lineNumber << ": invalid value for " << key << ": " << value;
+    throw std::runtime_error(oss.str());
+}
+
+static double toNonNegativeDouble(int lineNumber, const string& key, const string& value)
+{
+    try
+    {
+        size_t pos = 0;
+        double d = stod(value, &pos);
+        if (pos == value.size() && d >= 0.0)
+            return d;
+    }
+    catch (std::exception &)
+    {
+    }
+    badValue(lineNumber, key, value);
+    return 0.0;
+}
+
+bool readProcessingOptions(const string& filename, IntanProcessingOptions& options)
+{
+    ifstream in(filename);
+    if (!in)
+        return false;
+
+    string line;
+    int lineNumber = 0;
+    while (getline(in, line))
+    {
+        lineNumber++;
+        size_t hash = line.find('#');
+        if (hash != string::npos)
+            line.erase(hash);
+        line = trim(line);
+        if (line.empty())
+            continue;
+
+        size_t eq = line.find('=');
+        if (eq == string::npos)
+        {
+            ostringstream oss;
+            oss << "Options Error: line " << lineNumber << ": expected key = value";
+            throw std::runtime_error(oss.str());
+        }
+        string key = trim(line.substr(0, eq));
+        string value = trim(line.substr(eq + 1));
+
+        if (key == "notch")
+        {
+            if (value == "header") options.notchFromHeader = true;
+            else if (value == "off") options.notchFromHeader = false;
+            else badValue(lineNumber, key, value);
+        }
+        else if (key == "reference")
+        {
+            if (value == "none") options.referenceMode = NoReference;
+            else if (value == "car") options.referenceMode = GroupAverageReference;
+            else if (value == "median") options.referenceMode = GroupMedianReference;
+            else if (value == "channel") options.referenceMode = SingleChannelReference;
+            else badValue(lineNumber, key, value);
+        }
+        else if (key == "referenceChannel")
+        {
+            options.referenceChannelName = value;
+        }
+        else if (key == "montage")
+        {
+            options.montageFileName = value;
+        }
+        else if (key == "targetLowerBandwidth")
+        {
+            options.targetLowerBandwidth = toNonNegativeDouble(lineNumber, key, value);
+        }
+        else if (key == "targetUpperBandwidth")
+        {
+            options.targetUpperBandwidth = toNonNegativeDouble(lineNumber, key, value);
+        }
+        else if (key == "spikeDetection")
+        {
+            if (value == "on") options.spikeDetection = true;
+            else if (value == "off") options.spikeDetection = false;
+            else badValue(lineNumber, key, value);
+        }
+        else if (key == "spikeRefractory")
+        {
+            options.spikeRefractory = toNonNegativeDouble(lineNumber, key, value);
+        }
+        else if (key == "spikeFile")
+        {
+            options.spikeFileName = (value == "none") ? "" : value;
+        }
+        else if (key == "envelope")
+        {
+            if (value == "on") options.buildEnvelope = true;
+            else if (value == "off") options.buildEnvelope = false;
+            else badValue(lineNumber, key, value);
+        }
+        else if (key == "channelQc")
+        {
+            if (value == "on") options.channelQc = true;
+            else if (value == "off") options.channelQc = false;
+            else badValue(lineNumber, key, value);
+        }
+        else if (key == "maskImpedanceMin")
+        {
+            options.maskImpedanceMin = toNonNegativeDouble(lineNumber, key, value);
+        }
+        else if (key == "maskImpedanceMax")
+        {
+            options.maskImpedanceMax = toNonNegativeDouble(lineNumber, key, value);
+        }
+        else if (key == "maskDead")
+        {
+            if (value == "on") options.maskDead = true;
+            else if (value == "off") options.maskDead = false;
+            else badValue(lineNumber, key, value);
+        }
+        else if (key == "lfp")
+        {
+            if (value == "on") options.lfp = true;
+            else if (value == "off") options.lfp = false;
+            else badValue(lineNumber, key, value);
+        }
+        else if (key == "resampleRate")
+        {
+            options.resampleRate = toNonNegativeDouble(lineNumber, key, value);
+        }
+        else if (key == "follow")
+        {
+            if (value == "on") options.follow = true;
+            else if (value == "off") options.follow = false;
+            else badValue(lineNumber, key, value);
+        }
+        else if (key == "followLag")
+        {
+            options.followLag = toNonNegativeDouble(lineNumber, key, value);
+        }
+        else if (key == "sharedMemory")
+        {
+            options.sharedMemoryName = (value == "none") ? "" : value;
+        }
+        else if (key == "sharedMemoryLength")
+        {
+            options.sharedMemoryLength = toNonNegativeDouble(lineNumber, key, value);
+        }
+        else
+        {
+            ostringstream oss;
+            oss << "Options Error: line " << lineNumber << ": unknown option " << key;
+            throw std::runtime_error(oss.str());
+        }
+    }
+    return true;
+}
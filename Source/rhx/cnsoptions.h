@@ -0,0 +1,74 @@
+/*
+ * cnsoptions.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSOPTIONS_H_
+#define RHX_CNSOPTIONS_H_
+
+#include <string>
+
+// Name of the optional processing options file, looked for next to info.rhd.
+const char * const ProcessingOptionsFileName = "intanreader.txt";
+
+enum ReferenceMode {
+    NoReference,
+    GroupAverageReference,      // subtract the mean of the group (port) at each sample
+    GroupMedianReference,       // subtract the median of the group (port) at each sample
+    SingleChannelReference      // subtract one channel from all channels
+};
+
+// Read-time processing options. The options file is plain text, one "key = value" per line;
+// '#' starts a comment. Keys not present keep the defaults below.
+//
+//   notch = header | off                  (header: use the notch setting saved by RHX)
+//   reference = none | car | median | channel
+//   referenceChannel = A-000              (native channel name; default is the header's refChannelName)
+//   montage = montage.txt                 (linear montage file, relative to the options file; see cnsmontage.h)
+//   targetLowerBandwidth = 1.0            (Hz; equalize the amplifier lower bandwidth to this value)
+//   targetUpperBandwidth = 7500           (Hz; equalize the amplifier upper bandwidth to this value)
+//   spikeDetection = off | on             (on: threshold spike detection from the header's spike scope settings)
+//   spikeRefractory = 1.0                 (ms; minimum interval between spikes on one channel)
+//   spikeFile = spike.dat | none          (spikes saved by RHX, reported as events when spikeDetection is off)
+//   envelope = off | on                   (on: build the min/max/RMS envelope file in the background; see cnsenvelope.h)
+//   channelQc = off | on                  (on: report dead, noisy and saturated channels, scanning once; see cnsqc.h)
+//   maskImpedanceMin = 0                  (kOhm; mask channels measured below this impedance; see cnsmask.h)
+//   maskImpedanceMax = 0                  (kOhm; mask channels measured above this impedance; 0 = no limit)
+//   maskDead = off | on                   (on: mask the channels the saved channel statistics find dead)
+//   lfp = off | on                        (on: add a second record, decimated to about 2 kHz; see cnsdecimate.h)
+//   resampleRate = 30000                  (Hz; resample the amplifier record to this rate; see cnsresample.h)
+//   follow = off | on                     (on: play a recording while RHX is still writing it; see cnsfollow.h)
+//   followLag = 300                       (ms; how far playback stays behind the newest block written)
+//   sharedMemory = intan | none           (publish the samples played to a shared memory ring; see cnsshm.h)
+//   sharedMemoryLength = 1000             (ms; samples the shared memory ring holds)
+struct IntanProcessingOptions
+{
+    bool notchFromHeader = true;
+    ReferenceMode referenceMode = NoReference;
+    std::string referenceChannelName;
+    std::string montageFileName;
+    double targetLowerBandwidth = 0.0;      // 0 = no equalization
+    double targetUpperBandwidth = 0.0;
+    bool spikeDetection = false;
+    double spikeRefractory = 1.0;           // ms
+    std::string spikeFileName = "spike.dat";    // empty = none
+    bool buildEnvelope = false;
+    bool channelQc = false;
+    double maskImpedanceMin = 0.0;          // kOhm; 0 = no limit
+    double maskImpedanceMax = 0.0;          // kOhm; 0 = no limit
+    bool maskDead = false;
+    bool lfp = false;
+    double resampleRate = 0.0;              // 0 = amplifier sample rate
+    bool follow = false;
+    double followLag = 300.0;               // ms
+    std::string sharedMemoryName;           // empty = none
+    double sharedMemoryLength = 1000.0;     // ms
+};
+
+// Read options from filename into options. Missing file leaves options unchanged and returns false.
+// Will throw() on a malformed line or unknown key.
+bool readProcessingOptions(const std::string& filename, IntanProcessingOptions& options);
+
+
+#endif /* RHX_CNSOPTIONS_H_ */
@@ -0,0 +1,160 @@
+/*
+ * cnsperievent.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+#include <thread>
+#include "cnsrhx.h"
+#include "cnsreader.h"
+#include "cnschunked.h"
+#include "cnsbatch.h"
+#include "cnstranscode.h"
+#include "cnsdigital.h"
+#include "cnsperievent.h"
+using namespace std;
+
+
+// Digital input words scanned at a time.
+const int EdgeScanBlockSize = 1 << 20;
+
+vector<int64_t> findDigitalEdges(const string& headerFilename, int line, bool rising)
+{
+    if (line < 0 || line > 15)
+        throw std::runtime_error("Peri-event Error: digital input line must be 0 to 15");
+
+    // DigitalLineReader finds the digital input data in any layout, and packs one word per sample.
+    DigitalLineReader reader;
+    reader.open(headerFilename);
+    const uint16_t mask = (uint16_t) (1 << line);
+    if (!(reader.lines() & mask))
+        throw std::runtime_error("Peri-event Error: cannot find the data of digital input line " + to_string(line));
+
+    vector<int64_t> edges;
+    vector<uint16_t> words(EdgeScanBlockSize);
+    bool previous = false;
+    int64_t sample = 0;
+    while (true)
+    {
+        const int64_t n = reader.readWords(sample, (int64_t) words.size(), words.data());
+        if (n <= 0)
+            break;
+        for (int64_t i = 0; i < n; i++)
+        {
+            const bool level = (words[i] & mask) != 0;
+            if (sample + i > 0 && level != previous && level == rising)
+                edges.push_back(sample + i);
+            previous = level;
+        }
+        sample += n;
+    }
+    return edges;
+}
+
+void computePeriEvent(const string& headerFilename, const vector<int64_t>& events, const PeriEventOptions& options,
+                      PeriEventResult& result, const atomic<bool>* cancel, atomic<double>* progress)
+{
+    if (options.preSamples < 0 || options.postSamples < 0 || options.preSamples + options.postSamples <= 0)
+        throw std::runtime_error("Peri-event Error: empty window");
+    const int numThreads = ChunkedFileReader::numThreadsToUse(options.numThreads);
+
+    BatchWindowReader reader;
+    reader.open(headerFilename, numThreads);
+    vector<int> channels = options.channels;
+    if (channels.empty())
+    {
+        for (int c = 0; c < reader.numAmplifierChannels(); c++)
+            channels.push_back(c);
+    }
+    const int nc = (int) channels.size();
+    if (nc == 0)
+        throw std::runtime_error("Peri-event Error: no amplifier channels");
+    const int64_t length = options.preSamples + options.postSamples;
+
+    result = PeriEventResult();
+    result.numChannels = nc;
+    result.windowLength = length;
+    for (int64_t event : events)
+    {
+        if (event - options.preSamples >= 0 && event + options.postSamples <= reader.numSamples())
+            result.events.push_back(event);
+        else
+            result.numSkipped++;
+    }
+    const int64_t numEvents = (int64_t) result.events.size();
+    const int64_t planeSize = (int64_t) nc * length;
+    if (options.keepSnippets)
+        result.snippets.resize((size_t) (numEvents * planeSize));
+
+    // Exact sums of words and squared words: no rounding however many events are added.
+    vector<int64_t> sums((size_t) planeSize, 0), squares((size_t) planeSize, 0);
+    vector<int16_t> scratch;
+    if (!options.keepSnippets)
+        scratch.resize((size_t) (PeriEventBatchSize * planeSize));
+
+    vector<BatchWindow> windows;
+    vector<int16_t> frames;
+    vector<int64_t> offsets;
+    for (int64_t first = 0; first < numEvents; first += PeriEventBatchSize)
+    {
+        if (cancel && *cancel)
+            throw std::runtime_error("Peri-event Error: cancelled");
+        const int64_t batch = min<int64_t>(PeriEventBatchSize, numEvents - first);
+        windows.resize((size_t) batch);
+        for (int64_t e = 0; e < batch; e++)
+        {
+            windows[e].start = result.events[first + e] - options.preSamples;
+            windows[e].length = length;
+            windows[e].channels = channels;
+        }
+        reader.read(windows, frames, offsets);
+
+        // Each thread takes a slice of the channels: it transposes the slice of every window in the
+        // batch to planes, then adds the planes into its part of the sums.
+        int16_t* planes = options.keepSnippets ? result.snippets.data() + first * planeSize : scratch.data();
+        auto accumulate = [&](int c0, int c1)
+        {
+            for (int64_t e = 0; e < batch; e++)
+            {
+                int16_t* eventPlanes = planes + e * planeSize;
+                framesToPlanes(frames.data() + offsets[e], nc, (int) length, c0, c1 - c0, eventPlanes + c0 * length, length);
+                const int16_t* in = eventPlanes + c0 * length;
+                int64_t* sum = sums.data() + c0 * length;
+                int64_t* square = squares.data() + c0 * length;
+                const int64_t n = (c1 - c0) * length;
+                for (int64_t i = 0; i < n; i++)
+                {
+                    const int32_t v = in[i];
+                    sum[i] += v;
+                    square[i] += v * v;
+                }
+            }
+        };
+        const int numSlices = min(numThreads, nc);
+        vector<thread> threads;
+        for (int s = 1; s < numSlices; s++)
+            threads.emplace_back(accumulate, s * nc / numSlices, (s + 1) * nc / numSlices);
+        accumulate(0, nc / numSlices);
+        for (thread& t : threads)
+            t.join();
+
+        if (progress)
+            *progress = (double) (first + batch) / (double) numEvents;
+    }
+
+    result.mean.assign((size_t) planeSize, 0.0);
+    result.variance.assign((size_t) planeSize, 0.0);
+    if (numEvents == 0)
+        return;
+    const double scale = AmplifierMicroVoltsPerBit;
+    for (int64_t i = 0; i < planeSize; i++)
+    {
+        const double mean = (double) sums[i] / (double) numEvents;
+        result.mean[i] = scale * mean;
+        if (numEvents > 1)
+            result.variance[i] = scale * scale * max(((double) squares[i] - mean * (double) sums[i]) / (double) (numEvents - 1), 0.0);
+    }
+}
@@ -0,0 +1,57 @@
+/*
+ * cnsperievent.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSPERIEVENT_H_
+#define RHX_CNSPERIEVENT_H_
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+// Events whose windows are read and accumulated together.
+const int PeriEventBatchSize = 256;
+
+// Sample numbers of the edges on one enabled digital input line (0 .. 15), read with DigitalLineReader
+// (digitalin.dat, the line's board-DIGITAL-IN-xx.dat, or the blocks of a traditional file). A line that
+// is high at the first sample has no edge there. Will throw() on fail.
+std::vector<int64_t> findDigitalEdges(const std::string& headerFilename, int line, bool rising = true);
+
+struct PeriEventOptions
+{
+    int64_t preSamples = 0;             // window: [event - preSamples, event + postSamples)
+    int64_t postSamples = 0;
+    std::vector<int> channels;          // amplifier channel indices; empty for all
+    bool keepSnippets = true;           // false: only the mean and variance
+    int numThreads = 0;                 // 0: one per hardware thread
+};
+
+struct PeriEventResult
+{
+    std::vector<int64_t> events;        // events used, in the order given
+    int64_t numSkipped = 0;             // events whose window runs off either end of the recording
+    int numChannels = 0;
+    int64_t windowLength = 0;
+
+    // events.size() x numChannels x windowLength amplifier words (0.195 uV/bit), if kept.
+    std::vector<int16_t> snippets;
+
+    // numChannels x windowLength, in uV: the event-triggered average, and the sample variance about it.
+    std::vector<double> mean;
+    std::vector<double> variance;
+};
+
+// Cut the window around each event out of every channel, stacking the snippets, and accumulate the
+// mean and variance at each channel and window offset. Windows are read a batch at a time through
+// BatchWindowReader (sorted, coalesced reads); each batch is transposed to one plane per channel and
+// summed into exact 64-bit sums and sums of squares, split by channel over numThreads threads.
+// 10,000 events x 1024 channels x a few ms window is a few GB of reads and takes seconds.
+// Runs in the calling thread, and will throw() on fail; cancel and progress may be null.
+void computePeriEvent(const std::string& headerFilename, const std::vector<int64_t>& events, const PeriEventOptions& options,
+                      PeriEventResult& result, const std::atomic<bool>* cancel, std::atomic<double>* progress);
+
+
+#endif /* RHX_CNSPERIEVENT_H_ */
@@ -0,0 +1,422 @@
+/*
+ * cnsqc.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <fstream>
+#include <exception>
+#include <stdexcept>
+#include <filesystem>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include "cnsreader.h"
+#include "cnstranscode.h"
+#include "cnsqc.h"
+using namespace std;
+
+
+static const uint32_t ChannelQcFileMagicNumber = 0x7c3a51e9;
+
+// Amplifier data read (and scanned) at a time; two chunks are in memory.
+static const int64_t ChannelQcChunkBytes = 16 << 20;
+
+// Scale from the median absolute deviation to the standard deviation of Gaussian noise.
+static const double MadToSigma = 1.4826;
+
+// Identity of the data file the statistics were computed from.
+struct ChannelQcFileHeader
+{
+    uint32_t magicNumber;
+    uint32_t versionNumber;
+    int64_t dataFileSize;
+    int64_t dataFileTime;
+    int64_t numSamples;
+    int32_t numChannels;
+    int32_t reserved;
+};
+
+// Native channel names longer than the field are cut short (those written by RHX are 5 to 7 characters).
+struct ChannelQcRecord
+{
+    char nativeChannelName[32];
+    double mean;
+    double rms;
+    double madNoise;
+    double saturatedFraction;
+    int64_t longestFlatRun;
+};
+
+static void dataFileIdentity(const string& dataFilename, int64_t& size, int64_t& time)
+{
+    size = (int64_t) filesystem::file_size(dataFilename);
+    time = (int64_t) filesystem::last_write_time(dataFilename).time_since_epoch().count();
+}
+
+static string recordName(const string& nativeChannelName)
+{
+    return nativeChannelName.substr(0, sizeof(ChannelQcRecord::nativeChannelName) - 1);
+}
+
+
+ChannelHealth channelHealth(const ChannelQc& qc, double sampleRate, const ChannelQcThresholds& thresholds)
+{
+    if (qc.saturatedFraction > thresholds.maxSaturatedFraction)
+        return SaturatedChannel;
+    if (qc.madNoise < thresholds.minNoise || (double) qc.longestFlatRun > thresholds.maxFlatRun * sampleRate)
+        return DeadChannel;
+    if (qc.madNoise > thresholds.maxNoise)
+        return NoisyChannel;
+    return HealthyChannel;
+}
+
+const char* channelHealthName(ChannelHealth health)
+{
+    switch (health)
+    {
+    case DeadChannel: return "dead";
+    case NoisyChannel: return "noisy";
+    case SaturatedChannel: return "saturated";
+    default: return "healthy";
+    }
+}
+
+string channelQcFilename(const string& headerFilename)
+{
+    return headerFilename + ".qc";
+}
+
+bool loadChannelQc(const string& headerFilename, vector<ChannelQc>& channels)
+{
+    channels.clear();
+    error_code ec;
+    string filename = channelQcFilename(headerFilename);
+    if (!filesystem::exists(filename, ec))
+        return false;
+
+    IntanDataReader reader;
+    int64_t size, time;
+    try
+    {
+        reader.open(headerFilename);
+        dataFileIdentity(reader.amplifierFilename(), size, time);
+    }
+    catch (std::exception &)
+    {
+        return false;
+    }
+
+    ifstream in(filename, ios::in | ios::binary);
+    ChannelQcFileHeader header;
+    if (!in || !in.read((char *)&header, sizeof(header)))
+        return false;
+    const vector<HeaderFileChannel>& amplifierChannels = reader.amplifierChannels();
+    if (header.magicNumber != ChannelQcFileMagicNumber || header.versionNumber != ChannelQcFileVersion
+            || header.dataFileSize != size || header.dataFileTime != time || header.numSamples != reader.numSamples()
+            || header.numChannels != (int32_t) amplifierChannels.size())
+        return false;
+
+    vector<ChannelQcRecord> records(header.numChannels);
+    if (header.numChannels > 0 && !in.read((char *)records.data(), records.size() * sizeof(ChannelQcRecord)))
+        return false;
+    for (size_t c = 0; c < records.size(); c++)
+    {
+        const ChannelQcRecord& record = records[c];
+        string name(record.nativeChannelName, strnlen(record.nativeChannelName, sizeof(record.nativeChannelName)));
+        if (name != recordName(amplifierChannels[c].nativeChannelName))
+        {
+            channels.clear();
+            return false;
+        }
+        ChannelQc qc;
+        qc.nativeChannelName = amplifierChannels[c].nativeChannelName;
+        qc.mean = record.mean;
+        qc.rms = record.rms;
+        qc.madNoise = record.madNoise;
+        qc.saturatedFraction = record.saturatedFraction;
+        qc.longestFlatRun = record.longestFlatRun;
+        channels.push_back(qc);
+    }
+    return true;
+}
+
+
+// Running statistics of one channel.
+namespace
+{
+    struct ChannelScan
+    {
+        int64_t sum = 0;
+        int64_t sumSquares = 0;         // exact up to 8.5e9 samples at the rails
+        int64_t numSaturated = 0;
+        int32_t previous = -65536;      // no word: the first sample starts a run
+        int64_t run = 0;
+        int64_t longestRun = 0;
+        vector<uint64_t> histogram;
+
+        ChannelScan() : histogram(2 * ChannelQcHistogramRange + 1, 0) {}
+
+        void add(const int16_t* x, int n)
+        {
+            // Sums and rails first, in a loop of their own so it vectorizes.
+            int64_t s = 0, ss = 0, sat = 0;
+            for (int t = 0; t < n; t++)
+            {
+                const int32_t v = x[t];
+                s += v;
+                ss += (int64_t) (v * v);
+                sat += (v == 32767) | (v == -32768);
+            }
+            sum += s;
+            sumSquares += ss;
+            numSaturated += sat;
+
+            uint64_t* h = histogram.data() + ChannelQcHistogramRange;
+            for (int t = 0; t < n; t++)
+            {
+                const int32_t v = x[t];
+                h[min(max(v, -ChannelQcHistogramRange), ChannelQcHistogramRange)]++;
+                if (v == previous)
+                    run++;
+                else
+                {
+                    longestRun = max(longestRun, run);
+                    run = 1;
+                    previous = v;
+                }
+            }
+        }
+
+        // The (lower) median of the words counted, and the median of their distances from it.
+        void medians(int64_t n, int& median, int& deviation) const
+        {
+            const int bins = (int) histogram.size();
+            const uint64_t half = (uint64_t) (n + 1) / 2;
+            uint64_t count = 0;
+            int m = 0;
+            for (; m < bins - 1; m++)
+            {
+                count += histogram[m];
+                if (count >= half)
+                    break;
+            }
+            count = histogram[m];
+            int d = 0;
+            while (count < half && d < bins)
+            {
+                d++;
+                if (m - d >= 0)
+                    count += histogram[m - d];
+                if (m + d < bins)
+                    count += histogram[m + d];
+            }
+            median = m - ChannelQcHistogramRange;
+            deviation = d;
+        }
+    };
+}
+
+static void saveChannelQc(const string& filename, const ChannelQcFileHeader& header, const vector<ChannelQc>& channels)
+{
+    vector<ChannelQcRecord> records(channels.size());
+    for (size_t c = 0; c < channels.size(); c++)
+    {
+        ChannelQcRecord& record = records[c];
+        memset(&record, 0, sizeof(record));
+        string name = recordName(channels[c].nativeChannelName);
+        memcpy(record.nativeChannelName, name.data(), name.size());
+        record.mean = channels[c].mean;
+        record.rms = channels[c].rms;
+        record.madNoise = channels[c].madNoise;
+        record.saturatedFraction = channels[c].saturatedFraction;
+        record.longestFlatRun = channels[c].longestFlatRun;
+    }
+
+    string tempFilename = filename + ".tmp";
+    {
+        ofstream out(tempFilename, ios::out | ios::binary | ios::trunc);
+        if (!out)
+            throw std::runtime_error("Channel QC Error: cannot create " + tempFilename);
+        out.write((const char *)&header, sizeof(header));
+        out.write((const char *)records.data(), records.size() * sizeof(ChannelQcRecord));
+        out.flush();
+        if (!out)
+            throw std::runtime_error("Channel QC Error: cannot write " + tempFilename);
+    }
+    error_code ec;
+    filesystem::rename(tempFilename, filename, ec);
+    if (ec)
+        throw std::runtime_error("Channel QC Error: cannot rename " + tempFilename);
+}
+
+void computeChannelQc(const string& headerFilename, vector<ChannelQc>& channels, int numThreads,
+                      const atomic<bool>* cancel, atomic<double>* progress)
+{
+    IntanDataReader reader;
+    reader.open(headerFilename);
+    const int nc = reader.numAmplifierChannels();
+    const int64_t numSamples = reader.numSamples();
+    if (nc == 0)
+        throw std::runtime_error("Channel QC Error: no amplifier channels");
+
+    ChannelQcFileHeader header = {};
+    header.magicNumber = ChannelQcFileMagicNumber;
+    header.versionNumber = ChannelQcFileVersion;
+    dataFileIdentity(reader.amplifierFilename(), header.dataFileSize, header.dataFileTime);
+    header.numSamples = numSamples;
+    header.numChannels = nc;
+
+    numThreads = max(1, (numThreads > 0) ? numThreads : (int) thread::hardware_concurrency());
+    const int numSlices = min(numThreads, nc);
+    const int chunkSamples = (int) max<int64_t>(1, ChannelQcChunkBytes / ((int64_t) nc * (int64_t) sizeof(int16_t)));
+    vector<int16_t> current((size_t) chunkSamples * nc), next((size_t) chunkSamples * nc);
+    vector<ChannelScan> scans(nc);
+    vector<vector<int16_t>> planes(numSlices);
+
+    // Each thread transposes its slice of the chunk to planes, then scans one channel at a time.
+    int n = 0;
+    auto scan = [&](int s)
+    {
+        const int c0 = s * nc / numSlices;
+        const int c1 = (s + 1) * nc / numSlices;
+        vector<int16_t>& slice = planes[s];
+        slice.resize((size_t) (c1 - c0) * chunkSamples);
+        framesToPlanes(current.data(), nc, n, c0, c1 - c0, slice.data(), chunkSamples);
+        for (int c = c0; c < c1; c++)
+            scans[c].add(slice.data() + (size_t) (c - c0) * chunkSamples, n);
+    };
+
+    // The next chunk is read while the threads scan this one.
+    int64_t position = 0;
+    n = reader.readAmplifierData(current.data(), chunkSamples);
+    while (n > 0)
+    {
+        if (cancel && *cancel)
+            throw std::runtime_error("Channel QC Error: cancelled");
+        vector<thread> threads;
+        for (int s = 0; s < numSlices; s++)
+            threads.emplace_back(scan, s);
+        int nextSamples = 0;
+        try
+        {
+            nextSamples = reader.readAmplifierData(next.data(), chunkSamples);
+        }
+        catch (std::exception &)
+        {
+            for (thread& t : threads)
+                t.join();
+            throw;
+        }
+        for (thread& t : threads)
+            t.join();
+
+        position += n;
+        if (progress)
+            *progress = (numSamples > 0) ? (double) position / (double) numSamples : 1.0;
+        swap(current, next);
+        n = nextSamples;
+    }
+
+    channels.assign(nc, ChannelQc());
+    const vector<HeaderFileChannel>& amplifierChannels = reader.amplifierChannels();
+    for (int c = 0; c < nc; c++)
+    {
+        const ChannelScan& s = scans[c];
+        ChannelQc& qc = channels[c];
+        qc.nativeChannelName = amplifierChannels[c].nativeChannelName;
+        qc.longestFlatRun = max(s.longestRun, s.run);
+        if (position == 0)
+            continue;
+        int median, deviation;
+        s.medians(position, median, deviation);
+        qc.mean = AmplifierMicroVoltsPerBit * (double) s.sum / (double) position;
+        qc.rms = AmplifierMicroVoltsPerBit * sqrt((double) s.sumSquares / (double) position);
+        qc.madNoise = AmplifierMicroVoltsPerBit * MadToSigma * (double) deviation;
+        qc.saturatedFraction = (double) s.numSaturated / (double) position;
+    }
+
+    // Saved only for a whole scan; a recording read short (still being written) is scanned again next time.
+    if (position == numSamples)
+        saveChannelQc(channelQcFilename(headerFilename), header, channels);
+}
+
+
+ChannelQcScanner::ChannelQcScanner()
+: m_running(false)
+, m_cancel(false)
+, m_progress(0.0)
+{
+}
+
+ChannelQcScanner::~ChannelQcScanner()
+{
+    cancel();
+    wait();
+}
+
+bool ChannelQcScanner::start(const string& headerFilename, int numThreads, function<void()> finished)
+{
+    cancel();
+    wait();
+
+    vector<ChannelQc> channels;
+    bool loaded = loadChannelQc(headerFilename, channels);
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_error.clear();
+        m_channels = channels;
+    }
+    if (loaded)
+    {
+        m_progress = 1.0;
+        return true;
+    }
+
+    m_cancel = false;
+    m_progress = 0.0;
+    m_running = true;
+    m_thread = thread([this, headerFilename, numThreads, finished]()
+    {
+        try
+        {
+            vector<ChannelQc> channels;
+            computeChannelQc(headerFilename, channels, numThreads, &m_cancel, &m_progress);
+            lock_guard<mutex> lock(m_mutex);
+            m_channels = channels;
+        }
+        catch (std::exception &e)
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (!m_cancel)
+                m_error = e.what();
+        }
+        m_running = false;
+        if (finished && !m_cancel)
+            finished();
+    });
+    return false;
+}
+
+void ChannelQcScanner::cancel()
+{
+    m_cancel = true;
+}
+
+void ChannelQcScanner::wait()
+{
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+string ChannelQcScanner::error() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_error;
+}
+
+vector<ChannelQc> ChannelQcScanner::channels() const
+{
+    lock_guard<mutex> lock(m_mutex);
+    return m_channels;
+}
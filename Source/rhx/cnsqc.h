@@ -0,0 +1,103 @@
+/*
+ * cnsqc.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSQC_H_
+#define RHX_CNSQC_H_
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <functional>
+#include <cstdint>
+
+// Version of the channel statistics file. A file of another version is ignored, and the recording scanned again.
+const uint32_t ChannelQcFileVersion = 1;
+
+// Amplifier words from -ChannelQcHistogramRange to +ChannelQcHistogramRange (+/- 799 uV) are counted
+// exactly for the noise estimate; words further out are counted at the ends of the range.
+const int ChannelQcHistogramRange = 4096;
+
+// Statistics of one amplifier channel over the whole recording. Voltages are in uV.
+struct ChannelQc
+{
+    std::string nativeChannelName;
+    double mean = 0.0;
+    double rms = 0.0;                   // about zero, not about the mean
+    double madNoise = 0.0;              // 1.4826 x median absolute deviation about the median (Gaussian sigma)
+    double saturatedFraction = 0.0;     // of samples at either rail (+32767 or -32768 words)
+    int64_t longestFlatRun = 0;         // longest run of one repeated word, in samples
+};
+
+enum ChannelHealth {
+    HealthyChannel,
+    DeadChannel,        // little or no noise, or long stretches of a constant value
+    NoisyChannel,       // noise well above the amplifier and electrode noise
+    SaturatedChannel    // a good part of the samples at the rails
+};
+
+struct ChannelQcThresholds
+{
+    double minNoise = 1.0;                  // uV; below this, dead (amplifier noise alone is ~2.4 uV rms)
+    double maxNoise = 60.0;                 // uV; above this, noisy
+    double maxSaturatedFraction = 0.001;
+    double maxFlatRun = 0.1;                // s; a longer run of one word, dead
+};
+
+ChannelHealth channelHealth(const ChannelQc& qc, double sampleRate, const ChannelQcThresholds& thresholds = ChannelQcThresholds());
+const char* channelHealthName(ChannelHealth health);
+
+// Statistics file of a recording: the header file name with ".qc" appended (info.rhd.qc).
+std::string channelQcFilename(const std::string& headerFilename);
+
+// Read the statistics saved for the enabled amplifier channels of a recording, in frame order. Returns
+// false if there are none, or the amplifier data or the channel list has changed since they were saved.
+bool loadChannelQc(const std::string& headerFilename, std::vector<ChannelQc>& channels);
+
+// Scan the amplifier data once, and save the statistics of every channel to the statistics file.
+// The data are read a chunk at a time (compressed files too, through IntanDataReader), while the
+// previous chunk is transposed and scanned by numThreads threads (0: one per hardware thread), each
+// taking a slice of the channels. Each channel keeps exact sums, a count of the samples at the rails,
+// its current and longest flat run, and a histogram of its words; the median and median absolute
+// deviation are read off the histogram at the end, so one pass is enough.
+// Runs in the calling thread, and will throw() on fail; cancel and progress may be null.
+void computeChannelQc(const std::string& headerFilename, std::vector<ChannelQc>& channels, int numThreads,
+                      const std::atomic<bool>* cancel, std::atomic<double>* progress);
+
+// Runs computeChannelQc() in a background thread, unless the statistics file is up to date.
+class ChannelQcScanner
+{
+public:
+    ChannelQcScanner();
+    ~ChannelQcScanner();
+
+    // Load the statistics, or start scanning for them. Returns true if they were loaded (and are
+    // ready now); false if scanning has started. Returns immediately. A scan that isn't cancelled
+    // calls finished, if given, from the scanning thread once the statistics or error are set.
+    bool start(const std::string& headerFilename, int numThreads = 0, std::function<void()> finished = nullptr);
+    void cancel();
+    void wait();
+
+    bool isRunning() const { return m_running; }
+    double progress() const { return m_progress; }      // 0 to 1
+    std::string error() const;
+
+    // The statistics, once loaded or scanned; empty until then.
+    std::vector<ChannelQc> channels() const;
+
+private:
+    std::thread m_thread;
+    std::atomic<bool> m_running;
+    std::atomic<bool> m_cancel;
+    std::atomic<double> m_progress;
+    mutable std::mutex m_mutex;
+    std::string m_error;
+    std::vector<ChannelQc> m_channels;
+};
+
+
+#endif /* RHX_CNSQC_H_ */
@@ -0,0 +1,263 @@
+/*
+ * cnsreader.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <sstream>
+#include <exception>
+#include <filesystem>
+#include <algorithm>
+#include <cmath>
+#include "abstractrhxcontroller.h"
+#include "cnscodec.h"
+#include "cnszstd.h"
+#include "cnsreader.h"
+using namespace std;
+
+
+IntanDataReader::IntanDataReader()
+: m_format(FilePerSignalTypeFormat)
+, m_position(0)
+, m_firstTimestamp(0)
+{
+}
+
+IntanDataReader::~IntanDataReader()
+{
+    close();
+}
+
+void IntanDataReader::open(const string& headerFilename)
+{
+    close();
+
+    readIntanHeader(headerFilename.c_str(), m_info);
+    m_directory = filesystem::path(headerFilename).parent_path().string();
+
+    m_amplifierChannels = enabledAmplifierChannels(m_info);
+
+    // amplifier.dat, or else a compressed copy of it.
+    filesystem::path amplifierPath = filesystem::path(m_directory) / "amplifier.dat";
+    filesystem::path compressedPath = filesystem::path(m_directory) / ("amplifier.dat" + string(CompressedFileExtension));
+    filesystem::path zstdPath = filesystem::path(m_directory) / ("amplifier.dat" + string(ZstdFileExtension));
+    if (!filesystem::exists(amplifierPath) && !filesystem::exists(compressedPath) && !filesystem::exists(zstdPath))
+    {
+        throw std::runtime_error("Cannot find amplifier.dat. Only the one file per signal type format is implemented.");
+    }
+    m_format = FilePerSignalTypeFormat;
+
+    int64_t bytesPerFrame = BytesPerWord * (int64_t) numAmplifierChannels();
+    if (filesystem::exists(amplifierPath))
+    {
+        m_amplifierFilename = amplifierPath.string();
+        m_amplifierFile.open(m_amplifierFilename, ios::in | ios::binary);
+        if (!m_amplifierFile)
+            throw std::runtime_error("Cannot open amplifier.dat");
+        m_info.dataSizeInBytes = (int64_t) filesystem::file_size(amplifierPath);
+    }
+    else if (filesystem::exists(compressedPath))
+    {
+        m_amplifierFilename = compressedPath.string();
+        unique_ptr<CompressedDataFile> file(new CompressedDataFile);
+        file->open(m_amplifierFilename);
+        if (file->numChannels() != numAmplifierChannels())
+            throw std::runtime_error(compressedPath.filename().string() + " does not match the header");
+        m_info.dataSizeInBytes = file->size();
+        m_packedAmplifierFile = std::move(file);
+    }
+    else
+    {
+        m_amplifierFilename = zstdPath.string();
+        unique_ptr<ZstdDataFile> file(new ZstdDataFile);
+        file->open(m_amplifierFilename);
+        m_info.dataSizeInBytes = file->size();
+        m_packedAmplifierFile = std::move(file);
+    }
+
+    m_info.bytesPerDataBlock = (int) bytesPerFrame * m_info.samplesPerDataBlock;
+    m_info.numSamplesInFile = (bytesPerFrame > 0) ? m_info.dataSizeInBytes / bytesPerFrame : 0;
+    m_info.numDataBlocksInFile = m_info.numSamplesInFile / m_info.samplesPerDataBlock;
+    m_info.timeInFile = (double) m_info.numSamplesInFile / sampleRate();
+
+    m_firstTimestamp = 0;
+    filesystem::path timePath = filesystem::path(m_directory) / "time.dat";
+    filesystem::path zstdTimePath = filesystem::path(m_directory) / ("time.dat" + string(ZstdFileExtension));
+    int32_t timestamp;
+    if (!filesystem::exists(timePath) && filesystem::exists(zstdTimePath))
+    {
+        unique_ptr<ZstdDataFile> file(new ZstdDataFile);
+        file->open(zstdTimePath.string());
+        if (file->read(0, sizeof(timestamp), &timestamp) == sizeof(timestamp))
+        {
+            m_firstTimestamp = timestamp;
+            m_packedTimeFile = std::move(file);
+        }
+    }
+    else
+    {
+        // An empty time.dat is kept open if there is no data yet: the recording may still be starting.
+        m_timeFilename = timePath.string();
+        m_timeFile.open(m_timeFilename, ios::in | ios::binary);
+        if (m_timeFile && m_timeFile.read((char *)&timestamp, sizeof(timestamp)))
+            m_firstTimestamp = timestamp;
+        else if (m_timeFile.is_open() && m_info.numSamplesInFile > 0)
+            m_timeFile.close();
+    }
+
+    m_position = 0;
+}
+
+void IntanDataReader::close()
+{
+    if (m_amplifierFile.is_open())
+        m_amplifierFile.close();
+    m_packedAmplifierFile.reset();
+    if (m_timeFile.is_open())
+        m_timeFile.close();
+    m_timeFilename.clear();
+    m_packedTimeFile.reset();
+    m_position = 0;
+}
+
+int64_t IntanDataReader::refresh()
+{
+    int64_t bytesPerFrame = BytesPerWord * (int64_t) numAmplifierChannels();
+    if (!m_amplifierFile.is_open() || bytesPerFrame == 0)
+        return 0;
+
+    // RHX appends to each data file a block at a time, so a file may end part way through a block.
+    error_code ec;
+    int64_t available = (int64_t) filesystem::file_size(m_amplifierFilename, ec) / bytesPerFrame;
+    if (ec)
+        return 0;
+    if (m_timeFile.is_open())
+    {
+        int64_t timeSamples = (int64_t) filesystem::file_size(m_timeFilename, ec) / (int64_t) sizeof(int32_t);
+        if (ec)
+            return 0;
+        available = min(available, timeSamples);
+    }
+    // A part block taken in by open() is dropped again until it is complete.
+    const int64_t blockSize = max(m_info.samplesPerDataBlock, 1);
+    available -= available % blockSize;
+    if (available <= numSamples() && numSamples() % blockSize == 0)
+        return 0;
+
+    int64_t added = max<int64_t>(available - numSamples(), 0);
+    if (numSamples() == 0 && m_timeFile.is_open())
+    {
+        int32_t timestamp;
+        m_timeFile.clear();
+        m_timeFile.seekg(0, ios::beg);
+        if (m_timeFile.read((char *)&timestamp, sizeof(timestamp)))
+            m_firstTimestamp = timestamp;
+    }
+    m_info.dataSizeInBytes = available * bytesPerFrame;
+    m_info.numSamplesInFile = available;
+    m_info.numDataBlocksInFile = available / blockSize;
+    m_info.timeInFile = (double) available / sampleRate();
+    if (m_position > available)
+        seek(available);
+    return added;
+}
+
+double IntanDataReader::sampleRate() const
+{
+    return AbstractRHXController::getSampleRate(m_info.sampleRate);
+}
+
+void IntanDataReader::seek(int64_t sample)
+{
+    if (sample < 0) sample = 0;
+    if (sample > numSamples()) sample = numSamples();
+    if (m_amplifierFile.is_open())
+    {
+        m_amplifierFile.clear();
+        m_amplifierFile.seekg(sample * BytesPerWord * numAmplifierChannels(), ios::beg);
+    }
+    m_position = sample;
+}
+
+int IntanDataReader::readAmplifierData(int16_t* buffer, int nSamples)
+{
+    int64_t available = numSamples() - m_position;
+    int n = (int) ((nSamples < available) ? nSamples : available);
+    if (n <= 0)
+        return 0;
+
+    if (isCompressed())
+    {
+        int64_t bytesPerFrame = BytesPerWord * (int64_t) numAmplifierChannels();
+        if (m_packedAmplifierFile->read(m_position * bytesPerFrame, n * bytesPerFrame, buffer) != n * bytesPerFrame)
+            throw std::runtime_error("Cannot read amplifier data");
+    }
+    else if (not m_amplifierFile.read((char *)buffer, (streamsize) n * BytesPerWord * numAmplifierChannels()))
+    {
+        throw std::runtime_error("Cannot read amplifier data");
+    }
+    m_position += n;
+    return n;
+}
+
+int IntanDataReader::readTimestamps(int64_t firstSample, int nSamples, int32_t* buffer)
+{
+    int64_t available = numSamples() - firstSample;
+    int n = (int) ((nSamples < available) ? nSamples : available);
+    if (n <= 0 || firstSample < 0)
+        return 0;
+
+    if (m_packedTimeFile)
+    {
+        int64_t bytes = n * (int64_t) sizeof(int32_t);
+        if (m_packedTimeFile->read(firstSample * (int64_t) sizeof(int32_t), bytes, buffer) != bytes)
+            throw std::runtime_error("Cannot read time.dat");
+        return n;
+    }
+    if (!m_timeFile.is_open())
+    {
+        for (int i = 0; i < n; i++)
+            buffer[i] = (int32_t) (m_firstTimestamp + firstSample + i);
+        return n;
+    }
+    m_timeFile.clear();
+    m_timeFile.seekg(firstSample * (int64_t) sizeof(int32_t), ios::beg);
+    if (not m_timeFile.read((char *)buffer, (streamsize) n * sizeof(int32_t)))
+    {
+        throw std::runtime_error("Cannot read time.dat");
+    }
+    return n;
+}
+
+
+vector<HeaderFileChannel> enabledAmplifierChannels(const IntanHeaderInfo& info)
+{
+    vector<HeaderFileChannel> channels;
+    for (const HeaderFileGroup& group : info.groups)
+    {
+        for (const HeaderFileChannel& channel : group.channels)
+        {
+            if (channel.enabled && channel.signalType == AmplifierSignal)
+                channels.push_back(channel);
+        }
+    }
+    return channels;
+}
+
+void amplifierToMicroVolts(const int16_t* in, float* out, int64_t count)
+{
+    const float scale = (float) AmplifierMicroVoltsPerBit;
+    for (int64_t i = 0; i < count; i++)
+        out[i] = scale * in[i];
+}
+
+void microVoltsToAmplifier(const float* in, int16_t* out, int64_t count)
+{
+    const float scale = (float) (1.0 / AmplifierMicroVoltsPerBit);
+    for (int64_t i = 0; i < count; i++)
+    {
+        float v = nearbyintf(scale * in[i]);
+        v = (v > 32767.0F) ? 32767.0F : ((v < -32768.0F) ? -32768.0F : v);
+        out[i] = (int16_t) v;
+    }
+}
@@ -0,0 +1,97 @@
+/*
+ * cnsreader.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSREADER_H_
+#define RHX_CNSREADER_H_
+
+#include "cnsrhx.h"
+#include "cnschunked.h"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <memory>
+#include <cstdint>
+
+// Amplifier data in "one file per signal type" files is stored as signed 16-bit words, 0.195 uV/bit.
+const double AmplifierMicroVoltsPerBit = 0.195;
+
+// Headless reader for the data files that sit next to an info.rhd (or info.rhs) header file.
+// Amplifier data is returned in frames: one frame per sample, with the channel index varying
+// fastest (the same interleaving used in amplifier.dat).
+// At this writing, only the "one file per signal type" format is handled. If there is no amplifier.dat,
+// a compressed amplifier.dat.icd (see cnscodec.h) or amplifier.dat.zst (see cnszstd.h) is read in its
+// place; likewise time.dat.zst for time.dat.
+class IntanDataReader
+{
+public:
+    IntanDataReader();
+    ~IntanDataReader();
+
+    // Parse the header file and open the data files in the same directory. Will throw() on fail.
+    void open(const std::string& headerFilename);
+    void close();
+    bool isOpen() const { return m_amplifierFile.is_open() || m_packedAmplifierFile; }
+
+    const IntanHeaderInfo& header() const { return m_info; }
+    DataFileFormat format() const { return m_format; }
+    const std::string& directory() const { return m_directory; }
+    const std::string& amplifierFilename() const { return m_amplifierFilename; }
+    bool isCompressed() const { return (bool) m_packedAmplifierFile; }
+
+    // Enabled amplifier channels, in the order they appear in each frame.
+    const std::vector<HeaderFileChannel>& amplifierChannels() const { return m_amplifierChannels; }
+    int numAmplifierChannels() const { return (int) m_amplifierChannels.size(); }
+
+    int64_t numSamples() const { return m_info.numSamplesInFile; }
+
+    // For a recording that is still being written: take in the data written since open() or the last
+    // refresh(), up to the last data block written in full to every open data file (a part block read
+    // by open() is given up until it is complete). The files are not reopened, nor the header parsed
+    // again. Returns the number of samples added (compressed files do not grow).
+    int64_t refresh();
+
+    // Timestamp of sample 0, from time.dat (0 if there is no time.dat). Spike files and
+    // other timestamped outputs count from the same origin.
+    int64_t firstTimestamp() const { return m_firstTimestamp; }
+
+    double sampleRate() const;
+
+    // Position the reader at the given sample (frame) number.
+    void seek(int64_t sample);
+    int64_t position() const { return m_position; }
+
+    // Read up to nSamples frames of amplifier data into buffer (nSamples * numAmplifierChannels() words).
+    // Returns the number of frames read, which is less than nSamples only at the end of the file.
+    int readAmplifierData(int16_t* buffer, int nSamples);
+
+    // Read the timestamps of nSamples samples from firstSample on (independent of the read position).
+    // Without a time.dat, timestamps count up from firstTimestamp(). Returns the number read.
+    int readTimestamps(int64_t firstSample, int nSamples, int32_t* buffer);
+
+private:
+    IntanHeaderInfo m_info;
+    DataFileFormat m_format;
+    std::string m_directory;
+    std::vector<HeaderFileChannel> m_amplifierChannels;
+    std::string m_amplifierFilename;
+    std::ifstream m_amplifierFile;
+    std::unique_ptr<ChunkedFileReader> m_packedAmplifierFile;
+    std::string m_timeFilename;
+    std::ifstream m_timeFile;
+    std::unique_ptr<ChunkedFileReader> m_packedTimeFile;
+    int64_t m_position;
+    int64_t m_firstTimestamp;
+};
+
+// Enabled amplifier channels, in the order they appear in the header (the order they are saved in).
+std::vector<HeaderFileChannel> enabledAmplifierChannels(const IntanHeaderInfo& info);
+
+// Convert count amplifier words to microvolts, and back again (rounded, saturated).
+void amplifierToMicroVolts(const int16_t* in, float* out, int64_t count);
+void microVoltsToAmplifier(const float* in, int16_t* out, int64_t count);
+
+
+#endif /* RHX_CNSREADER_H_ */
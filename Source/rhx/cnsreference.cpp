@@ -0,0 +1,141 @@
+/*
+ * cnsreference.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <algorithm>
+#include "cnsreference.h"
+using namespace std;
+
+
+vector<ChannelRange> amplifierGroupRanges(const IntanHeaderInfo& info)
+{
+    vector<ChannelRange> ranges;
+    int index = 0;
+    for (const HeaderFileGroup& group : info.groups)
+    {
+        ChannelRange range = { index, index };
+        for (const HeaderFileChannel& channel : group.channels)
+        {
+            if (channel.enabled && channel.signalType == AmplifierSignal)
+                index++;
+        }
+        range.end = index;
+        if (range.size() > 0)
+            ranges.push_back(range);
+    }
+    return ranges;
+}
+
+int amplifierChannelIndex(const IntanHeaderInfo& info, const string& nativeChannelName)
+{
+    int index = 0;
+    for (const HeaderFileGroup& group : info.groups)
+    {
+        for (const HeaderFileChannel& channel : group.channels)
+        {
+            if (channel.enabled && channel.signalType == AmplifierSignal)
+            {
+                if (channel.nativeChannelName == nativeChannelName)
+                    return index;
+                index++;
+            }
+        }
+    }
+    return -1;
+}
+
+
+MultichannelReference::MultichannelReference()
+: m_mode(NoReference)
+, m_referenceChannel(-1)
+, m_numChannels(0)
+{
+}
+
+void MultichannelReference::setParameters(ReferenceMode mode, const vector<ChannelRange>& groups, int referenceChannel, int numChannels)
+{
+    m_mode = mode;
+    m_groups = groups;
+    m_referenceChannel = referenceChannel;
+    m_numChannels = numChannels;
+
+    int largest = 0;
+    for (const ChannelRange& range : m_groups)
+        largest = max(largest, range.size());
+    m_scratch.resize(largest);
+
+    if (m_mode == SingleChannelReference && (m_referenceChannel < 0 || m_referenceChannel >= m_numChannels))
+        m_mode = NoReference;
+}
+
+void MultichannelReference::apply(float* data, int nSamples)
+{
+    const int nc = m_numChannels;
+    for (int t = 0; t < nSamples; t++)
+    {
+        float* frame = data + (size_t) t * nc;
+        switch (m_mode)
+        {
+        case GroupAverageReference:
+            for (const ChannelRange& range : m_groups)
+                applyGroupAverage(frame, range);
+            break;
+        case GroupMedianReference:
+            for (const ChannelRange& range : m_groups)
+                applyGroupMedian(frame, range);
+            break;
+        case SingleChannelReference:
+        {
+            const float ref = frame[m_referenceChannel];
+            for (int c = 0; c < nc; c++)
+                frame[c] -= ref;
+            break;
+        }
+        default:
+            return;
+        }
+    }
+}
+
+// The sum is split over 8 independent partial sums so the compiler can vectorize it
+// without reordering a single floating-point accumulation.
+void MultichannelReference::applyGroupAverage(float* frame, const ChannelRange& range)
+{
+    float* x = frame + range.begin;
+    const int n = range.size();
+    float partial[8] = { 0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F, 0.0F };
+    int c = 0;
+    for (; c + 8 <= n; c += 8)
+    {
+        for (int k = 0; k < 8; k++)
+            partial[k] += x[c + k];
+    }
+    float sum = 0.0F;
+    for (; c < n; c++)
+        sum += x[c];
+    for (int k = 0; k < 8; k++)
+        sum += partial[k];
+
+    const float mean = sum / n;
+    for (c = 0; c < n; c++)
+        x[c] -= mean;
+}
+
+void MultichannelReference::applyGroupMedian(float* frame, const ChannelRange& range)
+{
+    float* x = frame + range.begin;
+    const int n = range.size();
+    float* s = m_scratch.data();
+    copy(x, x + n, s);
+
+    float* mid = s + n / 2;
+    nth_element(s, mid, s + n);
+    float median = *mid;
+    if (n % 2 == 0)
+        median = 0.5F * (median + *max_element(s, mid));
+
+    for (int c = 0; c < n; c++)
+        x[c] -= median;
+}
@@ -0,0 +1,54 @@
+/*
+ * cnsreference.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSREFERENCE_H_
+#define RHX_CNSREFERENCE_H_
+
+#include "cnsrhx.h"
+#include "cnsoptions.h"
+#include <vector>
+#include <string>
+
+// A contiguous range [begin, end) of channels within a frame.
+struct ChannelRange
+{
+    int begin;
+    int end;
+    int size() const { return end - begin; }
+};
+
+// Ranges of enabled amplifier channels for each group (port) that has any, in frame order.
+std::vector<ChannelRange> amplifierGroupRanges(const IntanHeaderInfo& info);
+
+// Index in the frame of the enabled amplifier channel with the given native name, or -1.
+int amplifierChannelIndex(const IntanHeaderInfo& info, const std::string& nativeChannelName);
+
+// Software re-referencing of blocks of multichannel data, in place. Blocks are in frames
+// (one frame per sample, channel index varying fastest). Group modes compute the reference
+// for each group of the frame separately; the reference channel(s) are included.
+class MultichannelReference
+{
+public:
+    MultichannelReference();
+
+    void setParameters(ReferenceMode mode, const std::vector<ChannelRange>& groups, int referenceChannel, int numChannels);
+    ReferenceMode mode() const { return m_mode; }
+
+    void apply(float* data, int nSamples);
+
+private:
+    ReferenceMode m_mode;
+    std::vector<ChannelRange> m_groups;
+    int m_referenceChannel;
+    int m_numChannels;
+    std::vector<float> m_scratch;
+
+    void applyGroupAverage(float* frame, const ChannelRange& range);
+    void applyGroupMedian(float* frame, const ChannelRange& range);
+};
+
+
+#endif /* RHX_CNSREFERENCE_H_ */
@@ -0,0 +1,236 @@
+/*
+ * cnsresample.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "rhxglobals.h"
+#include "cnsresample.h"
+using namespace std;
+
+
+// Output position fractions of irrational ratios are in units of 2^-32 input samples.
+static const uint64_t FixedPointOne = (uint64_t) 1 << 32;
+
+
+Resampler::Resampler()
+: m_numChannels(0)
+, m_maxBlockSize(0)
+, m_inputRate(0.0)
+, m_outputRate(0.0)
+, m_rational(true)
+, m_numTaps(0)
+, m_numPhases(0)
+, m_denominator(1)
+, m_stepWhole(1)
+, m_stepFraction(0)
+, m_primed(false)
+, m_inputIndex(0)
+, m_position(0)
+, m_fraction(0)
+{
+}
+
+void Resampler::setParameters(double inputRate, double outputRate, int numChannels, int maxBlockSize)
+{
+    m_numChannels = numChannels;
+    m_maxBlockSize = max(maxBlockSize, 1);
+    m_inputRate = inputRate;
+    m_outputRate = outputRate;
+    double ratio = outputRate / inputRate;
+
+    // Smallest L (and so the fewest phases) with L / M equal to the ratio.
+    int interpolation = 0;
+    int decimation = 0;
+    for (int l = 1; l <= MaxRationalPhases; l++)
+    {
+        double m = nearbyint(l / ratio);
+        if (m >= 1.0 && fabs(l / m - ratio) <= 1.0e-12 * ratio)
+        {
+            interpolation = l;
+            decimation = (int) m;
+            break;
+        }
+    }
+
+    m_rational = interpolation > 0;
+    if (m_rational)
+    {
+        m_numPhases = interpolation;
+        m_denominator = (uint64_t) interpolation;
+        m_stepWhole = decimation / interpolation;
+        m_stepFraction = (uint64_t) (decimation % interpolation);
+    }
+    else
+    {
+        double step = inputRate / outputRate;
+        m_numPhases = InterpolatedPhases;
+        m_denominator = FixedPointOne;
+        m_stepWhole = (int64_t) floor(step);
+        m_stepFraction = (uint64_t) nearbyint((step - m_stepWhole) * FixedPointOne);
+        if (m_stepFraction >= FixedPointOne)
+        {
+            m_stepWhole++;
+            m_stepFraction -= FixedPointOne;
+        }
+    }
+
+    // Cutoff in cycles per input sample; the kernel widens when decimating.
+    double fc = ResamplerCutoff * min(1.0, ratio);
+    int half = (int) ceil(ResamplerZeroCrossings / (2.0 * fc));
+    m_numTaps = 2 * half;
+
+    // Kernel for an output at fraction f past input n covers inputs n - half + 1 .. n + half.
+    // Interpolated tables have one more phase (f = 1) to interpolate towards.
+    int tablePhases = m_rational ? m_numPhases : m_numPhases + 1;
+    m_table.resize((size_t) tablePhases * m_numTaps);
+    for (int p = 0; p < tablePhases; p++)
+    {
+        double f = (double) p / m_numPhases;
+        float* taps = m_table.data() + (size_t) p * m_numTaps;
+        double sum = 0.0;
+        for (int i = 0; i < m_numTaps; i++)
+        {
+            double t = (i - (half - 1)) - f;
+            double x = 2.0 * fc * t;
+            double sinc = (t == 0.0) ? 2.0 * fc : 2.0 * fc * sin(Pi * x) / (Pi * x);
+            double window = 0.42 + 0.5 * cos(Pi * t / half) + 0.08 * cos(TwoPi * t / half);
+            taps[i] = (float) (sinc * window);
+            sum += taps[i];
+        }
+        for (int i = 0; i < m_numTaps; i++)
+            taps[i] = (float) (taps[i] / sum);
+    }
+
+    m_taps.assign(m_numTaps, 0.0F);
+    m_work.assign((size_t) (m_numTaps + m_maxBlockSize) * numChannels, 0.0F);
+    reset();
+}
+
+void Resampler::reset(int64_t firstInput, int64_t firstOutput)
+{
+    m_primed = false;
+    m_inputIndex = firstInput;
+    if (m_rational)
+    {
+        int64_t decimation = m_stepWhole * (int64_t) m_denominator + (int64_t) m_stepFraction;
+        int64_t numerator = firstOutput * decimation;
+        m_position = numerator / (int64_t) m_denominator;
+        m_fraction = (uint64_t) (numerator % (int64_t) m_denominator);
+    }
+    else
+    {
+        double x = firstOutput * (m_inputRate / m_outputRate);
+        m_position = (int64_t) floor(x);
+        m_fraction = min((uint64_t) ((x - m_position) * FixedPointOne), FixedPointOne - 1);
+    }
+}
+
+int64_t Resampler::inputPosition(int64_t k) const
+{
+    if (m_rational)
+    {
+        int64_t decimation = m_stepWhole * (int64_t) m_denominator + (int64_t) m_stepFraction;
+        return (k * decimation) / (int64_t) m_denominator;
+    }
+    return (int64_t) floor(k * (m_inputRate / m_outputRate));
+}
+
+int64_t Resampler::inputsForOutputs(int nOutputs) const
+{
+    if (nOutputs <= 0)
+        return 0;
+    uint64_t fraction = m_fraction + (uint64_t) (nOutputs - 1) * m_stepFraction;
+    int64_t last = m_position + (int64_t) (nOutputs - 1) * m_stepWhole + (int64_t) (fraction / m_denominator);
+    return max<int64_t>(last + m_numTaps / 2 + 1 - m_inputIndex, 0);
+}
+
+int Resampler::maxOutputs(int nSamples) const
+{
+    return (int) ceil(nSamples * (m_outputRate / m_inputRate)) + 2;
+}
+
+void Resampler::advance()
+{
+    m_position += m_stepWhole;
+    m_fraction += m_stepFraction;
+    if (m_fraction >= m_denominator)
+    {
+        m_fraction -= m_denominator;
+        m_position++;
+    }
+}
+
+const float* Resampler::kernel()
+{
+    if (m_rational)
+        return m_table.data() + (size_t) m_fraction * m_numTaps;
+
+    double x = (double) m_fraction * ((double) m_numPhases / (double) FixedPointOne);
+    int p = (int) x;
+    float w = (float) (x - p);
+    const float* a = m_table.data() + (size_t) p * m_numTaps;
+    const float* b = a + m_numTaps;
+    float* taps = m_taps.data();
+    for (int i = 0; i < m_numTaps; i++)
+        taps[i] = a[i] + w * (b[i] - a[i]);
+    return taps;
+}
+
+int Resampler::process(const float* in, int nSamples, float* out)
+{
+    int nOut = 0;
+    for (int t = 0; t < nSamples; t += m_maxBlockSize)
+    {
+        int n = min(m_maxBlockSize, nSamples - t);
+        nOut += processBlock(in + (size_t) t * m_numChannels, n, out + (size_t) nOut * m_numChannels);
+    }
+    return nOut;
+}
+
+int Resampler::processBlock(const float* in, int nSamples, float* out)
+{
+    const int nc = m_numChannels;
+    const int history = m_numTaps;
+    const int half = m_numTaps / 2;
+    if (nSamples <= 0 || nc == 0)
+        return 0;
+
+    float* work = m_work.data();
+    if (!m_primed)
+    {
+        for (int t = 0; t < history; t++)
+            memcpy(work + (size_t) t * nc, in, nc * sizeof(float));
+        m_primed = true;
+    }
+    memcpy(work + (size_t) history * nc, in, (size_t) nSamples * nc * sizeof(float));
+
+    // Work frame 0 holds input m_inputIndex - history.
+    const int64_t base = m_inputIndex - history;
+    const int64_t last = m_inputIndex + nSamples - 1;
+    int nOut = 0;
+    while (m_position + half <= last)
+    {
+        const float* taps = kernel();
+        const float* window = work + (size_t) (m_position - half + 1 - base) * nc;
+        float* o = out + (size_t) nOut * nc;
+        for (int c = 0; c < nc; c++)
+            o[c] = 0.0F;
+        for (int k = 0; k < m_numTaps; k++)
+        {
+            const float h = taps[k];
+            const float* frame = window + (size_t) k * nc;
+            for (int c = 0; c < nc; c++)
+                o[c] += h * frame[c];
+        }
+        advance();
+        nOut++;
+    }
+
+    memmove(work, work + (size_t) nSamples * nc, (size_t) history * nc * sizeof(float));
+    m_inputIndex += nSamples;
+    return nOut;
+}
@@ -0,0 +1,94 @@
+/*
+ * cnsresample.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSRESAMPLE_H_
+#define RHX_CNSRESAMPLE_H_
+
+#include <vector>
+#include <cstdint>
+
+// Largest interpolation factor L handled as an exact rational ratio L / M.
+const int MaxRationalPhases = 512;
+
+// Filter phases tabulated for ratios that are not a small rational; coefficients for positions
+// in between are interpolated linearly.
+const int InterpolatedPhases = 256;
+
+// Zero crossings of the sinc kernel on each side of its center.
+const int ResamplerZeroCrossings = 16;
+
+// Low-pass cutoff as a fraction of the lower of the two sample rates.
+const double ResamplerCutoff = 0.45;
+
+// Sample rate conversion by any ratio, with a Blackman-windowed sinc interpolation kernel, applied
+// to blocks of multichannel data in frames (one frame per sample, channel index varying fastest).
+// When outputRate / inputRate is a rational L / M with L <= MaxRationalPhases, the kernel is tabulated
+// for each of the L output phases, and output positions are tracked exactly. Otherwise the kernel is
+// tabulated at InterpolatedPhases positions per input sample and interpolated, and output positions
+// are tracked in 32-bit fixed point.
+// Output k is the signal at input position k * inputRate / outputRate (no delay); it is produced once
+// the inputs up to that position plus half the kernel length have been seen.
+// All buffers are allocated by setParameters(); reset() and process() do not allocate.
+class Resampler
+{
+public:
+    Resampler();
+
+    // Blocks passed to process() up to maxBlockSize frames are filtered in one pass; longer blocks
+    // are split.
+    void setParameters(double inputRate, double outputRate, int numChannels, int maxBlockSize);
+
+    double inputRate() const { return m_inputRate; }
+    double outputRate() const { return m_outputRate; }
+    bool isRational() const { return m_rational; }
+    int numTaps() const { return m_numTaps; }
+
+    // Clear the filter state. The next input is input number firstInput, and the next output is output
+    // number firstOutput, whose input position must not be more than numTaps() / 2 inputs before
+    // firstInput. Inputs before firstInput are taken to be equal to it.
+    void reset(int64_t firstInput = 0, int64_t firstOutput = 0);
+
+    // Input position of output number k, rounded down.
+    int64_t inputPosition(int64_t k) const;
+
+    // Inputs needed to produce the next nOutputs outputs.
+    int64_t inputsForOutputs(int nOutputs) const;
+
+    // Upper bound on the outputs produced from nSamples inputs.
+    int maxOutputs(int nSamples) const;
+
+    // Filter nSamples input frames; the outputs produced are written to out, which must have room for
+    // maxOutputs(nSamples) frames. Returns the number of output frames.
+    int process(const float* in, int nSamples, float* out);
+
+private:
+    int m_numChannels;
+    int m_maxBlockSize;
+    double m_inputRate;
+    double m_outputRate;
+    bool m_rational;
+    int m_numTaps;
+    int m_numPhases;
+    uint64_t m_denominator;             // output position fraction is m_fraction / m_denominator
+    int64_t m_stepWhole;
+    uint64_t m_stepFraction;
+
+    std::vector<float> m_table;         // kernel, m_numTaps per phase
+    std::vector<float> m_taps;          // kernel for the current output, when interpolated
+    std::vector<float> m_work;          // history, then the current block
+
+    bool m_primed;
+    int64_t m_inputIndex;               // input number of the next input
+    int64_t m_position;                 // input position of the next output, whole part
+    uint64_t m_fraction;                //  and fraction
+
+    int processBlock(const float* in, int nSamples, float* out);
+    const float* kernel();
+    void advance();
+};
+
+
+#endif /* RHX_CNSRESAMPLE_H_ */
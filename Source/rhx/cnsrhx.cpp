@@ -60,10 +60,42 @@ void readQStringFromBin(ifstream& in, string& value, string description)
 }
 
 
+// Add delta to the count of enabled channels of the given signal type, return the new count.
+int IntanHeaderInfo::adjustNumChannels(SignalType signalType, int delta)
+{
+    switch (signalType) {
+    case AmplifierSignal:
+        numEnabledAmplifierChannels += delta;
+        return numEnabledAmplifierChannels;
+    case AuxInputSignal:
+        numEnabledAuxInputChannels += delta;
+        return numEnabledAuxInputChannels;
+    case SupplyVoltageSignal:
+        numEnabledSupplyVoltageChannels += delta;
+        return numEnabledSupplyVoltageChannels;
+    case BoardAdcSignal:
+        numEnabledBoardAdcChannels += delta;
+        return numEnabledBoardAdcChannels;
+    case BoardDacSignal:
+        numEnabledBoardDacChannels += delta;
+        return numEnabledBoardDacChannels;
+    case BoardDigitalInSignal:
+        numEnabledDigitalInChannels += delta;
+        return numEnabledDigitalInChannels;
+    case BoardDigitalOutSignal:
+        numEnabledDigitalOutChannels += delta;
+        return numEnabledDigitalOutChannels;
+    default:
+        return 0;
+    }
+}
+
+
 // read the intan file header.
-// Will only read header-only, not "all-in-one" type data files.
+// Will only read header-only, not "all-in-one" type data files, unless allowData: then the size of the
+// data that follows the header is left in dataSizeInBytes (see cnstraditional.h for reading it).
 // At this writing, only look for info.rhd, timestamp, amplifier, digitalin, spike files.
-void readIntanHeader(const char *filename, IntanHeaderInfo& info)
+void readIntanHeader(const char *filename, IntanHeaderInfo& info, bool allowData)
 {
     int16_t int16Buffer;
     uint32_t uint32Buffer;
@@ -169,7 +201,7 @@ void readIntanHeader(const char *filename, IntanHeaderInfo& info)
         info.ampSettleMode = (int16Buffer != 0);
         readFromBin(in, int16Buffer, "chargeRecoveryMode");
         info.chargeRecoveryMode = (int16Buffer != 0);
-        readFromBin(in, int16Buffer, "stimStepSize");
+        readFromBin(in, floatBuffer, "stimStepSize");
         info.stimStepSize = AbstractRHXController::nearestStimStepSize(floatBuffer);
         if ((int)info.stimStepSize == -1) {
         	std::ostringstream oss;
@@ -249,6 +281,7 @@ void readIntanHeader(const char *filename, IntanHeaderInfo& info)
     numberOfSignalGroups = (int)int16Buffer;
     cout << "Found " << numberOfSignalGroups << " signal groups" << endl;
 
+    info.groups.clear();
     info.numDataStreams = 0;
     info.numEnabledAmplifierChannels = 0;
     info.numEnabledAuxInputChannels = 0;
@@ -376,13 +409,13 @@ void readIntanHeader(const char *filename, IntanHeaderInfo& info)
     //djs info.headerOnly = file.atEnd();
     info.headerSizeInBytes = in.tellg();
     //djs info.dataSizeInBytes = file.size() - (int64_t)info.headerSizeInBytes;
-    info.dataSizeInBytes = 0;
 
     in.seekg(0, ios::end);
     info.headerOnly = (info.headerSizeInBytes == in.tellg());
     cout << "headers size " << info.headerSizeInBytes << " eof pos " << in.tellg() << " header only? " << info.headerOnly << endl;
+    info.dataSizeInBytes = (int64_t) in.tellg() - (int64_t) info.headerSizeInBytes;
 
-    if (!info.headerOnly)
+    if (!info.headerOnly && !allowData)
     {
     	throw std::runtime_error("Cannot parse all-in-one file. Not implemented.");
     }
@@ -140,7 +140,7 @@ public:
 
 
 
-void readIntanHeader(const char *filename, IntanHeaderInfo& info);
+void readIntanHeader(const char *filename, IntanHeaderInfo& info, bool allowData = false);
 void printHeader(const IntanHeaderInfo& info);
 
 
@@ -0,0 +1,251 @@
+/*
+ * cnsshm.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <exception>
+#include <stdexcept>
+#include <algorithm>
+#include <new>
+#include "cnsshm.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define HAVE_POSIX_SHM
+#endif
+using namespace std;
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared sample rings need lock-free 64-bit atomics");
+static_assert(sizeof(SharedRingHeader) == 64 && sizeof(SharedRingSlotHeader) == 64, "shared ring layout");
+
+
+// POSIX shared memory names are a single component starting with '/'.
+static string sharedMemoryName(const string& name)
+{
+    return (!name.empty() && name[0] == '/') ? name : "/" + name;
+}
+
+static uint64_t slotSizeFor(int numChannels)
+{
+    uint64_t size = sizeof(SharedRingSlotHeader) + (uint64_t) numChannels * SharedRingBlockSize * sizeof(float);
+    return (size + 63) & ~(uint64_t) 63;
+}
+
+
+SharedSampleRing::SharedSampleRing()
+: m_memory(nullptr)
+, m_size(0)
+, m_header(nullptr)
+{
+}
+
+SharedSampleRing::~SharedSampleRing()
+{
+    close();
+}
+
+// A ring created again under the same name is a new object: consumers still mapping the old one see
+// it retired (magic 0) rather than have it resized under them.
+void SharedSampleRing::create(const string& name, int numChannels, double sampleRate, int numSlots)
+{
+#ifdef HAVE_POSIX_SHM
+    close();
+    m_name = sharedMemoryName(name);
+    shm_unlink(m_name.c_str());
+
+    numChannels = max(numChannels, 1);
+    numSlots = max(numSlots, 2);
+    const uint64_t slotSize = slotSizeFor(numChannels);
+    m_size = (size_t) (sizeof(SharedRingHeader) + slotSize * (uint64_t) numSlots);
+
+    int fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+    {
+        const string shmName = m_name;
+        close();
+        throw std::runtime_error("Shared Memory Error: cannot create " + shmName);
+    }
+    if (ftruncate(fd, (off_t) m_size) != 0)
+    {
+        ::close(fd);
+        const string shmName = m_name;
+        close();
+        throw std::runtime_error("Shared Memory Error: cannot size " + shmName);
+    }
+    void* memory = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+    {
+        const string shmName = m_name;
+        close();
+        throw std::runtime_error("Shared Memory Error: cannot map " + shmName);
+    }
+    m_memory = memory;
+
+    // The magic number goes in last, so a consumer that attaches meanwhile sees no ring yet.
+    SharedRingHeader* header = new (m_memory) SharedRingHeader;
+    header->magic.store(0, memory_order_relaxed);
+    header->version = SharedRingVersionNumber;
+    header->headerSize = sizeof(SharedRingHeader);
+    header->numChannels = (uint32_t) numChannels;
+    header->sampleRate = sampleRate;
+    header->blockSize = SharedRingBlockSize;
+    header->numSlots = (uint32_t) numSlots;
+    header->slotSize = slotSize;
+    header->blocksWritten.store(0, memory_order_relaxed);
+    for (int s = 0; s < numSlots; s++)
+    {
+        SharedRingSlotHeader* slot = new ((uint8_t *) m_memory + sizeof(SharedRingHeader) + s * slotSize) SharedRingSlotHeader;
+        slot->sequence.store(0, memory_order_relaxed);
+        slot->firstSample = 0;
+        slot->numSamples = 0;
+        slot->reserved = 0;
+    }
+    header->magic.store(SharedRingMagicNumber, memory_order_release);
+    m_header = header;
+#else
+    (void) numChannels;
+    (void) sampleRate;
+    (void) numSlots;
+    throw std::runtime_error("Shared Memory Error: cannot create " + name + ", POSIX shared memory is not available");
+#endif
+}
+
+// The shared memory object is retired and removed; consumers still attached keep their mapping.
+void SharedSampleRing::close()
+{
+#ifdef HAVE_POSIX_SHM
+    if (m_header)
+        m_header->magic.store(0, memory_order_release);
+    if (m_memory)
+        munmap(m_memory, m_size);
+    if (!m_name.empty())
+        shm_unlink(m_name.c_str());
+#endif
+    m_memory = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+    m_name.clear();
+}
+
+template <typename T>
+void SharedSampleRing::publishSamples(const T* frames, int nSamples, int64_t firstSample, float scale)
+{
+    if (!m_header)
+        return;
+    const int nc = (int) m_header->numChannels;
+    for (int done = 0; done < nSamples; done += SharedRingBlockSize)
+    {
+        const int n = min(nSamples - done, SharedRingBlockSize);
+        const uint64_t k = m_header->blocksWritten.load(memory_order_relaxed);
+        SharedRingSlotHeader* slot = (SharedRingSlotHeader *) ((uint8_t *) m_memory + m_header->headerSize +
+                                                               (k % m_header->numSlots) * m_header->slotSize);
+        slot->sequence.store(2 * k + 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+
+        slot->firstSample = firstSample + done;
+        slot->numSamples = (uint32_t) n;
+        float* planar = (float *) (slot + 1);
+        const T* in = frames + (size_t) done * nc;
+        for (int c = 0; c < nc; c++)
+        {
+            float* out = planar + (size_t) c * SharedRingBlockSize;
+            for (int t = 0; t < n; t++)
+                out[t] = scale * (float) in[(size_t) t * nc + c];
+        }
+
+        slot->sequence.store(2 * k + 2, memory_order_release);
+        m_header->blocksWritten.store(k + 1, memory_order_release);
+    }
+}
+
+void SharedSampleRing::publish(const float* frames, int nSamples, int64_t firstSample)
+{
+    publishSamples(frames, nSamples, firstSample, 1.0F);
+}
+
+void SharedSampleRing::publish(const int16_t* frames, int nSamples, int64_t firstSample, float scale)
+{
+    publishSamples(frames, nSamples, firstSample, scale);
+}
+
+
+SharedSampleRingReader::SharedSampleRingReader()
+: m_memory(nullptr)
+, m_size(0)
+, m_header(nullptr)
+{
+}
+
+SharedSampleRingReader::~SharedSampleRingReader()
+{
+    close();
+}
+
+void SharedSampleRingReader::attach(const string& name)
+{
+    close();
+#ifdef HAVE_POSIX_SHM
+    const string shmName = sharedMemoryName(name);
+    int fd = shm_open(shmName.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+        throw std::runtime_error("Shared Memory Error: cannot open " + shmName);
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(SharedRingHeader))
+    {
+        ::close(fd);
+        throw std::runtime_error("Shared Memory Error: " + shmName + " is not a shared sample ring");
+    }
+    m_size = (size_t) st.st_size;
+    void* memory = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (memory == MAP_FAILED)
+        throw std::runtime_error("Shared Memory Error: cannot map " + shmName);
+    m_memory = memory;
+
+    const SharedRingHeader* header = (const SharedRingHeader *) m_memory;
+    if (header->magic.load(memory_order_acquire) != SharedRingMagicNumber || header->version != SharedRingVersionNumber ||
+        header->headerSize + header->slotSize * header->numSlots > m_size)
+    {
+        close();
+        throw std::runtime_error("Shared Memory Error: " + shmName + " is not a shared sample ring");
+    }
+    m_header = header;
+#else
+    throw std::runtime_error("Shared Memory Error: cannot open " + name + ", POSIX shared memory is not available");
+#endif
+}
+
+void SharedSampleRingReader::close()
+{
+#ifdef HAVE_POSIX_SHM
+    if (m_memory)
+        munmap((void *) m_memory, m_size);
+#endif
+    m_memory = nullptr;
+    m_size = 0;
+    m_header = nullptr;
+}
+
+int SharedSampleRingReader::readBlock(uint64_t k, float* planar, int64_t& firstSample) const
+{
+    if (!m_header || k >= blocksWritten())
+        return -1;
+    const SharedRingSlotHeader* slot = (const SharedRingSlotHeader *) ((const uint8_t *) m_memory + m_header->headerSize +
+                                                                       (k % m_header->numSlots) * m_header->slotSize);
+    const uint64_t sequence = slot->sequence.load(memory_order_acquire);
+    if (sequence != 2 * k + 2)
+        return -1;
+
+    firstSample = slot->firstSample;
+    const int n = (int) min<uint32_t>(slot->numSamples, SharedRingBlockSize);
+    const float* data = (const float *) (slot + 1);
+    for (uint32_t c = 0; c < m_header->numChannels; c++)
+        copy(data + (size_t) c * SharedRingBlockSize, data + (size_t) c * SharedRingBlockSize + n, planar + (size_t) c * SharedRingBlockSize);
+
+    atomic_thread_fence(memory_order_acquire);
+    return (slot->sequence.load(memory_order_relaxed) == sequence) ? n : -1;
+}
@@ -0,0 +1,120 @@
+/*
+ * cnsshm.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSSHM_H_
+#define RHX_CNSSHM_H_
+
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+// Samples per channel in each block of a shared sample ring.
+const int SharedRingBlockSize = 1024;
+
+const uint32_t SharedRingMagicNumber = 0x2c9e41b3;
+const uint32_t SharedRingVersionNumber = 2;
+
+// Layout of a shared sample ring: a POSIX shared memory object (/dev/shm/<name> on Linux) that one
+// writer fills with blocks of float samples (uV), for any number of local processes to read in place.
+// All fields are little-endian; the header and each slot start on a 64-byte boundary.
+//
+//   SharedRingHeader                                       (headerSize bytes)
+//   numSlots slots of slotSize bytes, each:
+//     SharedRingSlotHeader                                 (64 bytes)
+//     numChannels * blockSize floats: planar, channel c at [c * blockSize], numSamples of them valid
+//
+// Block k (counting from 0) goes to slot k % numSlots. Each slot is a sequence lock: the writer sets
+// sequence to 2k + 1 before it writes block k, and to 2k + 2 once it is written, then sets
+// blocksWritten to k + 1. To read block k (k < blocksWritten), load sequence; if it is 2k + 2, read
+// the block, then load sequence again. If it is unchanged the block is whole; otherwise the writer has
+// lapped the reader and the block is lost. Consumers never write, so they cannot hold up the writer.
+// A ring is never resized in place. When the stream it carries changes (e.g. its sample rate), or the
+// writer closes it, the writer sets magic to 0 and unlinks the object; a changed stream gets a new object
+// under the same name. Mappings of the old object stay valid, so consumers should attach again once
+// magic is no longer SharedRingMagicNumber.
+struct alignas(64) SharedRingHeader
+{
+    std::atomic<uint32_t> magic;
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t numChannels;
+    double sampleRate;                      // AmplifierSampleRate of the stream, in Hz
+    uint32_t blockSize;
+    uint32_t numSlots;
+    uint64_t slotSize;
+    std::atomic<uint64_t> blocksWritten;
+};
+
+struct alignas(64) SharedRingSlotHeader
+{
+    std::atomic<uint64_t> sequence;
+    int64_t firstSample;                    // sample number of the first sample in the block
+    uint32_t numSamples;
+    uint32_t reserved;
+};
+
+// Writer of a shared sample ring.
+class SharedSampleRing
+{
+public:
+    SharedSampleRing();
+    ~SharedSampleRing();
+
+    // Create (or replace) the shared memory object name, holding numSlots blocks. An object already under
+    // the name is unlinked, never resized, so consumers mapping it are not cut short. Will throw() on fail,
+    // or on platforms without POSIX shared memory.
+    void create(const std::string& name, int numChannels, double sampleRate, int numSlots);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+
+    const std::string& name() const { return m_name; }
+    int numChannels() const { return m_header ? (int) m_header->numChannels : 0; }
+
+    // Publish nSamples frames (channel index varying fastest) from firstSample on, as planar blocks of
+    // up to SharedRingBlockSize samples. The int16 form takes amplifier words, scaled by scale to uV.
+    void publish(const float* frames, int nSamples, int64_t firstSample);
+    void publish(const int16_t* frames, int nSamples, int64_t firstSample, float scale);
+
+private:
+    std::string m_name;
+    void* m_memory;
+    size_t m_size;
+    SharedRingHeader* m_header;
+
+    template <typename T>
+    void publishSamples(const T* frames, int nSamples, int64_t firstSample, float scale);
+};
+
+// Consumer of a shared sample ring, for local tools and tests; other languages map the same layout.
+class SharedSampleRingReader
+{
+public:
+    SharedSampleRingReader();
+    ~SharedSampleRingReader();
+
+    // Map the shared memory object name read-only. Will throw() on fail.
+    void attach(const std::string& name);
+    void close();
+    bool isOpen() const { return m_header != nullptr; }
+
+    const SharedRingHeader& header() const { return *m_header; }
+    uint64_t blocksWritten() const { return m_header->blocksWritten.load(std::memory_order_acquire); }
+
+    // True once the writer has closed or replaced the ring; attach() again to follow a replacement.
+    bool isRetired() const { return m_header->magic.load(std::memory_order_acquire) != SharedRingMagicNumber; }
+
+    // Copy block k into planar (numChannels * blockSize floats). Returns the number of samples in the
+    // block and its first sample number, or -1 if the block has been overwritten or is not written yet.
+    int readBlock(uint64_t k, float* planar, int64_t& firstSample) const;
+
+private:
+    const void* m_memory;
+    size_t m_size;
+    const SharedRingHeader* m_header;
+};
+
+
+#endif /* RHX_CNSSHM_H_ */
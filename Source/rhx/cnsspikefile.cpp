@@ -0,0 +1,361 @@
+/*
+ * cnsspikefile.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <sstream>
+#include <exception>
+#include <filesystem>
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <cstring>
+#include "rhxglobals.h"
+#include "cnsreader.h"
+#include "cnsspikefile.h"
+using namespace std;
+
+
+static const uint32_t SpikeIndexMagicNumber = 0x18f8ac1d;
+static const uint32_t SpikeIndexVersionNumber = 1;
+
+// Spike records are scanned in chunks of about this many bytes.
+static const int SpikeScanChunkSize = 1 << 20;
+
+static void spikeFileError(const string& filename, const string& what)
+{
+    ostringstream oss;
+    oss << "Spike File Error: " << filename << ": " << what;
+    throw std::runtime_error(oss.str());
+}
+
+template <typename T>
+static bool readValue(istream& in, T& value)
+{
+    return (bool) in.read((char *)&value, sizeof(value));
+}
+
+static bool readNullTerminated(istream& in, string& value)
+{
+    value.clear();
+    char c;
+    while (in.get(c))
+    {
+        if (c == '\0')
+            return true;
+        value.push_back(c);
+    }
+    return false;
+}
+
+static vector<string> splitNames(const string& s)
+{
+    vector<string> names;
+    if (s.empty())
+        return names;
+    size_t begin = 0;
+    while (true)
+    {
+        size_t comma = s.find(',', begin);
+        names.push_back(s.substr(begin, (comma == string::npos) ? string::npos : comma - begin));
+        if (comma == string::npos)
+            break;
+        begin = comma + 1;
+    }
+    return names;
+}
+
+
+IntanSpikeFile::IntanSpikeFile()
+: m_indexedBytes(0)
+{
+}
+
+IntanSpikeFile::~IntanSpikeFile()
+{
+    close();
+}
+
+void IntanSpikeFile::open(const string& filename)
+{
+    close();
+    m_filename = filename;
+    m_file.open(filename, ios::in | ios::binary);
+    if (!m_file)
+        spikeFileError(filename, "cannot open");
+
+    readHeader();
+    m_record.resize(m_header.recordSize);
+
+    int64_t fileSize = (int64_t) filesystem::file_size(filename);
+    if (!loadIndex() || m_indexedBytes > fileSize)
+    {
+        m_times.assign(numChannels(), vector<int32_t>());
+        m_offsets.assign(numChannels(), vector<int64_t>());
+        m_indexedBytes = m_header.dataOffset;
+    }
+    if (m_indexedBytes + m_header.recordSize <= fileSize)
+    {
+        scan(fileSize);
+        saveIndex();
+    }
+}
+
+void IntanSpikeFile::close()
+{
+    if (m_file.is_open())
+        m_file.close();
+    m_times.clear();
+    m_offsets.clear();
+    m_indexedBytes = 0;
+}
+
+void IntanSpikeFile::readHeader()
+{
+    uint32_t magic = 0;
+    uint16_t version = 0;
+    string nativeNames, customNames;
+    float sampleRate = 0.0F;
+    uint32_t pre = 0, post = 0;
+
+    if (!readValue(m_file, magic))
+        spikeFileError(m_filename, "cannot read magic number");
+    if (magic == SpikeFileMagicNumberAllChannels)
+        m_header.allChannels = true;
+    else if (magic == SpikeFileMagicNumberSingleChannel)
+        m_header.allChannels = false;
+    else
+    {
+        ostringstream oss;
+        oss << "invalid spike file identifier: " << hex << magic;
+        spikeFileError(m_filename, oss.str());
+    }
+
+    if (!readValue(m_file, version) || !readNullTerminated(m_file, m_header.baseFilename)
+            || !readNullTerminated(m_file, nativeNames) || !readNullTerminated(m_file, customNames)
+            || !readValue(m_file, sampleRate) || !readValue(m_file, pre) || !readValue(m_file, post))
+        spikeFileError(m_filename, "cannot read header");
+
+    m_header.versionNumber = version;
+    m_header.nativeChannelNames = splitNames(nativeNames);
+    m_header.customChannelNames = splitNames(customNames);
+    m_header.sampleRate = sampleRate;
+    m_header.samplesPreDetect = (int) pre;
+    m_header.samplesPostDetect = (int) post;
+    m_header.dataOffset = (int64_t) m_file.tellg();
+    m_header.recordSize = (m_header.allChannels ? SpikeFileChannelNameLength : 0) + (int) sizeof(int32_t)
+            + (int) sizeof(uint8_t) + BytesPerWord * m_header.snippetLength();
+
+    if (m_header.nativeChannelNames.empty())
+        spikeFileError(m_filename, "no channels in header");
+    if (!m_header.allChannels && m_header.nativeChannelNames.size() != 1)
+        spikeFileError(m_filename, "single channel spike file lists more than one channel");
+    if (pre > 100000 || post > 100000)
+        spikeFileError(m_filename, "invalid snippet length");
+}
+
+int IntanSpikeFile::channelIndex(const string& nativeChannelName) const
+{
+    for (int i = 0; i < numChannels(); i++)
+    {
+        if (m_header.nativeChannelNames[i] == nativeChannelName)
+            return i;
+    }
+    return -1;
+}
+
+// Read spike records from m_indexedBytes up to the last whole record in the file.
+void IntanSpikeFile::scan(int64_t fileSize)
+{
+    const int recordSize = m_header.recordSize;
+    const int nameLength = m_header.allChannels ? SpikeFileChannelNameLength : 0;
+
+    unordered_map<string, int> channels;
+    for (int i = 0; i < numChannels(); i++)
+        channels[m_header.nativeChannelNames[i]] = i;
+
+    vector<char> chunk((size_t) max(1, SpikeScanChunkSize / recordSize) * recordSize);
+    vector<bool> sorted(numChannels(), true);
+    string name(nameLength, ' ');
+
+    int64_t numRecords = (fileSize - m_indexedBytes) / recordSize;
+    m_file.clear();
+    m_file.seekg(m_indexedBytes, ios::beg);
+    while (numRecords > 0)
+    {
+        int64_t n = min<int64_t>(numRecords, chunk.size() / recordSize);
+        if (!m_file.read(chunk.data(), n * recordSize))
+            spikeFileError(m_filename, "cannot read spike records");
+
+        for (int64_t r = 0; r < n; r++)
+        {
+            const char* record = chunk.data() + r * recordSize;
+            int channel = 0;
+            if (nameLength > 0)
+            {
+                name.assign(record, nameLength);
+                unordered_map<string, int>::const_iterator it = channels.find(name);
+                if (it == channels.end())
+                    spikeFileError(m_filename, "spike on unknown channel " + name);
+                channel = it->second;
+            }
+            int32_t timestamp;
+            memcpy(&timestamp, record + nameLength, sizeof(timestamp));
+
+            vector<int32_t>& times = m_times[channel];
+            if (!times.empty() && timestamp < times.back())
+                sorted[channel] = false;
+            times.push_back(timestamp);
+            m_offsets[channel].push_back(m_indexedBytes + r * recordSize);
+        }
+        m_indexedBytes += n * recordSize;
+        numRecords -= n;
+    }
+
+    // RHX writes spikes in time order; keep the index sorted if a file was not.
+    for (int c = 0; c < numChannels(); c++)
+    {
+        if (sorted[c])
+            continue;
+        vector<size_t> order(m_times[c].size());
+        iota(order.begin(), order.end(), 0);
+        stable_sort(order.begin(), order.end(), [this, c](size_t a, size_t b) { return m_times[c][a] < m_times[c][b]; });
+        vector<int32_t> times(order.size());
+        vector<int64_t> offsets(order.size());
+        for (size_t i = 0; i < order.size(); i++)
+        {
+            times[i] = m_times[c][order[i]];
+            offsets[i] = m_offsets[c][order[i]];
+        }
+        m_times[c].swap(times);
+        m_offsets[c].swap(offsets);
+    }
+}
+
+// Index file: magic number, version, the spike file layout it was built for, bytes of the
+// spike file indexed, then for each channel the spike count, timestamps and record offsets.
+bool IntanSpikeFile::loadIndex()
+{
+    ifstream in(m_filename + SpikeIndexFileExtension, ios::in | ios::binary);
+    if (!in)
+        return false;
+
+    uint32_t magic = 0, version = 0;
+    int64_t dataOffset = 0, indexedBytes = 0;
+    int32_t recordSize = 0, nc = 0;
+    if (!readValue(in, magic) || magic != SpikeIndexMagicNumber || !readValue(in, version) || version != SpikeIndexVersionNumber
+            || !readValue(in, dataOffset) || !readValue(in, recordSize) || !readValue(in, nc) || !readValue(in, indexedBytes))
+        return false;
+    if (dataOffset != m_header.dataOffset || recordSize != m_header.recordSize || nc != numChannels()
+            || (indexedBytes - dataOffset) % recordSize != 0)
+        return false;
+
+    m_times.assign(nc, vector<int32_t>());
+    m_offsets.assign(nc, vector<int64_t>());
+    int64_t total = 0;
+    for (int c = 0; c < nc; c++)
+    {
+        int64_t count = 0;
+        if (!readValue(in, count) || count < 0 || count > (indexedBytes - dataOffset) / recordSize)
+            return false;
+        m_times[c].resize(count);
+        m_offsets[c].resize(count);
+        if (!in.read((char *)m_times[c].data(), count * sizeof(int32_t))
+                || !in.read((char *)m_offsets[c].data(), count * sizeof(int64_t)))
+            return false;
+        total += count;
+    }
+    if (total != (indexedBytes - dataOffset) / recordSize)
+        return false;
+
+    m_indexedBytes = indexedBytes;
+    return true;
+}
+
+void IntanSpikeFile::saveIndex() const
+{
+    // Written to a temporary file and renamed, so a reader never sees a partial index.
+    string indexFilename = m_filename + SpikeIndexFileExtension;
+    string tempFilename = indexFilename + ".tmp";
+    {
+        ofstream out(tempFilename, ios::out | ios::binary | ios::trunc);
+        if (!out)
+            return;
+        int32_t recordSize = m_header.recordSize;
+        int32_t nc = numChannels();
+        out.write((const char *)&SpikeIndexMagicNumber, sizeof(SpikeIndexMagicNumber));
+        out.write((const char *)&SpikeIndexVersionNumber, sizeof(SpikeIndexVersionNumber));
+        out.write((const char *)&m_header.dataOffset, sizeof(m_header.dataOffset));
+        out.write((const char *)&recordSize, sizeof(recordSize));
+        out.write((const char *)&nc, sizeof(nc));
+        out.write((const char *)&m_indexedBytes, sizeof(m_indexedBytes));
+        for (int c = 0; c < nc; c++)
+        {
+            int64_t count = (int64_t) m_times[c].size();
+            out.write((const char *)&count, sizeof(count));
+            out.write((const char *)m_times[c].data(), count * sizeof(int32_t));
+            out.write((const char *)m_offsets[c].data(), count * sizeof(int64_t));
+        }
+        if (!out)
+        {
+            out.close();
+            error_code ec;
+            filesystem::remove(tempFilename, ec);
+            return;
+        }
+    }
+    error_code ec;
+    filesystem::rename(tempFilename, indexFilename, ec);
+}
+
+void IntanSpikeFile::range(int channel, int64_t t0, int64_t t1, size_t& begin, size_t& end) const
+{
+    const vector<int32_t>& times = m_times[channel];
+    begin = lower_bound(times.begin(), times.end(), t0, [](int32_t t, int64_t v) { return t < v; }) - times.begin();
+    end = lower_bound(times.begin() + begin, times.end(), t1, [](int32_t t, int64_t v) { return t < v; }) - times.begin();
+}
+
+int64_t IntanSpikeFile::countSpikes(int channel, int64_t t0, int64_t t1) const
+{
+    size_t begin, end;
+    range(channel, t0, t1, begin, end);
+    return (int64_t) (end - begin);
+}
+
+void IntanSpikeFile::readSpikes(int channel, int64_t t0, int64_t t1, vector<IntanSpike>& spikes, vector<float>* snippets)
+{
+    size_t begin, end;
+    range(channel, t0, t1, begin, end);
+    if (begin == end)
+        return;
+
+    // Only the spike ID and snippet come from the file.
+    const int nameLength = m_header.allChannels ? SpikeFileChannelNameLength : 0;
+    const int snippetLength = m_header.snippetLength();
+    const int64_t* offsets = m_offsets[channel].data();
+    spikes.reserve(spikes.size() + (end - begin));
+    if (snippets)
+        snippets->reserve(snippets->size() + (end - begin) * snippetLength);
+
+    m_file.clear();
+    for (size_t i = begin; i < end; i++)
+    {
+        m_file.seekg(offsets[i], ios::beg);
+        if (!m_file.read(m_record.data(), m_header.recordSize))
+            spikeFileError(m_filename, "cannot read spike record");
+
+        const char* p = m_record.data() + nameLength + sizeof(int32_t);
+        spikes.push_back({ channel, m_times[channel][i], (uint8_t) *p });
+        if (snippets)
+        {
+            p++;
+            for (int k = 0; k < snippetLength; k++)
+            {
+                uint16_t word;
+                memcpy(&word, p + k * BytesPerWord, sizeof(word));
+                snippets->push_back((float) (AmplifierMicroVoltsPerBit * ((int) word - SpikeSnippetOffset)));
+            }
+        }
+    }
+}
@@ -0,0 +1,113 @@
+/*
+ * cnsspikefile.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSSPIKEFILE_H_
+#define RHX_CNSSPIKEFILE_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+
+// Spike snippets are saved as unsigned 16-bit words, offset 32768, 0.195 uV/bit.
+const int SpikeSnippetOffset = 32768;
+
+// Width of the native channel name saved with each spike in an all-channels spike file.
+const int SpikeFileChannelNameLength = 5;
+
+// Extension of the index file written next to a spike file.
+const char * const SpikeIndexFileExtension = ".index";
+
+// Header of an RHX spike file (spike.dat, or one file per channel).
+//
+//   uint32   magic number (SpikeFileMagicNumberAllChannels or SpikeFileMagicNumberSingleChannel)
+//   uint16   spike file version number
+//   string   base filename                 (strings are null-terminated)
+//   string   native channel names, comma separated
+//   string   custom channel names, comma separated
+//   float32  sample rate
+//   uint32   samples saved before each threshold crossing
+//   uint32   samples saved after each threshold crossing
+//
+// followed by fixed-size spike records:
+//
+//   char[5]  native channel name           (all-channels files only)
+//   int32    timestamp
+//   uint8    spike ID
+//   uint16   snippet[samples before + samples after]
+struct SpikeFileHeader
+{
+    bool allChannels = true;
+    int versionNumber = 0;
+    std::string baseFilename;
+    std::vector<std::string> nativeChannelNames;
+    std::vector<std::string> customChannelNames;
+    double sampleRate = 0.0;
+    int samplesPreDetect = 0;
+    int samplesPostDetect = 0;
+
+    int64_t dataOffset = 0;     // file position of the first spike record
+    int recordSize = 0;         // bytes per spike record
+
+    int snippetLength() const { return samplesPreDetect + samplesPostDetect; }
+};
+
+struct IntanSpike
+{
+    int channel;                // index into the header's channel lists
+    int32_t timestamp;
+    uint8_t spikeId;
+};
+
+// Reader for RHX spike files. Opening a file scans it once and builds an index of the spike
+// times and record offsets of each channel, which is saved next to the spike file, so that
+// later opens (and queries by channel and time range) do not scan the file again. If the spike
+// file has grown since the index was written (it was still being recorded), only the new
+// records are scanned.
+class IntanSpikeFile
+{
+public:
+    IntanSpikeFile();
+    ~IntanSpikeFile();
+
+    // Will throw() on fail. A missing or unwritable index file is not an error.
+    void open(const std::string& filename);
+    void close();
+    bool isOpen() const { return m_file.is_open(); }
+
+    const SpikeFileHeader& header() const { return m_header; }
+    int numChannels() const { return (int) m_header.nativeChannelNames.size(); }
+    int channelIndex(const std::string& nativeChannelName) const;
+
+    // All spike timestamps of a channel, in increasing order.
+    const std::vector<int32_t>& spikeTimes(int channel) const { return m_times[channel]; }
+    int64_t numSpikes(int channel) const { return (int64_t) m_times[channel].size(); }
+
+    // Number of spikes on channel with t0 <= timestamp < t1.
+    int64_t countSpikes(int channel, int64_t t0, int64_t t1) const;
+
+    // Append the spikes on channel with t0 <= timestamp < t1 to spikes, in time order. If snippets is
+    // not nullptr, their snippets (in uV, header().snippetLength() samples each) are appended to it.
+    void readSpikes(int channel, int64_t t0, int64_t t1, std::vector<IntanSpike>& spikes, std::vector<float>* snippets);
+
+private:
+    std::string m_filename;
+    std::ifstream m_file;
+    SpikeFileHeader m_header;
+    int64_t m_indexedBytes;
+    std::vector<std::vector<int32_t>> m_times;
+    std::vector<std::vector<int64_t>> m_offsets;
+    std::vector<char> m_record;
+
+    void readHeader();
+    bool loadIndex();
+    void saveIndex() const;
+    void scan(int64_t fileSize);
+    void range(int channel, int64_t t0, int64_t t1, size_t& begin, size_t& end) const;
+};
+
+
+#endif /* RHX_CNSSPIKEFILE_H_ */
@@ -0,0 +1,104 @@
+/*
+ * cnsspikes.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include "cnsspikes.h"
+using namespace std;
+
+
+ThresholdSpikeDetector::ThresholdSpikeDetector()
+: m_numChannels(0)
+, m_numActive(0)
+, m_refractorySamples(0)
+, m_primed(false)
+{
+}
+
+void ThresholdSpikeDetector::setParameters(const vector<HeaderFileChannel>& channels, double sampleRate, double refractoryPeriod)
+{
+    m_numChannels = (int) channels.size();
+    m_numActive = 0;
+    m_refractorySamples = (int) ceil(refractoryPeriod * sampleRate);
+    m_sign.assign(m_numChannels, 0.0F);
+    m_threshold.assign(m_numChannels, numeric_limits<float>::max());
+    for (int c = 0; c < m_numChannels; c++)
+    {
+        const HeaderFileChannel& channel = channels[c];
+        if (channel.spikeScopeTriggerMode == 1)
+        {
+            m_sign[c] = (channel.spikeScopeTriggerPolarity == 1) ? 1.0F : -1.0F;
+            m_threshold[c] = m_sign[c] * channel.spikeScopeVoltageThreshold;
+            m_numActive++;
+        }
+    }
+    m_previous.assign(m_numChannels, 0.0F);
+    m_crossed.assign(m_numChannels, 0);
+    m_lastSpike.assign(m_numChannels, 0);
+    m_highpass.setParameters(SpikeDetectionHighpassCutoff, sampleRate, m_numChannels);
+    reset();
+}
+
+void ThresholdSpikeDetector::reset()
+{
+    m_highpass.reset();
+    m_primed = false;
+}
+
+void ThresholdSpikeDetector::detect(const float* data, int nSamples, int64_t firstSample, vector<SpikeEvent>* events)
+{
+    const int nc = m_numChannels;
+    if (nSamples <= 0 || m_numActive == 0)
+        return;
+
+    size_t count = (size_t) nSamples * nc;
+    if (m_scratch.size() < count)
+        m_scratch.resize(count);
+    copy(data, data + count, m_scratch.begin());
+    m_highpass.filter(m_scratch.data(), nSamples);
+
+    const float* sign = m_sign.data();
+    const float* threshold = m_threshold.data();
+    float* previous = m_previous.data();
+    uint8_t* crossed = m_crossed.data();
+
+    if (!m_primed)
+    {
+        for (int c = 0; c < nc; c++)
+        {
+            previous[c] = sign[c] * m_scratch[c];
+            m_lastSpike[c] = firstSample - m_refractorySamples;
+        }
+        m_primed = true;
+    }
+
+    for (int t = 0; t < nSamples; t++)
+    {
+        const float* frame = m_scratch.data() + (size_t) t * nc;
+        uint8_t any = 0;
+        for (int c = 0; c < nc; c++)
+        {
+            float v = sign[c] * frame[c];
+            crossed[c] = (uint8_t) ((v > threshold[c]) & (previous[c] <= threshold[c]));
+            previous[c] = v;
+            any |= crossed[c];
+        }
+        if (!any)
+            continue;
+
+        int64_t sample = firstSample + t;
+        for (int c = 0; c < nc; c++)
+        {
+            if (crossed[c] && sample - m_lastSpike[c] >= m_refractorySamples)
+            {
+                m_lastSpike[c] = sample;
+                if (events)
+                    events->push_back({ sample, c });
+            }
+        }
+    }
+}
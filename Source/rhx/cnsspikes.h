@@ -0,0 +1,63 @@
+/*
+ * cnsspikes.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSSPIKES_H_
+#define RHX_CNSSPIKES_H_
+
+#include "cnsrhx.h"
+#include "cnsfilter.h"
+#include <vector>
+#include <cstdint>
+
+// Spike detection runs on a high-passed copy of the data, like the RHX spike scope.
+const double SpikeDetectionHighpassCutoff = 250.0;
+
+// Default refractory period (in seconds) after a detected spike.
+const double SpikeRefractoryPeriod = 0.001;
+
+struct SpikeEvent
+{
+    int64_t sample;
+    int channel;
+};
+
+// Threshold crossing detector using the spike scope settings saved in the header for each
+// channel (spikeScopeVoltageThreshold, in uV, and spikeScopeTriggerPolarity). Only channels
+// whose spikeScopeTriggerMode is voltage threshold are scanned.
+// Blocks are in frames (one frame per sample, channel index varying fastest). The crossing test
+// runs across all channels of a frame without branches; only frames with a crossing are looked
+// at channel by channel for the refractory period.
+class ThresholdSpikeDetector
+{
+public:
+    ThresholdSpikeDetector();
+
+    void setParameters(const std::vector<HeaderFileChannel>& channels, double sampleRate, double refractoryPeriod);
+    bool isActive() const { return m_numActive > 0; }
+
+    void reset();
+    int warmUpLength() const { return m_highpass.warmUpLength(); }
+
+    // Scan nSamples frames (uV) whose first frame is sample number firstSample. Crossings are
+    // appended to events, in sample order; pass nullptr to only update the detector state.
+    void detect(const float* data, int nSamples, int64_t firstSample, std::vector<SpikeEvent>* events);
+
+private:
+    int m_numChannels;
+    int m_numActive;
+    int m_refractorySamples;
+    bool m_primed;
+    MultichannelHighpassFilter m_highpass;
+    std::vector<float> m_scratch;
+    std::vector<float> m_sign;          // +1 rising edge, -1 falling edge, 0 not scanned
+    std::vector<float> m_threshold;     // sign * threshold
+    std::vector<float> m_previous;      // sign * previous sample
+    std::vector<uint8_t> m_crossed;
+    std::vector<int64_t> m_lastSpike;
+};
+
+
+#endif /* RHX_CNSSPIKES_H_ */
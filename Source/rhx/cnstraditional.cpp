@@ -0,0 +1,447 @@
+/*
+ * cnstraditional.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <exception>
+#include <stdexcept>
+#include <filesystem>
+#include <algorithm>
+#include <utility>
+#include <memory>
+#include <cstring>
+#include "cnstraditional.h"
+using namespace std;
+
+
+// Blocks read from the file at a time.
+static const int64_t TraditionalReadBlocks = 256;
+
+TraditionalBlockLayout traditionalBlockLayout(const IntanHeaderInfo& info)
+{
+    TraditionalBlockLayout layout;
+    const int s = info.samplesPerDataBlock;
+    layout.samplesPerBlock = s;
+    layout.numAmplifierChannels = info.numEnabledAmplifierChannels;
+    layout.numAdcChannels = info.numEnabledBoardAdcChannels;
+    layout.numDacChannels = (info.fileType == RHSHeaderFile) ? info.numEnabledBoardDacChannels : 0;
+
+    // Timestamps (32 bits each), then the amplifier data, channel by channel.
+    int offset = 2 * s;
+    layout.amplifierOffset = offset;
+    offset += s * layout.numAmplifierChannels;
+    layout.dcAmplifierOffset = offset;
+    layout.stimOffset = offset;
+    if (info.fileType == RHSHeaderFile)
+    {
+        if (info.dcAmplifierDataSaved)
+            offset += s * layout.numAmplifierChannels;
+        layout.stimOffset = offset;
+        offset += s * layout.numAmplifierChannels;
+    }
+    else
+    {
+        // Auxiliary inputs at a quarter of the rate, one supply voltage and temperature sample per block.
+        offset += (s / 4) * info.numEnabledAuxInputChannels;
+        offset += info.numEnabledSupplyVoltageChannels;
+        offset += info.numTempSensors;
+    }
+    layout.adcOffset = offset;
+    offset += s * layout.numAdcChannels;
+    layout.dacOffset = offset;
+    offset += s * layout.numDacChannels;
+    layout.digitalInOffset = offset;
+    if (info.numEnabledDigitalInChannels > 0)
+        offset += s;
+    layout.digitalOutOffset = offset;
+    if (info.numEnabledDigitalOutChannels > 0)
+        offset += s;
+    layout.wordsPerBlock = offset;
+    return layout;
+}
+
+unsigned traditionalBlockSignals(const IntanHeaderInfo& info)
+{
+    unsigned signals = 0;
+    if (info.numEnabledBoardAdcChannels > 0)
+        signals |= TraditionalAdcSignal;
+    if (info.numEnabledDigitalInChannels > 0)
+        signals |= TraditionalDigitalInSignal;
+    if (info.numEnabledDigitalOutChannels > 0)
+        signals |= TraditionalDigitalOutSignal;
+    if (info.fileType == RHSHeaderFile)
+    {
+        if (info.numEnabledBoardDacChannels > 0)
+            signals |= TraditionalDacSignal;
+        if (info.dcAmplifierDataSaved)
+            signals |= TraditionalDcAmplifierSignal;
+    }
+    return signals;
+}
+
+// A block holds each channel's samples in a run; frames interleave them. flip is xor'ed into each word.
+template <int BlockSize>
+static inline void blockToFrames(const uint16_t* block, int numChannels, uint16_t flip, uint16_t* frames)
+{
+    for (int c = 0; c < numChannels; c++, block += BlockSize)
+    {
+        for (int t = 0; t < BlockSize; t++)
+            frames[t * numChannels + c] = block[t] ^ flip;
+    }
+}
+
+template <HeaderFileType Type, int BlockSize, unsigned Signals>
+static void decodeBlocks(const uint16_t* blocks, int64_t nBlocks, const TraditionalBlockLayout& layout,
+                         const TraditionalSamples& out)
+{
+    const int na = layout.numAmplifierChannels;
+    for (int64_t b = 0; b < nBlocks; b++, blocks += layout.wordsPerBlock)
+    {
+        const int64_t first = b * BlockSize;
+        if (out.timestamps)
+            memcpy(out.timestamps + first, blocks, BlockSize * sizeof(int32_t));
+
+        // Amplifier words are offset binary; xor with 0x8000 makes them the signed words of amplifier.dat.
+        if (out.amplifier)
+            blockToFrames<BlockSize>(blocks + layout.amplifierOffset, na, 0x8000, (uint16_t *) out.amplifier + first * na);
+        if constexpr (Type == RHSHeaderFile)
+        {
+            if constexpr ((Signals & TraditionalDcAmplifierSignal) != 0)
+            {
+                if (out.dcAmplifier)
+                    blockToFrames<BlockSize>(blocks + layout.dcAmplifierOffset, na, 0, out.dcAmplifier + first * na);
+            }
+            if (out.stim)
+                blockToFrames<BlockSize>(blocks + layout.stimOffset, na, 0, out.stim + first * na);
+        }
+        if constexpr ((Signals & TraditionalAdcSignal) != 0)
+        {
+            if (out.boardAdc)
+                blockToFrames<BlockSize>(blocks + layout.adcOffset, layout.numAdcChannels, 0, out.boardAdc + first * layout.numAdcChannels);
+        }
+        if constexpr ((Signals & TraditionalDacSignal) != 0)
+        {
+            if (out.boardDac)
+                blockToFrames<BlockSize>(blocks + layout.dacOffset, layout.numDacChannels, 0, out.boardDac + first * layout.numDacChannels);
+        }
+        if constexpr ((Signals & TraditionalDigitalInSignal) != 0)
+        {
+            if (out.digitalIn)
+                memcpy(out.digitalIn + first, blocks + layout.digitalInOffset, BlockSize * sizeof(uint16_t));
+        }
+        if constexpr ((Signals & TraditionalDigitalOutSignal) != 0)
+        {
+            if (out.digitalOut)
+                memcpy(out.digitalOut + first, blocks + layout.digitalOutOffset, BlockSize * sizeof(uint16_t));
+        }
+    }
+}
+
+// Table of the decoders for every signal mask of one file type and block size.
+template <HeaderFileType Type, int BlockSize, unsigned... Signals>
+static TraditionalBlockDecoder selectDecoder(unsigned signals, integer_sequence<unsigned, Signals...>)
+{
+    static const TraditionalBlockDecoder decoders[] = { decodeBlocks<Type, BlockSize, Signals>... };
+    return decoders[signals];
+}
+
+TraditionalBlockDecoder traditionalBlockDecoder(const IntanHeaderInfo& info)
+{
+    const unsigned signals = traditionalBlockSignals(info);
+    if (info.fileType == RHSHeaderFile && info.samplesPerDataBlock == 128)
+        return selectDecoder<RHSHeaderFile, 128>(signals, make_integer_sequence<unsigned, 32>());
+    if (info.fileType == RHDHeaderFile && info.samplesPerDataBlock == 128)
+        return selectDecoder<RHDHeaderFile, 128>(signals, make_integer_sequence<unsigned, 8>());
+    if (info.fileType == RHDHeaderFile && info.samplesPerDataBlock == 60)
+        return selectDecoder<RHDHeaderFile, 60>(signals, make_integer_sequence<unsigned, 8>());
+    throw std::runtime_error("Traditional Error: unsupported data block size");
+}
+
+bool isTraditionalIntanFile(const string& filename)
+{
+    IntanHeaderInfo info;
+    try
+    {
+        readIntanHeader(filename.c_str(), info, true);
+    }
+    catch (std::exception &)
+    {
+        return false;
+    }
+    return !info.headerOnly;
+}
+
+
+TraditionalIntanReader::TraditionalIntanReader()
+: m_signals(0)
+, m_decode(nullptr)
+, m_numSamples(0)
+{
+    memset(&m_layout, 0, sizeof(m_layout));
+}
+
+TraditionalIntanReader::~TraditionalIntanReader()
+{
+    close();
+}
+
+void TraditionalIntanReader::open(const string& filename)
+{
+    close();
+    readIntanHeader(filename.c_str(), m_info, true);
+    if (m_info.headerOnly)
+        throw std::runtime_error("Traditional Error: " + filename + " holds no data blocks");
+    m_layout = traditionalBlockLayout(m_info);
+    m_signals = traditionalBlockSignals(m_info);
+    m_decode = traditionalBlockDecoder(m_info);
+
+    // A recording stopped mid-write can end in a partial block; it is ignored.
+    const int64_t bytesPerBlock = (int64_t) m_layout.wordsPerBlock * (int64_t) sizeof(uint16_t);
+    m_info.bytesPerDataBlock = (int) bytesPerBlock;
+    m_info.numDataBlocksInFile = m_info.dataSizeInBytes / bytesPerBlock;
+    m_info.numSamplesInFile = m_info.numDataBlocksInFile * m_layout.samplesPerBlock;
+    m_numSamples = m_info.numSamplesInFile;
+
+    m_file.open(filename, ios::in | ios::binary);
+    if (!m_file)
+    {
+        close();
+        throw std::runtime_error("Traditional Error: cannot open " + filename);
+    }
+
+    const int s = m_layout.samplesPerBlock;
+    const int na = m_layout.numAmplifierChannels;
+    m_scratchTimestamps.resize(s);
+    m_scratchAmplifier.resize((size_t) s * na);
+    m_scratchWords.resize((size_t) s * (2 * na + m_layout.numAdcChannels + m_layout.numDacChannels + 2));
+    uint16_t* words = m_scratchWords.data();
+    m_scratch.timestamps = m_scratchTimestamps.data();
+    m_scratch.amplifier = m_scratchAmplifier.data();
+    m_scratch.dcAmplifier = words;
+    m_scratch.stim = (words += (size_t) s * na);
+    m_scratch.boardAdc = (words += (size_t) s * na);
+    m_scratch.boardDac = (words += (size_t) s * m_layout.numAdcChannels);
+    m_scratch.digitalIn = (words += (size_t) s * m_layout.numDacChannels);
+    m_scratch.digitalOut = (words += s);
+}
+
+void TraditionalIntanReader::close()
+{
+    if (m_file.is_open())
+        m_file.close();
+    m_file.clear();
+    m_signals = 0;
+    m_decode = nullptr;
+    m_numSamples = 0;
+    m_blocks.clear();
+    m_scratch = TraditionalSamples();
+}
+
+void TraditionalIntanReader::readBlocks(int64_t firstBlock, int64_t nBlocks)
+{
+    const int64_t bytesPerBlock = (int64_t) m_layout.wordsPerBlock * (int64_t) sizeof(uint16_t);
+    m_blocks.resize((size_t) (nBlocks * m_layout.wordsPerBlock));
+    m_file.clear();
+    m_file.seekg(m_info.headerSizeInBytes + firstBlock * bytesPerBlock, ios::beg);
+    if (!m_file.read((char *) m_blocks.data(), nBlocks * bytesPerBlock))
+        throw std::runtime_error("Traditional Error: cannot read data blocks");
+}
+
+// out, advanced by offset samples.
+static TraditionalSamples advanceSamples(const TraditionalSamples& out, int64_t offset, const TraditionalBlockLayout& layout)
+{
+    TraditionalSamples advanced;
+    const int64_t na = layout.numAmplifierChannels;
+    if (out.timestamps) advanced.timestamps = out.timestamps + offset;
+    if (out.amplifier) advanced.amplifier = out.amplifier + offset * na;
+    if (out.dcAmplifier) advanced.dcAmplifier = out.dcAmplifier + offset * na;
+    if (out.stim) advanced.stim = out.stim + offset * na;
+    if (out.boardAdc) advanced.boardAdc = out.boardAdc + offset * layout.numAdcChannels;
+    if (out.boardDac) advanced.boardDac = out.boardDac + offset * layout.numDacChannels;
+    if (out.digitalIn) advanced.digitalIn = out.digitalIn + offset;
+    if (out.digitalOut) advanced.digitalOut = out.digitalOut + offset;
+    return advanced;
+}
+
+template <typename T>
+static void copyFrames(const T* from, int64_t first, int64_t n, int64_t numChannels, T* to)
+{
+    if (to)
+        memcpy(to, from + first * numChannels, (size_t) (n * numChannels) * sizeof(T));
+}
+
+int64_t TraditionalIntanReader::read(int64_t firstSample, int64_t nSamples, const TraditionalSamples& out)
+{
+    nSamples = min(nSamples, m_numSamples - firstSample);
+    if (firstSample < 0 || nSamples <= 0)
+        return 0;
+    const int s = m_layout.samplesPerBlock;
+    int64_t done = 0;
+    while (done < nSamples)
+    {
+        const int64_t sample = firstSample + done;
+        const int64_t block = sample / s;
+        const int64_t skip = sample % s;
+        if (skip == 0 && nSamples - done >= s)
+        {
+            const int64_t nBlocks = min((nSamples - done) / s, TraditionalReadBlocks);
+            readBlocks(block, nBlocks);
+            m_decode(m_blocks.data(), nBlocks, m_layout, advanceSamples(out, done, m_layout));
+            done += nBlocks * s;
+            continue;
+        }
+
+        // A partial block, through the scratch buffers.
+        const int64_t n = min(s - skip, nSamples - done);
+        readBlocks(block, 1);
+        m_decode(m_blocks.data(), 1, m_layout, m_scratch);
+        const TraditionalSamples to = advanceSamples(out, done, m_layout);
+        const int64_t na = m_layout.numAmplifierChannels;
+        copyFrames(m_scratch.timestamps, skip, n, 1, to.timestamps);
+        copyFrames(m_scratch.amplifier, skip, n, na, to.amplifier);
+        if (m_signals & TraditionalDcAmplifierSignal)
+            copyFrames(m_scratch.dcAmplifier, skip, n, na, to.dcAmplifier);
+        if (m_info.fileType == RHSHeaderFile)
+            copyFrames(m_scratch.stim, skip, n, na, to.stim);
+        if (m_signals & TraditionalAdcSignal)
+            copyFrames(m_scratch.boardAdc, skip, n, m_layout.numAdcChannels, to.boardAdc);
+        if (m_signals & TraditionalDacSignal)
+            copyFrames(m_scratch.boardDac, skip, n, m_layout.numDacChannels, to.boardDac);
+        if (m_signals & TraditionalDigitalInSignal)
+            copyFrames(m_scratch.digitalIn, skip, n, 1, to.digitalIn);
+        if (m_signals & TraditionalDigitalOutSignal)
+            copyFrames(m_scratch.digitalOut, skip, n, 1, to.digitalOut);
+        done += n;
+    }
+    return done;
+}
+
+
+void unpackTraditionalFile(const string& filename, const string& outputDirectory,
+                           const TranscodeOptions& options, const atomic<bool>* cancel, atomic<double>* progress)
+{
+    TraditionalIntanReader reader;
+    reader.open(filename);
+    const IntanHeaderInfo& info = reader.info();
+    const TraditionalBlockLayout& layout = reader.layout();
+    const unsigned signals = reader.signals();
+
+    filesystem::path output(outputDirectory);
+    filesystem::create_directories(output);
+    filesystem::path header = output / ((info.fileType == RHSHeaderFile) ? "info.rhs" : "info.rhd");
+    error_code ec;
+    if (filesystem::equivalent(filename, header, ec))
+        throw std::runtime_error("Traditional Error: the output directory must not hold the recording");
+
+    // The header only file is the header of the traditional file, as is.
+    {
+        vector<char> bytes(info.headerSizeInBytes);
+        ifstream in(filename, ios::in | ios::binary);
+        ofstream out(header.string(), ios::out | ios::binary | ios::trunc);
+        if (!in.read(bytes.data(), (streamsize) bytes.size()) || !out.write(bytes.data(), (streamsize) bytes.size()))
+            throw std::runtime_error("Traditional Error: cannot write " + header.string());
+    }
+
+    // Chunks of whole blocks, as many as half the memory budget holds (the other half is the reader's).
+    const int s = layout.samplesPerBlock;
+    const int64_t bytesPerBlock = (int64_t) layout.wordsPerBlock * (int64_t) sizeof(uint16_t);
+    const int64_t chunkSamples = max<int64_t>(1, options.memoryBudget / 2 / bytesPerBlock) * s;
+    vector<int32_t> timestamps(chunkSamples);
+    vector<int16_t> amplifier((size_t) (chunkSamples * layout.numAmplifierChannels));
+    vector<uint16_t> adc, dac, digitalIn, digitalOut;
+    TraditionalSamples samples;
+    samples.timestamps = timestamps.data();
+    samples.amplifier = amplifier.data();
+
+    struct OutputFile
+    {
+        string filename;
+        ofstream out;
+        const char* data;
+        int64_t bytesPerSample;
+    };
+    vector<unique_ptr<OutputFile>> files;
+    auto addFile = [&](const char* name, const void* data, int64_t bytesPerSample)
+    {
+        unique_ptr<OutputFile> file(new OutputFile);
+        file->filename = (output / name).string();
+        file->out.open(file->filename, ios::out | ios::binary | ios::trunc);
+        if (!file->out)
+            throw std::runtime_error("Traditional Error: cannot create " + file->filename);
+        file->data = (const char *) data;
+        file->bytesPerSample = bytesPerSample;
+        files.push_back(move(file));
+    };
+    auto removeAll = [&]()
+    {
+        for (unique_ptr<OutputFile>& file : files)
+        {
+            file->out.close();
+            filesystem::remove(file->filename, ec);
+        }
+    };
+
+    try
+    {
+        addFile("time.dat", timestamps.data(), sizeof(int32_t));
+        addFile("amplifier.dat", amplifier.data(), layout.numAmplifierChannels * (int64_t) sizeof(int16_t));
+        if (signals & TraditionalAdcSignal)
+        {
+            adc.resize((size_t) (chunkSamples * layout.numAdcChannels));
+            samples.boardAdc = adc.data();
+            addFile("analogin.dat", adc.data(), layout.numAdcChannels * (int64_t) sizeof(uint16_t));
+        }
+        if (signals & TraditionalDacSignal)
+        {
+            dac.resize((size_t) (chunkSamples * layout.numDacChannels));
+            samples.boardDac = dac.data();
+            addFile("analogout.dat", dac.data(), layout.numDacChannels * (int64_t) sizeof(uint16_t));
+        }
+        if (signals & TraditionalDigitalInSignal)
+        {
+            digitalIn.resize((size_t) chunkSamples);
+            samples.digitalIn = digitalIn.data();
+            addFile("digitalin.dat", digitalIn.data(), sizeof(uint16_t));
+        }
+        if (signals & TraditionalDigitalOutSignal)
+        {
+            digitalOut.resize((size_t) chunkSamples);
+            samples.digitalOut = digitalOut.data();
+            addFile("digitalout.dat", digitalOut.data(), sizeof(uint16_t));
+        }
+
+        const int64_t numSamples = reader.numSamples();
+        for (int64_t first = 0; first < numSamples; first += chunkSamples)
+        {
+            if (cancel && *cancel)
+            {
+                removeAll();
+                filesystem::remove(header, ec);
+                return;
+            }
+            const int64_t n = reader.read(first, min(chunkSamples, numSamples - first), samples);
+            for (unique_ptr<OutputFile>& file : files)
+            {
+                if (!file->out.write(file->data, (streamsize) (n * file->bytesPerSample)))
+                    throw std::runtime_error("Traditional Error: cannot write " + file->filename);
+            }
+            if (progress)
+                *progress = (double) (first + n) / (double) numSamples;
+        }
+        for (unique_ptr<OutputFile>& file : files)
+        {
+            file->out.close();
+            if (!file->out)
+                throw std::runtime_error("Traditional Error: cannot write " + file->filename);
+        }
+    }
+    catch (std::exception &)
+    {
+        removeAll();
+        filesystem::remove(header, ec);
+        throw;
+    }
+    if (progress)
+        *progress = 1.0;
+}
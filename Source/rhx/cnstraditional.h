@@ -0,0 +1,129 @@
+/*
+ * cnstraditional.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSTRADITIONAL_H_
+#define RHX_CNSTRADITIONAL_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <atomic>
+#include <cstdint>
+#include "cnsrhx.h"
+#include "cnstranscode.h"
+
+// Signals, besides the timestamps and amplifier data every block holds, that a "traditional" (all in one
+// file) data block may hold and a decoder copies out. RHD blocks only use the low three bits; RHS blocks
+// always hold stimulation data as well.
+enum TraditionalBlockSignal
+{
+    TraditionalAdcSignal = 1,
+    TraditionalDigitalInSignal = 2,
+    TraditionalDigitalOutSignal = 4,
+    TraditionalDacSignal = 8,               // RHS only
+    TraditionalDcAmplifierSignal = 16       // RHS only
+};
+
+// Block layout of a traditional file, from its header. Offsets are in 16-bit words from the start of a block.
+struct TraditionalBlockLayout
+{
+    int samplesPerBlock;
+    int wordsPerBlock;
+    int numAmplifierChannels;
+    int numAdcChannels;
+    int numDacChannels;
+    int amplifierOffset;
+    int dcAmplifierOffset;
+    int stimOffset;
+    int adcOffset;
+    int dacOffset;
+    int digitalInOffset;
+    int digitalOutOffset;
+};
+
+TraditionalBlockLayout traditionalBlockLayout(const IntanHeaderInfo& info);
+
+// The TraditionalBlockSignal bits of the signals present in the blocks of a file.
+unsigned traditionalBlockSignals(const IntanHeaderInfo& info);
+
+// Destination of decoded samples; null pointers are skipped. Signals with several channels are written as
+// frames (channel index varying fastest), as in the "one file per signal type" format: amplifier words as
+// the signed words of amplifier.dat, the others as saved.
+struct TraditionalSamples
+{
+    int32_t* timestamps = nullptr;
+    int16_t* amplifier = nullptr;
+    uint16_t* dcAmplifier = nullptr;
+    uint16_t* stim = nullptr;
+    uint16_t* boardAdc = nullptr;
+    uint16_t* boardDac = nullptr;
+    uint16_t* digitalIn = nullptr;
+    uint16_t* digitalOut = nullptr;
+};
+
+// Decode nBlocks consecutive blocks into out, from sample 0 of each destination on.
+typedef void (*TraditionalBlockDecoder)(const uint16_t* blocks, int64_t nBlocks, const TraditionalBlockLayout& layout,
+                                        const TraditionalSamples& out);
+
+// The decoder for a file: an instantiation for its file type, samples per block (60 for RHD files before
+// version 2, 128 otherwise) and signal mask, so the block loop tests none of them and the per-channel
+// loops run over a block size known at compile time. Will throw() if the header doesn't describe a block
+// layout there is a decoder for.
+TraditionalBlockDecoder traditionalBlockDecoder(const IntanHeaderInfo& info);
+
+// True if filename is an .rhd or .rhs file with data blocks after the header.
+bool isTraditionalIntanFile(const std::string& filename);
+
+// Reader for a traditional file. The layout and decoder are chosen once by open(); reads decode whole
+// blocks straight into the caller's buffers, and only the partial blocks at the ends of a range go
+// through a one block scratch buffer.
+class TraditionalIntanReader
+{
+public:
+    TraditionalIntanReader();
+    ~TraditionalIntanReader();
+
+    // Will throw() on fail.
+    void open(const std::string& filename);
+    void close();
+
+    const IntanHeaderInfo& info() const { return m_info; }
+    const TraditionalBlockLayout& layout() const { return m_layout; }
+    unsigned signals() const { return m_signals; }
+    int64_t numSamples() const { return m_numSamples; }
+
+    // Read nSamples samples from firstSample (>= 0) on, up to the end of the data, into out. Returns the
+    // number of samples read.
+    int64_t read(int64_t firstSample, int64_t nSamples, const TraditionalSamples& out);
+
+private:
+    IntanHeaderInfo m_info;
+    TraditionalBlockLayout m_layout;
+    unsigned m_signals;
+    TraditionalBlockDecoder m_decode;
+    int64_t m_numSamples;
+    std::ifstream m_file;
+    std::vector<uint16_t> m_blocks;
+
+    // One block of every signal present, for the partial blocks.
+    std::vector<int32_t> m_scratchTimestamps;
+    std::vector<int16_t> m_scratchAmplifier;
+    std::vector<uint16_t> m_scratchWords;
+    TraditionalSamples m_scratch;
+
+    void readBlocks(int64_t firstBlock, int64_t nBlocks);
+};
+
+// Unpack a traditional file into the "one file per signal type" format in outputDirectory: a header only
+// info.rhd (info.rhs), time.dat, amplifier.dat and, when present, analogin.dat, analogout.dat, digitalin.dat
+// and digitalout.dat. Stimulation and DC amplifier words are not unpacked (their encoding in stim.dat and
+// dcamplifier.dat differs); read them with TraditionalIntanReader.
+// Runs in the calling thread, and will throw() on fail; cancel and progress may be null.
+void unpackTraditionalFile(const std::string& filename, const std::string& outputDirectory,
+                           const TranscodeOptions& options, const std::atomic<bool>* cancel, std::atomic<double>* progress);
+
+
+#endif /* RHX_CNSTRADITIONAL_H_ */
@@ -0,0 +1,404 @@
+/*
+ * cnstranscode.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <fstream>
+#include <exception>
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "cnsreader.h"
+#include "cnstranscode.h"
+using namespace std;
+
+
+void framesToPlanes(const int16_t* frames, int numChannels, int nSamples, int firstChannel, int numSliceChannels,
+                    int16_t* planes, int64_t planeStride)
+{
+    for (int t0 = 0; t0 < nSamples; t0 += TransposeTile)
+    {
+        const int t1 = min(t0 + TransposeTile, nSamples);
+        for (int c0 = 0; c0 < numSliceChannels; c0 += TransposeTile)
+        {
+            const int c1 = min(c0 + TransposeTile, numSliceChannels);
+            for (int c = c0; c < c1; c++)
+            {
+                const int16_t* in = frames + (size_t) firstChannel + c;
+                int16_t* out = planes + c * planeStride;
+                for (int t = t0; t < t1; t++)
+                    out[t] = in[(size_t) t * numChannels];
+            }
+        }
+    }
+}
+
+void planesToFrames(const int16_t* planes, int64_t planeStride, int numChannels, int nSamples, int firstChannel,
+                    int numSliceChannels, int16_t* frames)
+{
+    for (int t0 = 0; t0 < nSamples; t0 += TransposeTile)
+    {
+        const int t1 = min(t0 + TransposeTile, nSamples);
+        for (int c0 = 0; c0 < numSliceChannels; c0 += TransposeTile)
+        {
+            const int c1 = min(c0 + TransposeTile, numSliceChannels);
+            for (int t = t0; t < t1; t++)
+            {
+                int16_t* out = frames + (size_t) t * numChannels + firstChannel;
+                for (int c = c0; c < c1; c++)
+                    out[c] = planes[c * planeStride + t];
+            }
+        }
+    }
+}
+
+string perChannelFilename(const HeaderFileChannel& channel)
+{
+    return "amp-" + channel.nativeChannelName + ".dat";
+}
+
+
+// Hand-off of chunks between the main thread and the workers. Each side counts the chunks it has
+// finished, and waits for the other side's count to reach a given value. fail() releases every wait.
+class ChunkSchedule
+{
+public:
+    ChunkSchedule(int numWorkers)
+    : m_main(0)
+    , m_workers(numWorkers, 0)
+    , m_failed(false)
+    {
+    }
+
+    // Both return false if the transcode has failed.
+    bool waitForMain(int64_t count)
+    {
+        unique_lock<mutex> lock(m_mutex);
+        m_changed.wait(lock, [&]() { return m_failed || m_main >= count; });
+        return !m_failed;
+    }
+
+    bool waitForWorkers(int64_t count)
+    {
+        unique_lock<mutex> lock(m_mutex);
+        m_changed.wait(lock, [&]() { return m_failed || *min_element(m_workers.begin(), m_workers.end()) >= count; });
+        return !m_failed;
+    }
+
+    void mainDone(int64_t count) { update(&m_main, count); }
+    void workerDone(int worker, int64_t count) { update(&m_workers[worker], count); }
+
+    void fail(const string& error)
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (!m_failed)
+                m_error = error;
+            m_failed = true;
+        }
+        m_changed.notify_all();
+    }
+
+    bool failed()
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return m_failed;
+    }
+
+    string error()
+    {
+        lock_guard<mutex> lock(m_mutex);
+        return m_error;
+    }
+
+private:
+    mutex m_mutex;
+    condition_variable m_changed;
+    int64_t m_main;
+    vector<int64_t> m_workers;
+    bool m_failed;
+    string m_error;
+
+    void update(int64_t* counter, int64_t count)
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            *counter = count;
+        }
+        m_changed.notify_all();
+    }
+};
+
+// Chunk size, slices and buffers shared by both directions.
+struct TranscodePlan
+{
+    int numChannels;
+    int64_t numSamples;
+    int chunkSize;
+    int64_t numChunks;
+    vector<int> sliceStart;             // numWorkers + 1 entries
+    vector<int16_t> chunks[2];
+
+    TranscodePlan(int nc, int64_t nSamples, const TranscodeOptions& options)
+    : numChannels(nc)
+    , numSamples(nSamples)
+    {
+        // Two interleaved chunk buffers plus the workers' planes: three chunks of frames in all.
+        int64_t frames = options.memoryBudget / (3 * (int64_t) nc * (int64_t) sizeof(int16_t));
+        frames = min<int64_t>(frames, (numSamples + TransposeTile - 1) / TransposeTile * TransposeTile);
+        frames = min<int64_t>(frames / TransposeTile * TransposeTile, (int64_t) 1 << 30);
+        chunkSize = (int) max<int64_t>(frames, TransposeTile);
+        numChunks = (numSamples + chunkSize - 1) / chunkSize;
+
+        int numWorkers = (options.numThreads > 0) ? options.numThreads : (int) thread::hardware_concurrency();
+        numWorkers = max(1, min(numWorkers, nc));
+        for (int w = 0; w <= numWorkers; w++)
+            sliceStart.push_back((int) ((int64_t) w * nc / numWorkers));
+        for (vector<int16_t>& chunk : chunks)
+            chunk.resize((size_t) chunkSize * nc);
+    }
+
+    int numWorkers() const { return (int) sliceStart.size() - 1; }
+    int chunkSamples(int64_t k) const { return (int) min<int64_t>(chunkSize, numSamples - k * chunkSize); }
+};
+
+// Header file and time.dat, copied next to the converted data.
+static void copyRecordingFiles(const string& headerFilename, const string& outputDirectory)
+{
+    filesystem::path header(headerFilename);
+    filesystem::path output(outputDirectory);
+    filesystem::create_directories(output);
+    error_code ec;
+    if (filesystem::equivalent(header.parent_path(), output, ec))
+        throw std::runtime_error("Transcode Error: the output directory must not be the recording directory");
+    filesystem::copy_file(header, output / header.filename(), filesystem::copy_options::overwrite_existing);
+    filesystem::path time = header.parent_path() / "time.dat";
+    if (filesystem::exists(time))
+        filesystem::copy_file(time, output / "time.dat", filesystem::copy_options::overwrite_existing);
+}
+
+// Runs worker(w) on a thread per slice and the main loop on this thread; rethrows the first error.
+// Returns false if cancelled.
+template <typename Worker, typename Main>
+static bool runTranscode(TranscodePlan& plan, ChunkSchedule& schedule, Worker worker, Main main)
+{
+    vector<thread> threads;
+    for (int w = 0; w < plan.numWorkers(); w++)
+    {
+        threads.emplace_back([&, w]()
+        {
+            try
+            {
+                worker(w);
+            }
+            catch (std::exception &e)
+            {
+                schedule.fail(e.what());
+            }
+        });
+    }
+    bool finished = false;
+    try
+    {
+        finished = main();
+    }
+    catch (std::exception &e)
+    {
+        schedule.fail(e.what());
+    }
+    if (!finished)
+        schedule.fail("");
+    for (thread& t : threads)
+        t.join();
+    if (!schedule.error().empty())
+        throw std::runtime_error(schedule.error());
+    return finished;
+}
+
+static void removeFiles(const vector<string>& filenames)
+{
+    error_code ec;
+    for (const string& filename : filenames)
+        filesystem::remove(filename, ec);
+}
+
+void splitAmplifierChannels(const string& headerFilename, const string& outputDirectory,
+                            const TranscodeOptions& options, const atomic<bool>* cancel, atomic<double>* progress)
+{
+    IntanDataReader reader;
+    reader.open(headerFilename);
+    const int nc = reader.numAmplifierChannels();
+    if (nc == 0)
+        throw std::runtime_error("Transcode Error: no amplifier channels");
+    copyRecordingFiles(headerFilename, outputDirectory);
+
+    vector<string> filenames;
+    for (const HeaderFileChannel& channel : reader.amplifierChannels())
+    {
+        filenames.push_back((filesystem::path(outputDirectory) / perChannelFilename(channel)).string());
+        ofstream create(filenames.back(), ios::out | ios::binary | ios::trunc);
+        if (!create)
+            throw std::runtime_error("Transcode Error: cannot create " + filenames.back());
+    }
+
+    TranscodePlan plan(nc, reader.numSamples(), options);
+    ChunkSchedule schedule(plan.numWorkers());
+
+    // A worker transposes its slice of chunk k once it has been read, and appends it to its files.
+    // The files are opened for each chunk, so a thousand channels don't need a thousand descriptors.
+    auto worker = [&](int w)
+    {
+        const int first = plan.sliceStart[w];
+        const int count = plan.sliceStart[w + 1] - first;
+        vector<int16_t> planes((size_t) count * plan.chunkSize);
+        for (int64_t k = 0; k < plan.numChunks; k++)
+        {
+            if (!schedule.waitForMain(k + 1))
+                return;
+            const int n = plan.chunkSamples(k);
+            framesToPlanes(plan.chunks[k % 2].data(), nc, n, first, count, planes.data(), plan.chunkSize);
+            for (int c = 0; c < count; c++)
+            {
+                ofstream out(filenames[first + c], ios::out | ios::binary | ios::app);
+                if (!out.write((const char *)(planes.data() + (size_t) c * plan.chunkSize), (streamsize) n * sizeof(int16_t)))
+                    throw std::runtime_error("Transcode Error: cannot write " + filenames[first + c]);
+            }
+            schedule.workerDone(w, k + 1);
+        }
+    };
+
+    // The main thread reads chunk k into a buffer once the workers are done with chunk k - 2.
+    auto main = [&]()
+    {
+        for (int64_t k = 0; k < plan.numChunks; k++)
+        {
+            if (cancel && *cancel)
+                return false;
+            if (!schedule.waitForWorkers(k - 1))
+                return true;
+            if (reader.readAmplifierData(plan.chunks[k % 2].data(), plan.chunkSamples(k)) != plan.chunkSamples(k))
+                throw std::runtime_error("Transcode Error: cannot read amplifier.dat");
+            schedule.mainDone(k + 1);
+            if (progress)
+                *progress = (double) k / (double) plan.numChunks;
+        }
+        schedule.waitForWorkers(plan.numChunks);
+        return true;
+    };
+
+    bool finished = false;
+    try
+    {
+        finished = runTranscode(plan, schedule, worker, main);
+    }
+    catch (std::exception &)
+    {
+        removeFiles(filenames);
+        throw;
+    }
+    if (!finished)
+        removeFiles(filenames);
+    else if (progress)
+        *progress = 1.0;
+}
+
+void mergeAmplifierChannels(const string& headerFilename, const string& outputDirectory,
+                            const TranscodeOptions& options, const atomic<bool>* cancel, atomic<double>* progress)
+{
+    IntanHeaderInfo info;
+    readIntanHeader(headerFilename.c_str(), info);
+    vector<HeaderFileChannel> channels = enabledAmplifierChannels(info);
+    const int nc = (int) channels.size();
+    if (nc == 0)
+        throw std::runtime_error("Transcode Error: no amplifier channels");
+
+    // Every channel file must hold the same number of samples.
+    filesystem::path directory = filesystem::path(headerFilename).parent_path();
+    vector<string> filenames;
+    int64_t numSamples = -1;
+    for (const HeaderFileChannel& channel : channels)
+    {
+        filenames.push_back((directory / perChannelFilename(channel)).string());
+        error_code ec;
+        int64_t size = (int64_t) filesystem::file_size(filenames.back(), ec);
+        if (ec)
+            throw std::runtime_error("Transcode Error: cannot find " + filenames.back());
+        if (numSamples >= 0 && size / (int64_t) sizeof(int16_t) != numSamples)
+            throw std::runtime_error("Transcode Error: " + filenames.back() + " has a different length");
+        numSamples = size / (int64_t) sizeof(int16_t);
+    }
+    copyRecordingFiles(headerFilename, outputDirectory);
+
+    string dataFilename = (filesystem::path(outputDirectory) / "amplifier.dat").string();
+    ofstream out(dataFilename, ios::out | ios::binary | ios::trunc);
+    if (!out)
+        throw std::runtime_error("Transcode Error: cannot create " + dataFilename);
+
+    TranscodePlan plan(nc, numSamples, options);
+    ChunkSchedule schedule(plan.numWorkers());
+
+    // A worker reads its slice of chunk k from its files once the main thread has written chunk k - 2
+    // out of the buffer, and interleaves it into the buffer.
+    auto worker = [&](int w)
+    {
+        const int first = plan.sliceStart[w];
+        const int count = plan.sliceStart[w + 1] - first;
+        vector<int16_t> planes((size_t) count * plan.chunkSize);
+        for (int64_t k = 0; k < plan.numChunks; k++)
+        {
+            if (!schedule.waitForMain(k - 1))
+                return;
+            const int n = plan.chunkSamples(k);
+            for (int c = 0; c < count; c++)
+            {
+                ifstream in(filenames[first + c], ios::in | ios::binary);
+                in.seekg(k * plan.chunkSize * (int64_t) sizeof(int16_t), ios::beg);
+                if (!in.read((char *)(planes.data() + (size_t) c * plan.chunkSize), (streamsize) n * sizeof(int16_t)))
+                    throw std::runtime_error("Transcode Error: cannot read " + filenames[first + c]);
+            }
+            planesToFrames(planes.data(), plan.chunkSize, nc, n, first, count, plan.chunks[k % 2].data());
+            schedule.workerDone(w, k + 1);
+        }
+    };
+
+    // The main thread writes chunk k once every worker has filled in its slice.
+    auto main = [&]()
+    {
+        for (int64_t k = 0; k < plan.numChunks; k++)
+        {
+            if (cancel && *cancel)
+                return false;
+            if (!schedule.waitForWorkers(k + 1))
+                return true;
+            if (!out.write((const char *)plan.chunks[k % 2].data(), (streamsize) plan.chunkSamples(k) * nc * sizeof(int16_t)))
+                throw std::runtime_error("Transcode Error: cannot write " + dataFilename);
+            schedule.mainDone(k + 1);
+            if (progress)
+                *progress = (double) (k + 1) / (double) plan.numChunks;
+        }
+        out.close();
+        return true;
+    };
+
+    bool finished = false;
+    try
+    {
+        finished = runTranscode(plan, schedule, worker, main);
+    }
+    catch (std::exception &)
+    {
+        out.close();
+        removeFiles({ dataFilename });
+        throw;
+    }
+    if (!finished)
+    {
+        out.close();
+        removeFiles({ dataFilename });
+    }
+    else if (progress)
+        *progress = 1.0;
+}
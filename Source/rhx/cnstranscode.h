@@ -0,0 +1,53 @@
+/*
+ * cnstranscode.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSTRANSCODE_H_
+#define RHX_CNSTRANSCODE_H_
+
+#include "cnsrhx.h"
+#include <string>
+#include <atomic>
+#include <cstdint>
+
+// Side of the square tiles (frames by channels) the transposes work in. 64 x 64 16-bit words is 8 KB,
+// so a tile of input and a tile of output stay in L1 cache.
+const int TransposeTile = 64;
+
+// Default memory budget for the transcoders: the data buffers, not counting per-file overhead.
+const int64_t DefaultTranscodeMemory = (int64_t) 256 << 20;
+
+// Copy channels firstChannel .. firstChannel + numSliceChannels - 1 of nSamples frames of numChannels
+// channels into planes: one run of planeStride words per channel, sample t of slice channel c at
+// planes[c * planeStride + t]. planesToFrames() is the inverse.
+void framesToPlanes(const int16_t* frames, int numChannels, int nSamples, int firstChannel, int numSliceChannels,
+                    int16_t* planes, int64_t planeStride);
+void planesToFrames(const int16_t* planes, int64_t planeStride, int numChannels, int nSamples, int firstChannel,
+                    int numSliceChannels, int16_t* frames);
+
+// Name of the file of one amplifier channel in the "one file per channel" format.
+std::string perChannelFilename(const HeaderFileChannel& channel);
+
+struct TranscodeOptions
+{
+    int64_t memoryBudget = DefaultTranscodeMemory;
+    int numThreads = 0;                 // 0: one per hardware thread
+};
+
+// Conversion of the amplifier data of a recording between the "one file per signal type" format
+// (amplifier.dat) and the "one file per channel" format (amp-A-000.dat, ...). The header file and
+// time.dat are copied to outputDirectory alongside the converted data.
+// The data is converted in chunks of as many frames as the memory budget allows. Each of numThreads
+// workers handles a slice of the channels: it transposes its slice of a chunk and writes (or reads) its
+// channel files, while the main thread reads (or writes) the interleaved file. Two chunk buffers let the
+// interleaved file I/O overlap the workers.
+// Both run in the calling thread, and will throw() on fail; cancel and progress may be null.
+void splitAmplifierChannels(const std::string& headerFilename, const std::string& outputDirectory,
+                            const TranscodeOptions& options, const std::atomic<bool>* cancel, std::atomic<double>* progress);
+void mergeAmplifierChannels(const std::string& headerFilename, const std::string& outputDirectory,
+                            const TranscodeOptions& options, const std::atomic<bool>* cancel, std::atomic<double>* progress);
+
+
+#endif /* RHX_CNSTRANSCODE_H_ */
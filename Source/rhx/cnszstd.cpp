@@ -0,0 +1,405 @@
+/*
+ * cnszstd.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include <exception>
+#include <filesystem>
+#include <algorithm>
+#include <thread>
+#include <cstring>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include "cnszstd.h"
+using namespace std;
+
+
+static const uint32_t ZstdFrameMagicNumber = 0xFD2FB528;
+static const uint32_t ZstdSkippableMagicNumber = 0x184D2A50;        // to 0x184D2A5F
+static const uint32_t ZstdSkippableMagicMask = 0xFFFFFFF0;
+
+// Seekable format: the seek table is a skippable frame at the end of the file, ending in a footer
+// of the number of frames, a descriptor byte and this magic number.
+static const uint32_t SeekTableMagicNumber = 0x184D2A5E;
+static const uint32_t SeekableMagicNumber = 0x8F92EAB1;
+static const int SeekTableFooterSize = 9;
+
+// Largest frame header: magic, descriptor, window descriptor, 4-byte dictionary ID, 8-byte content size.
+static const int ZstdFrameHeaderMaxSize = 18;
+
+static const uint32_t ZstdIndexMagicNumber = 0x18f8d5e7;
+static const uint32_t ZstdIndexVersionNumber = 1;
+
+template <typename T>
+static bool readValueAt(ifstream& in, int64_t offset, T& value)
+{
+    in.clear();
+    in.seekg(offset, ios::beg);
+    return (bool) in.read((char *)&value, sizeof(value));
+}
+
+#ifdef HAVE_ZSTD
+static void fileIdentity(const string& filename, int64_t& size, int64_t& time)
+{
+    size = (int64_t) filesystem::file_size(filename);
+    time = (int64_t) filesystem::last_write_time(filename).time_since_epoch().count();
+}
+#endif
+
+bool zstdAvailable()
+{
+#ifdef HAVE_ZSTD
+    return true;
+#else
+    return false;
+#endif
+}
+
+
+ZstdDataFile::ZstdDataFile()
+{
+}
+
+ZstdDataFile::~ZstdDataFile()
+{
+    close();
+}
+
+void ZstdDataFile::open(const string& filename, int numThreads)
+{
+    close();
+#ifndef HAVE_ZSTD
+    (void) numThreads;
+    throw std::runtime_error("Zstd Error: cannot read " + filename + ", zstd support was not compiled in");
+#else
+    ifstream in(filename, ios::in | ios::binary);
+    if (!in)
+        throw std::runtime_error("Zstd Error: cannot open " + filename);
+    m_filename = filename;
+    int64_t fileSize, fileTime;
+    fileIdentity(filename, fileSize, fileTime);
+
+    if (!readSeekTable(in, fileSize) && !loadIndex(fileSize, fileTime))
+    {
+        scanFrames(in, fileSize);
+        saveIndex(fileSize, fileTime);
+    }
+
+    vector<int64_t> starts(1, 0);
+    for (const Frame& frame : m_frames)
+        starts.push_back(starts.back() + frame.size);
+
+    int numWorkers = numThreadsToUse(numThreads);
+    m_files = vector<ifstream>(numWorkers);
+    m_data = vector<vector<uint8_t>>(numWorkers);
+    for (ifstream& file : m_files)
+        file.open(filename, ios::in | ios::binary);
+    for (int w = 0; w < numWorkers; w++)
+        m_contexts.push_back(ZSTD_createDCtx());
+    start(starts, numWorkers);
+#endif
+}
+
+void ZstdDataFile::close()
+{
+    ChunkedFileReader::close();
+#ifdef HAVE_ZSTD
+    for (void* context : m_contexts)
+        ZSTD_freeDCtx((ZSTD_DCtx *) context);
+#endif
+    m_contexts.clear();
+    m_files.clear();
+    m_data.clear();
+    m_frames.clear();
+}
+
+bool ZstdDataFile::readSeekTable(ifstream& in, int64_t fileSize)
+{
+    uint32_t numFrames = 0, magic = 0;
+    uint8_t descriptor = 0;
+    if (fileSize < SeekTableFooterSize + 8 || !readValueAt(in, fileSize - SeekTableFooterSize, numFrames) ||
+        !readValueAt(in, fileSize - 5, descriptor) || !readValueAt(in, fileSize - 4, magic) || magic != SeekableMagicNumber)
+    {
+        return false;
+    }
+
+    const int64_t entrySize = (descriptor & 0x80) ? 12 : 8;
+    const int64_t tableSize = numFrames * entrySize + SeekTableFooterSize;
+    const int64_t tableOffset = fileSize - tableSize - 8;
+    uint32_t skippableMagic = 0, frameSize = 0;
+    if (tableOffset < 0 || !readValueAt(in, tableOffset, skippableMagic) || skippableMagic != SeekTableMagicNumber ||
+        !readValueAt(in, tableOffset + 4, frameSize) || frameSize != tableSize)
+    {
+        throw std::runtime_error("Zstd Error: bad seek table in " + m_filename);
+    }
+
+    vector<uint8_t> table((size_t) (numFrames * entrySize));
+    in.clear();
+    in.seekg(tableOffset + 8, ios::beg);
+    if (!in.read((char *)table.data(), (streamsize) table.size()))
+        throw std::runtime_error("Zstd Error: bad seek table in " + m_filename);
+
+    int64_t offset = 0;
+    for (uint32_t i = 0; i < numFrames; i++)
+    {
+        uint32_t compressedSize, size;
+        memcpy(&compressedSize, table.data() + i * entrySize, sizeof(compressedSize));
+        memcpy(&size, table.data() + i * entrySize + 4, sizeof(size));
+        if (size > 0)
+            m_frames.push_back({ offset, compressedSize, size });
+        offset += compressedSize;
+    }
+    if (offset != tableOffset)
+        throw std::runtime_error("Zstd Error: bad seek table in " + m_filename);
+    return true;
+}
+
+// Index file: magic number, version, size and time of the zstd file, number of frames, then the
+// offset, compressed size and size of each frame.
+bool ZstdDataFile::loadIndex(int64_t fileSize, int64_t fileTime)
+{
+    ifstream in(m_filename + ZstdIndexFileExtension, ios::in | ios::binary);
+    uint32_t magic = 0, version = 0;
+    int64_t size = 0, time = 0, numFrames = 0;
+    if (!in || !in.read((char *)&magic, sizeof(magic)) || magic != ZstdIndexMagicNumber ||
+        !in.read((char *)&version, sizeof(version)) || version != ZstdIndexVersionNumber ||
+        !in.read((char *)&size, sizeof(size)) || !in.read((char *)&time, sizeof(time)) ||
+        !in.read((char *)&numFrames, sizeof(numFrames)) || size != fileSize || time != fileTime || numFrames < 0)
+    {
+        return false;
+    }
+    m_frames.resize((size_t) numFrames);
+    if (!in.read((char *)m_frames.data(), (streamsize) (m_frames.size() * sizeof(Frame))))
+    {
+        m_frames.clear();
+        return false;
+    }
+    for (const Frame& frame : m_frames)
+    {
+        if (frame.offset < 0 || frame.compressedSize <= 0 || frame.offset + frame.compressedSize > fileSize)
+        {
+            m_frames.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+void ZstdDataFile::saveIndex(int64_t fileSize, int64_t fileTime) const
+{
+    // Written to a temporary file and renamed, so a reader never sees a partial index.
+    string indexFilename = m_filename + ZstdIndexFileExtension;
+    string tempFilename = indexFilename + ".tmp";
+    {
+        ofstream out(tempFilename, ios::out | ios::binary | ios::trunc);
+        if (!out)
+            return;
+        int64_t numFrames = (int64_t) m_frames.size();
+        out.write((const char *)&ZstdIndexMagicNumber, sizeof(ZstdIndexMagicNumber));
+        out.write((const char *)&ZstdIndexVersionNumber, sizeof(ZstdIndexVersionNumber));
+        out.write((const char *)&fileSize, sizeof(fileSize));
+        out.write((const char *)&fileTime, sizeof(fileTime));
+        out.write((const char *)&numFrames, sizeof(numFrames));
+        out.write((const char *)m_frames.data(), (streamsize) (m_frames.size() * sizeof(Frame)));
+    }
+    error_code ec;
+    filesystem::rename(tempFilename, indexFilename, ec);
+}
+
+// Walk the frames, reading only the frame and block headers.
+void ZstdDataFile::scanFrames(ifstream& in, int64_t fileSize)
+{
+#ifdef HAVE_ZSTD
+    const string badFile = "Zstd Error: " + m_filename + " is not a zstd file";
+    int64_t offset = 0;
+    while (offset < fileSize)
+    {
+        uint32_t magic = 0;
+        if (!readValueAt(in, offset, magic))
+            throw std::runtime_error(badFile);
+        if ((magic & ZstdSkippableMagicMask) == ZstdSkippableMagicNumber)
+        {
+            uint32_t size = 0;
+            if (!readValueAt(in, offset + 4, size))
+                throw std::runtime_error(badFile);
+            offset += 8 + (int64_t) size;
+            continue;
+        }
+        if (magic != ZstdFrameMagicNumber)
+            throw std::runtime_error(badFile);
+
+        uint8_t header[ZstdFrameHeaderMaxSize] = {};
+        const int64_t headerBytes = min<int64_t>(sizeof(header), fileSize - offset);
+        in.clear();
+        in.seekg(offset, ios::beg);
+        in.read((char *)header, (streamsize) headerBytes);
+        const uint8_t descriptor = header[4];
+        const int contentSizeFlag = descriptor >> 6;
+        const bool singleSegment = (descriptor >> 5) & 1;
+        const bool checksum = (descriptor >> 2) & 1;
+        static const int dictionaryIdBytes[4] = { 0, 1, 2, 4 };
+        static const int contentSizeBytes[4] = { 0, 2, 4, 8 };
+        int64_t position = offset + 5 + (singleSegment ? 0 : 1) + dictionaryIdBytes[descriptor & 3] +
+                           ((contentSizeFlag == 0 && singleSegment) ? 1 : contentSizeBytes[contentSizeFlag]);
+
+        // Blocks: a 3-byte header of last-block flag, type and size, then the block.
+        while (true)
+        {
+            uint8_t block[3];
+            in.clear();
+            in.seekg(position, ios::beg);
+            if (!in.read((char *)block, sizeof(block)))
+                throw std::runtime_error(badFile);
+            const uint32_t blockHeader = block[0] | (block[1] << 8) | (block[2] << 16);
+            const int type = (blockHeader >> 1) & 3;
+            if (type == 3)
+                throw std::runtime_error(badFile);
+            position += 3 + ((type == 1) ? 1 : (blockHeader >> 3));
+            if (blockHeader & 1)
+                break;
+        }
+        if (checksum)
+            position += 4;
+        if (position > fileSize)
+            throw std::runtime_error(badFile);
+
+        Frame frame = { offset, position - offset, 0 };
+        unsigned long long contentSize = ZSTD_getFrameContentSize(header, (size_t) headerBytes);
+        if (contentSize != ZSTD_CONTENTSIZE_UNKNOWN && contentSize != ZSTD_CONTENTSIZE_ERROR)
+            frame.size = (int64_t) contentSize;
+        else
+        {
+            // The frame does not record its size: decompress it to find out.
+            vector<uint8_t> data((size_t) frame.compressedSize);
+            vector<uint8_t> scratch(ZSTD_DStreamOutSize());
+            in.clear();
+            in.seekg(offset, ios::beg);
+            if (!in.read((char *)data.data(), (streamsize) data.size()))
+                throw std::runtime_error(badFile);
+            ZSTD_DStream* stream = ZSTD_createDStream();
+            ZSTD_initDStream(stream);
+            ZSTD_inBuffer input = { data.data(), data.size(), 0 };
+            size_t result = 1;
+            while (result != 0 && !ZSTD_isError(result))
+            {
+                ZSTD_outBuffer output = { scratch.data(), scratch.size(), 0 };
+                result = ZSTD_decompressStream(stream, &output, &input);
+                frame.size += (int64_t) output.pos;
+                if (input.pos == input.size && output.pos == 0 && result != 0)
+                    break;
+            }
+            ZSTD_freeDStream(stream);
+            if (result != 0)
+                throw std::runtime_error(badFile);
+        }
+        if (frame.size > 0)
+            m_frames.push_back(frame);
+        offset = position;
+    }
+#else
+    (void) in;
+    (void) fileSize;
+#endif
+}
+
+void ZstdDataFile::decode(int worker, int64_t chunk, uint8_t* out)
+{
+#ifdef HAVE_ZSTD
+    const Frame& frame = m_frames[chunk];
+    ifstream& in = m_files[worker];
+    vector<uint8_t>& data = m_data[worker];
+    data.resize((size_t) frame.compressedSize);
+    in.clear();
+    in.seekg(frame.offset, ios::beg);
+    if (!in.read((char *)data.data(), (streamsize) data.size()))
+        throw std::runtime_error("Zstd Error: cannot read " + m_filename);
+    size_t result = ZSTD_decompressDCtx((ZSTD_DCtx *) m_contexts[worker], out, (size_t) frame.size, data.data(), data.size());
+    if (ZSTD_isError(result))
+        throw std::runtime_error("Zstd Error: " + m_filename + ": " + ZSTD_getErrorName(result));
+    if ((int64_t) result != frame.size)
+        throw std::runtime_error("Zstd Error: " + m_filename + ": frame size mismatch");
+#else
+    (void) worker;
+    (void) chunk;
+    (void) out;
+#endif
+}
+
+void compressZstdSeekable(const string& source, const string& destination, int level, int numThreads,
+                          atomic<double>* progress)
+{
+#ifndef HAVE_ZSTD
+    (void) destination;
+    (void) level;
+    (void) numThreads;
+    (void) progress;
+    throw std::runtime_error("Zstd Error: cannot compress " + source + ", zstd support was not compiled in");
+#else
+    ifstream in(source, ios::in | ios::binary);
+    if (!in)
+        throw std::runtime_error("Zstd Error: cannot open " + source);
+    const int64_t sourceSize = (int64_t) filesystem::file_size(source);
+    string tempFilename = destination + ".tmp";
+    ofstream out(tempFilename, ios::out | ios::binary | ios::trunc);
+    if (!out)
+        throw std::runtime_error("Zstd Error: cannot create " + tempFilename);
+
+    // Read a batch of frames, compress them in parallel, and write them in order.
+    const int batch = ChunkedFileReader::numThreadsToUse(numThreads);
+    vector<uint8_t> input((size_t) batch * ZstdSeekableFrameSize);
+    vector<vector<uint8_t>> compressed(batch, vector<uint8_t>(ZSTD_compressBound(ZstdSeekableFrameSize)));
+    vector<size_t> compressedSizes(batch);
+    vector<uint32_t> table;
+    for (int64_t offset = 0; offset < sourceSize; )
+    {
+        const int64_t bytes = min<int64_t>((int64_t) input.size(), sourceSize - offset);
+        if (!in.read((char *)input.data(), (streamsize) bytes))
+            throw std::runtime_error("Zstd Error: cannot read " + source);
+        const int numInBatch = (int) ((bytes + ZstdSeekableFrameSize - 1) / ZstdSeekableFrameSize);
+        vector<thread> threads;
+        for (int b = 0; b < numInBatch; b++)
+        {
+            threads.emplace_back([&, b]()
+            {
+                const size_t n = (size_t) min<int64_t>(ZstdSeekableFrameSize, bytes - (int64_t) b * ZstdSeekableFrameSize);
+                compressedSizes[b] = ZSTD_compress(compressed[b].data(), compressed[b].size(),
+                                                   input.data() + (size_t) b * ZstdSeekableFrameSize, n, level);
+            });
+        }
+        for (thread& t : threads)
+            t.join();
+
+        for (int b = 0; b < numInBatch; b++)
+        {
+            if (ZSTD_isError(compressedSizes[b]))
+                throw std::runtime_error(string("Zstd Error: ") + ZSTD_getErrorName(compressedSizes[b]));
+            out.write((const char *)compressed[b].data(), (streamsize) compressedSizes[b]);
+            table.push_back((uint32_t) compressedSizes[b]);
+            table.push_back((uint32_t) min<int64_t>(ZstdSeekableFrameSize, bytes - (int64_t) b * ZstdSeekableFrameSize));
+        }
+        offset += bytes;
+        if (progress)
+            *progress = (double) offset / (double) sourceSize;
+    }
+
+    const uint32_t numFrames = (uint32_t) (table.size() / 2);
+    const uint32_t tableSize = numFrames * 8 + SeekTableFooterSize;
+    const uint8_t descriptor = 0;
+    out.write((const char *)&SeekTableMagicNumber, sizeof(SeekTableMagicNumber));
+    out.write((const char *)&tableSize, sizeof(tableSize));
+    out.write((const char *)table.data(), (streamsize) (table.size() * sizeof(uint32_t)));
+    out.write((const char *)&numFrames, sizeof(numFrames));
+    out.write((const char *)&descriptor, sizeof(descriptor));
+    out.write((const char *)&SeekableMagicNumber, sizeof(SeekableMagicNumber));
+    out.close();
+    if (!out)
+        throw std::runtime_error("Zstd Error: cannot write " + tempFilename);
+
+    error_code ec;
+    filesystem::rename(tempFilename, destination, ec);
+    if (ec)
+        throw std::runtime_error("Zstd Error: cannot rename " + tempFilename);
+#endif
+}
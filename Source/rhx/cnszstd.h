@@ -0,0 +1,79 @@
+/*
+ * cnszstd.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef RHX_CNSZSTD_H_
+#define RHX_CNSZSTD_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <atomic>
+#include <cstdint>
+#include "cnschunked.h"
+
+// Extension of a zstd-compressed data file: amplifier.dat.zst, time.dat.zst.
+const char * const ZstdFileExtension = ".zst";
+
+// Extension of the seek table saved next to a zstd file that has none of its own.
+const char * const ZstdIndexFileExtension = ".index";
+
+// Decompressed size of the frames written by compressZstdSeekable().
+const int ZstdSeekableFrameSize = 4 << 20;
+
+// True if zstd support was compiled in (HAVE_ZSTD).
+bool zstdAvailable();
+
+// Random access to a zstd-compressed file, decompressing only the frames that cover a read, several
+// frames at a time in parallel (see ChunkedFileReader).
+// The frame table comes from the seek table of the zstd seekable format if the file has one. Otherwise
+// it is built on first open by walking the frame and block headers (without decompressing, unless a
+// frame does not record its size) and saved to <file>.index, which later opens reuse while the file's
+// size and time are unchanged. Files compressed as a single frame can be read, but any read decompresses
+// the whole file; archives should be written as many frames, e.g. by compressZstdSeekable().
+class ZstdDataFile : public ChunkedFileReader
+{
+public:
+    ZstdDataFile();
+    ~ZstdDataFile();
+
+    // Will throw() on fail, or if zstd support was not compiled in. numThreads 0: one per hardware thread.
+    void open(const std::string& filename, int numThreads = 0);
+    void close();
+
+    int64_t numFrames() const { return (int64_t) m_frames.size(); }
+
+protected:
+    void decode(int worker, int64_t chunk, uint8_t* out) override;
+
+private:
+    struct Frame
+    {
+        int64_t offset;
+        int64_t compressedSize;
+        int64_t size;
+    };
+
+    std::string m_filename;
+    std::vector<Frame> m_frames;
+
+    // Per worker
+    std::vector<std::ifstream> m_files;
+    std::vector<std::vector<uint8_t>> m_data;
+    std::vector<void*> m_contexts;
+
+    bool readSeekTable(std::ifstream& in, int64_t fileSize);
+    bool loadIndex(int64_t fileSize, int64_t fileTime);
+    void saveIndex(int64_t fileSize, int64_t fileTime) const;
+    void scanFrames(std::ifstream& in, int64_t fileSize);
+};
+
+// Compress source to destination in the zstd seekable format, in frames of ZstdSeekableFrameSize
+// bytes compressed numThreads at a time (0: one per hardware thread). Will throw() on fail.
+void compressZstdSeekable(const std::string& source, const std::string& destination, int level, int numThreads,
+                          std::atomic<double>* progress);
+
+
+#endif /* RHX_CNSZSTD_H_ */
@@ -34,6 +34,7 @@
 #include <queue>
 #include <limits>
 #include "rhxregisters.h"
+#include "cnscoefficients.h"
 
 
 
@@ -356,33 +357,30 @@ void RHXRegisters::enableDsp(bool enabled)
 // removal filter (a one-pole highpass filter).
 vector<double> RHXRegisters::getDspFreqTable(double sampleRate_)
 {
-    vector<double> fCutoff(16, 0.0);
     // Note: fCutoff[0] = 0.0 here, but this index should not be used.
-    for (int n = 1; n < 16; ++n) {
-        double x = pow(2.0, (double) n);
-        fCutoff[n] = sampleRate_ * log(x / (x - 1.0)) / TwoPi;
-    }
-    return fCutoff;
+    DspCutoffTable table = dspCutoffTable(sampleRate_);
+    return vector<double>(table.fCutoff, table.fCutoff + 16);
 }
 
 // Set the DSP offset removal filter cutoff frequency as closely to the requested
 // newDspCutoffFreq (in Hz) as possible; returns the actual cutoff frequency (in Hz).
 double RHXRegisters::setDspCutoffFreq(double newDspCutoffFreq)
 {
-    vector<double> fCutoff = getDspFreqTable();
-    double logNewDspCutoffFreq = log10(newDspCutoffFreq);
+    const DspCutoffTable table = dspCutoffTable(sampleRate);
+    const double* fCutoff = table.fCutoff;
 
-    // Find the closest value to the requested cutoff frequency (on a logarithmic scale).
+    // Find the closest value to the requested cutoff frequency (on a logarithmic scale, so the
+    // smallest ratio of the larger to the smaller frequency).
     if (newDspCutoffFreq > fCutoff[1]) {
         dspCutoffFreq = 1;
     } else if (newDspCutoffFreq < fCutoff[15]) {
         dspCutoffFreq = 15;
     } else {
-        double minLogDiff = 10000000.0;
+        double minRatio = numeric_limits<double>::max();
         for (int n = 1; n < 16; n++) {
-            double logFCutoff = log10(fCutoff[n]);
-            if (fabs(logNewDspCutoffFreq - logFCutoff) < minLogDiff) {
-                minLogDiff = fabs(logNewDspCutoffFreq - logFCutoff);
+            double ratio = (fCutoff[n] > newDspCutoffFreq) ? fCutoff[n] / newDspCutoffFreq : newDspCutoffFreq / fCutoff[n];
+            if (ratio < minRatio) {
+                minRatio = ratio;
                 dspCutoffFreq = n;
             }
         }
@@ -393,6 +391,9 @@ double RHXRegisters::setDspCutoffFreq(double newDspCutoffFreq)
 // Return the current value of the DSP offset removal cutoff frequency (in Hz).
 double RHXRegisters::getDspCutoffFreq() const
 {
+    if (dspCutoffFreq >= 1 && dspCutoffFreq < 16)
+        return dspCutoffTable(sampleRate).fCutoff[dspCutoffFreq];
+
     double x = pow(2.0, (double) dspCutoffFreq);
 
     return sampleRate * log(x / (x - 1.0)) / TwoPi;
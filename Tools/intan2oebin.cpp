@@ -0,0 +1,721 @@
+/*
+ * intan2oebin.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// Convert Intan amplifier data to the Open Ephys Binary format. The recording is info.rhd/.rhs with its
+// data files, in the one file per signal type format (amplifier.dat, or a compressed copy) or the one
+// file per channel format (amp-A-000.dat, ...), or a traditional .rhd/.rhs file holding the data blocks:
+//
+//   <output>/structure.oebin
+//   <output>/sync_messages.txt
+//   <output>/continuous/Intan-100.Rhythm Data/continuous.dat     (int16 frames, as amplifier.dat)
+//   <output>/continuous/Intan-100.Rhythm Data/sample_numbers.npy (int64, Intan timestamps)
+//   <output>/continuous/Intan-100.Rhythm Data/timestamps.npy     (float64, seconds)
+//
+// Reading, conversion and writing each run on their own thread and pass blocks of frames through
+// queues, so the three overlap. continuous.dat is written in large blocks from page-aligned buffers,
+// bypassing the page cache where the system allows it.
+//
+// usage: intan2oebin [--notch] [--block-mb N] info.rhd|recording.rhd output-directory
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "abstractrhxcontroller.h"
+#include "cnsreader.h"
+#include "cnscodec.h"
+#include "cnszstd.h"
+#include "cnsbatch.h"
+#include "cnstraditional.h"
+#include "cnsfilter.h"
+using namespace std;
+
+
+const char * const ProcessorName = "Intan";
+const int ProcessorId = 100;
+const char * const StreamName = "Rhythm Data";
+
+// Writes bypassing the page cache must be multiples of this, from buffers aligned to it.
+const size_t WriteAlignment = 4096;
+
+// Blocks in flight between the three threads.
+const int NumBlocks = 4;
+
+
+struct Block
+{
+    int16_t* frames = nullptr;          // WriteAlignment aligned
+    int numSamples = 0;
+    int64_t firstSample = 0;
+    vector<int32_t> timestamps;
+    vector<int64_t> sampleNumbers;
+    vector<double> times;
+};
+
+// Blocking queue of blocks. pop() returns nullptr once the queue is closed and empty.
+class BlockQueue
+{
+public:
+    void push(Block* block)
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_blocks.push_back(block);
+        }
+        m_ready.notify_one();
+    }
+
+    Block* pop()
+    {
+        unique_lock<mutex> lock(m_mutex);
+        m_ready.wait(lock, [this]() { return !m_blocks.empty() || m_closed; });
+        if (m_blocks.empty())
+            return nullptr;
+        Block* block = m_blocks.front();
+        m_blocks.pop_front();
+        return block;
+    }
+
+    void close()
+    {
+        {
+            lock_guard<mutex> lock(m_mutex);
+            m_closed = true;
+        }
+        m_ready.notify_all();
+    }
+
+private:
+    mutex m_mutex;
+    condition_variable m_ready;
+    deque<Block*> m_blocks;
+    bool m_closed = false;
+};
+
+// Sequential file writer. On Linux the file is opened with O_DIRECT when possible; a write that is
+// not a whole number of aligned pages (the end of the file) turns it off.
+class AlignedWriter
+{
+public:
+    ~AlignedWriter() { close(); }
+
+    void open(const string& filename)
+    {
+        m_filename = filename;
+#ifdef _WIN32
+        m_file = fopen(filename.c_str(), "wb");
+        if (!m_file)
+            throw std::runtime_error("Cannot create " + filename);
+#else
+        int flags = O_WRONLY | O_CREAT | O_TRUNC;
+#ifdef O_DIRECT
+        m_fd = ::open(filename.c_str(), flags | O_DIRECT, 0644);
+        m_direct = m_fd >= 0;
+#endif
+        if (m_fd < 0)
+            m_fd = ::open(filename.c_str(), flags, 0644);
+        if (m_fd < 0)
+            throw std::runtime_error("Cannot create " + filename);
+#endif
+    }
+
+    void write(const void* data, size_t size)
+    {
+#ifdef _WIN32
+        if (fwrite(data, 1, size, m_file) != size)
+            throw std::runtime_error("Cannot write " + m_filename);
+#else
+#ifdef O_DIRECT
+        if (m_direct && (size % WriteAlignment != 0 || (uintptr_t) data % WriteAlignment != 0))
+        {
+            fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) & ~O_DIRECT);
+            m_direct = false;
+        }
+#endif
+        const char* p = (const char *) data;
+        while (size > 0)
+        {
+            ssize_t n = ::write(m_fd, p, size);
+            if (n <= 0)
+                throw std::runtime_error("Cannot write " + m_filename);
+            p += n;
+            size -= (size_t) n;
+        }
+#endif
+    }
+
+    void close()
+    {
+#ifdef _WIN32
+        if (m_file)
+            fclose(m_file);
+        m_file = nullptr;
+#else
+        if (m_fd >= 0)
+            ::close(m_fd);
+        m_fd = -1;
+#endif
+    }
+
+private:
+    string m_filename;
+#ifdef _WIN32
+    FILE* m_file = nullptr;
+#else
+    int m_fd = -1;
+    bool m_direct = false;
+#endif
+};
+
+// Amplifier frames and timestamps of a recording, whatever its format.
+class AmplifierSource
+{
+public:
+    virtual ~AmplifierSource() {}
+
+    virtual const IntanHeaderInfo& header() const = 0;
+    virtual const vector<HeaderFileChannel>& amplifierChannels() const = 0;
+    virtual int64_t numSamples() const = 0;
+    virtual int64_t firstTimestamp() const = 0;
+
+    // Read up to nSamples frames and their timestamps from firstSample on. Returns the number read.
+    virtual int read(int64_t firstSample, int nSamples, int16_t* frames, int32_t* timestamps) = 0;
+
+    int numAmplifierChannels() const { return (int) amplifierChannels().size(); }
+    double sampleRate() const { return AbstractRHXController::getSampleRate(header().sampleRate); }
+};
+
+// One file per signal type, through IntanDataReader.
+class SignalTypeSource : public AmplifierSource
+{
+public:
+    explicit SignalTypeSource(const string& headerFilename) { m_reader.open(headerFilename); }
+
+    const IntanHeaderInfo& header() const override { return m_reader.header(); }
+    const vector<HeaderFileChannel>& amplifierChannels() const override { return m_reader.amplifierChannels(); }
+    int64_t numSamples() const override { return m_reader.numSamples(); }
+    int64_t firstTimestamp() const override { return m_reader.firstTimestamp(); }
+
+    int read(int64_t firstSample, int nSamples, int16_t* frames, int32_t* timestamps) override
+    {
+        m_reader.seek(firstSample);
+        int n = m_reader.readAmplifierData(frames, nSamples);
+        if (m_reader.readTimestamps(firstSample, n, timestamps) != n)
+            throw std::runtime_error("Cannot read time.dat");
+        return n;
+    }
+
+private:
+    IntanDataReader m_reader;
+};
+
+// One file per channel: the channel files through BatchWindowReader, which reads them on several threads,
+// and time.dat (without one, timestamps count up from 0).
+class PerChannelSource : public AmplifierSource
+{
+public:
+    explicit PerChannelSource(const string& headerFilename)
+    : m_firstTimestamp(0)
+    {
+        m_reader.open(headerFilename);
+        string timeFilename = (filesystem::path(headerFilename).parent_path() / "time.dat").string();
+        m_timeFile.open(timeFilename, ios::in | ios::binary);
+        int32_t timestamp;
+        if (m_timeFile && m_timeFile.read((char *) &timestamp, sizeof(timestamp)))
+            m_firstTimestamp = timestamp;
+        else
+            m_timeFile.close();
+        m_window.start = 0;
+        m_window.length = 0;
+    }
+
+    const IntanHeaderInfo& header() const override { return m_reader.header(); }
+    const vector<HeaderFileChannel>& amplifierChannels() const override { return m_reader.amplifierChannels(); }
+    int64_t numSamples() const override { return m_reader.numSamples(); }
+    int64_t firstTimestamp() const override { return m_firstTimestamp; }
+
+    int read(int64_t firstSample, int nSamples, int16_t* frames, int32_t* timestamps) override
+    {
+        int n = (int) max<int64_t>(min<int64_t>(nSamples, numSamples() - firstSample), 0);
+        if (n == 0)
+            return 0;
+        m_window.start = firstSample;
+        m_window.length = n;
+        m_reader.read(vector<BatchWindow>(1, m_window), m_frames, m_offsets);
+        copy(m_frames.begin(), m_frames.end(), frames);
+
+        if (!m_timeFile.is_open())
+        {
+            for (int i = 0; i < n; i++)
+                timestamps[i] = (int32_t) (firstSample + i);
+            return n;
+        }
+        m_timeFile.clear();
+        m_timeFile.seekg(firstSample * (int64_t) sizeof(int32_t), ios::beg);
+        if (!m_timeFile.read((char *) timestamps, (streamsize) n * sizeof(int32_t)))
+            throw std::runtime_error("Cannot read time.dat");
+        return n;
+    }
+
+private:
+    BatchWindowReader m_reader;
+    ifstream m_timeFile;
+    int64_t m_firstTimestamp;
+    BatchWindow m_window;
+    vector<int16_t> m_frames;
+    vector<int64_t> m_offsets;
+};
+
+// A traditional file, through TraditionalIntanReader, which decodes frames and timestamps in one pass.
+class TraditionalSource : public AmplifierSource
+{
+public:
+    explicit TraditionalSource(const string& filename)
+    : m_firstTimestamp(0)
+    {
+        m_reader.open(filename);
+        m_channels = enabledAmplifierChannels(m_reader.info());
+        int32_t timestamp;
+        TraditionalSamples samples;
+        samples.timestamps = &timestamp;
+        if (m_reader.read(0, 1, samples) == 1)
+            m_firstTimestamp = timestamp;
+    }
+
+    const IntanHeaderInfo& header() const override { return m_reader.info(); }
+    const vector<HeaderFileChannel>& amplifierChannels() const override { return m_channels; }
+    int64_t numSamples() const override { return m_reader.numSamples(); }
+    int64_t firstTimestamp() const override { return m_firstTimestamp; }
+
+    int read(int64_t firstSample, int nSamples, int16_t* frames, int32_t* timestamps) override
+    {
+        TraditionalSamples samples;
+        samples.amplifier = frames;
+        samples.timestamps = timestamps;
+        return (int) m_reader.read(firstSample, nSamples, samples);
+    }
+
+private:
+    TraditionalIntanReader m_reader;
+    vector<HeaderFileChannel> m_channels;
+    int64_t m_firstTimestamp;
+};
+
+// The source for a header file or traditional file. Will throw() if there is no amplifier data to read.
+static unique_ptr<AmplifierSource> openAmplifierSource(const string& filename)
+{
+    if (isTraditionalIntanFile(filename))
+        return unique_ptr<AmplifierSource>(new TraditionalSource(filename));
+    filesystem::path directory = filesystem::path(filename).parent_path();
+    if (!filesystem::exists(directory / "amplifier.dat") &&
+        !filesystem::exists(directory / ("amplifier.dat" + string(CompressedFileExtension))) &&
+        !filesystem::exists(directory / ("amplifier.dat" + string(ZstdFileExtension))))
+        return unique_ptr<AmplifierSource>(new PerChannelSource(filename));
+    return unique_ptr<AmplifierSource>(new SignalTypeSource(filename));
+}
+
+// Buffers aligned for AlignedWriter; MSVC has no aligned_alloc().
+static void* allocateAligned(size_t size)
+{
+#ifdef _WIN32
+    return _aligned_malloc(size, WriteAlignment);
+#else
+    return aligned_alloc(WriteAlignment, (size + WriteAlignment - 1) / WriteAlignment * WriteAlignment);
+#endif
+}
+
+static void freeAligned(void* p)
+{
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    free(p);
+#endif
+}
+
+// Header of a one-dimensional .npy array of count elements of the given dtype ("<i8", "<f8").
+static string npyHeader(const string& dtype, int64_t count)
+{
+    ostringstream dict;
+    dict << "{'descr': '" << dtype << "', 'fortran_order': False, 'shape': (" << count << ",), }";
+    string header = dict.str();
+    size_t total = 10 + header.size() + 1;
+    header.append((64 - total % 64) % 64, ' ');
+    header.push_back('\n');
+
+    string out("\x93NUMPY\x01\x00", 8);
+    uint16_t length = (uint16_t) header.size();
+    out.append((const char *) &length, 2);
+    out.append(header);
+    return out;
+}
+
+static string jsonString(const string& s)
+{
+    ostringstream oss;
+    oss << '"';
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            oss << '\\' << c;
+        else if ((unsigned char) c < 0x20)
+            oss << "\\u" << hex << setw(4) << setfill('0') << (int) c << dec;
+        else
+            oss << c;
+    }
+    oss << '"';
+    return oss.str();
+}
+
+static void writeStructure(const string& filename, const string& folderName, const AmplifierSource& reader)
+{
+    ofstream out(filename);
+    out << "{\n";
+    out << "    \"GUI version\": \"0.6.4\",\n";
+    out << "    \"continuous\": [\n";
+    out << "        {\n";
+    out << "            \"folder_name\": " << jsonString(folderName + "/") << ",\n";
+    out << "            \"sample_rate\": " << setprecision(10) << reader.sampleRate() << ",\n";
+    out << "            \"source_processor_name\": " << jsonString(ProcessorName) << ",\n";
+    out << "            \"source_processor_id\": " << ProcessorId << ",\n";
+    out << "            \"stream_name\": " << jsonString(StreamName) << ",\n";
+    out << "            \"recorded_processor\": " << jsonString(ProcessorName) << ",\n";
+    out << "            \"recorded_processor_id\": " << ProcessorId << ",\n";
+    out << "            \"num_channels\": " << reader.numAmplifierChannels() << ",\n";
+    out << "            \"channels\": [\n";
+    const vector<HeaderFileChannel>& channels = reader.amplifierChannels();
+    for (size_t i = 0; i < channels.size(); i++)
+    {
+        out << "                {\n";
+        out << "                    \"channel_name\": " << jsonString(channels[i].customChannelName) << ",\n";
+        out << "                    \"description\": " << jsonString(channels[i].nativeChannelName) << ",\n";
+        out << "                    \"identifier\": \"genericdata.continuous\",\n";
+        out << "                    \"history\": " << jsonString(ProcessorName) << ",\n";
+        out << "                    \"bit_volts\": " << AmplifierMicroVoltsPerBit << ",\n";
+        out << "                    \"units\": \"uV\"\n";
+        out << "                }" << ((i + 1 < channels.size()) ? "," : "") << "\n";
+    }
+    out << "            ]\n";
+    out << "        }\n";
+    out << "    ],\n";
+    out << "    \"events\": [],\n";
+    out << "    \"spikes\": []\n";
+    out << "}\n";
+    if (!out)
+        throw std::runtime_error("Cannot write " + filename);
+}
+
+static void writeSyncMessages(const string& filename, const AmplifierSource& reader)
+{
+    ofstream out(filename);
+    out << "Software Time (milliseconds since midnight Jan 1st 1970 UTC): 0\n";
+    out << "Start Time for " << ProcessorName << " (" << ProcessorId << ") - " << StreamName << " @ "
+        << (int64_t) reader.sampleRate() << " Hz: " << reader.firstTimestamp() << "\n";
+    if (!out)
+        throw std::runtime_error("Cannot write " + filename);
+}
+
+
+class Converter
+{
+public:
+    Converter(AmplifierSource& reader, const string& outputDirectory, bool notch, int blockSamples)
+    : m_reader(reader)
+    , m_outputDirectory(outputDirectory)
+    , m_notch(notch)
+    , m_blockSamples(blockSamples)
+    , m_samplesWritten(0)
+    , m_failed(false)
+    , m_writerDone(false)
+    {
+    }
+
+    void run();
+
+    int64_t samplesWritten() const { return m_samplesWritten; }
+
+private:
+    AmplifierSource& m_reader;
+    string m_outputDirectory;
+    bool m_notch;
+    int m_blockSamples;
+    Block m_blocks[NumBlocks];
+    BlockQueue m_free, m_read, m_converted;
+    atomic<int64_t> m_samplesWritten;
+    atomic<bool> m_failed;
+    atomic<bool> m_writerDone;
+    mutex m_errorMutex;
+    string m_error;
+
+    void readLoop();
+    void convertLoop();
+    void writeLoop(const string& streamDirectory);
+    void fail(const string& what);
+};
+
+void Converter::fail(const string& what)
+{
+    {
+        lock_guard<mutex> lock(m_errorMutex);
+        if (m_error.empty())
+            m_error = what;
+    }
+    m_failed = true;
+    m_free.close();
+    m_read.close();
+    m_converted.close();
+}
+
+void Converter::readLoop()
+{
+    try
+    {
+        int64_t position = 0;
+        while (!m_failed)
+        {
+            Block* block = m_free.pop();
+            if (!block)
+                break;
+            block->firstSample = position;
+            block->timestamps.resize(m_blockSamples);
+            block->numSamples = m_reader.read(position, m_blockSamples, block->frames, block->timestamps.data());
+            if (block->numSamples == 0)
+                break;
+            block->timestamps.resize(block->numSamples);
+            position += block->numSamples;
+            m_read.push(block);
+        }
+        if (!m_failed && position < m_reader.numSamples())
+            fail("Cannot read past sample " + to_string(position) + " of " + to_string(m_reader.numSamples()));
+    }
+    catch (std::exception &e)
+    {
+        fail(e.what());
+    }
+    m_read.close();
+}
+
+// Timestamps to sample numbers and seconds, and the optional notch filter.
+void Converter::convertLoop()
+{
+    try
+    {
+        const int nc = m_reader.numAmplifierChannels();
+        const double sampleRate = m_reader.sampleRate();
+        MultichannelNotchFilter notchFilter;
+        vector<float> floatBuffer;
+        if (m_notch)
+        {
+            const IntanHeaderInfo& info = m_reader.header();
+            notchFilter.setParameters((info.notchFilterFreq == 50.0) ? Notch50Hz : Notch60Hz, info.sampleRate, nc);
+            floatBuffer.resize((size_t) m_blockSamples * nc);
+        }
+
+        while (Block* block = m_read.pop())
+        {
+            const int n = block->numSamples;
+            block->sampleNumbers.resize(n);
+            block->times.resize(n);
+            for (int i = 0; i < n; i++)
+            {
+                block->sampleNumbers[i] = block->timestamps[i];
+                block->times[i] = block->timestamps[i] / sampleRate;
+            }
+            if (m_notch)
+            {
+                amplifierToMicroVolts(block->frames, floatBuffer.data(), (int64_t) n * nc);
+                notchFilter.filter(floatBuffer.data(), n);
+                microVoltsToAmplifier(floatBuffer.data(), block->frames, (int64_t) n * nc);
+            }
+            m_converted.push(block);
+        }
+    }
+    catch (std::exception &e)
+    {
+        fail(e.what());
+    }
+    m_converted.close();
+}
+
+void Converter::writeLoop(const string& streamDirectory)
+{
+    try
+    {
+        const int64_t numSamples = m_reader.numSamples();
+        const size_t frameBytes = (size_t) m_reader.numAmplifierChannels() * sizeof(int16_t);
+
+        AlignedWriter data;
+        data.open(streamDirectory + "/continuous.dat");
+        ofstream sampleNumbers(streamDirectory + "/sample_numbers.npy", ios::out | ios::binary | ios::trunc);
+        ofstream times(streamDirectory + "/timestamps.npy", ios::out | ios::binary | ios::trunc);
+        string header = npyHeader("<i8", numSamples);
+        sampleNumbers.write(header.data(), header.size());
+        header = npyHeader("<f8", numSamples);
+        times.write(header.data(), header.size());
+
+        while (Block* block = m_converted.pop())
+        {
+            data.write(block->frames, block->numSamples * frameBytes);
+            sampleNumbers.write((const char *) block->sampleNumbers.data(), block->numSamples * sizeof(int64_t));
+            times.write((const char *) block->times.data(), block->numSamples * sizeof(double));
+            m_samplesWritten += block->numSamples;
+            m_free.push(block);
+        }
+        data.close();
+        if (!sampleNumbers || !times)
+            throw std::runtime_error("Cannot write timestamps");
+    }
+    catch (std::exception &e)
+    {
+        fail(e.what());
+    }
+    m_free.close();
+    m_writerDone = true;
+}
+
+void Converter::run()
+{
+    const int nc = m_reader.numAmplifierChannels();
+    string folderName = string(ProcessorName) + "-" + to_string(ProcessorId) + "." + StreamName;
+    string streamDirectory = (filesystem::path(m_outputDirectory) / "continuous" / folderName).string();
+    filesystem::create_directories(streamDirectory);
+    writeStructure((filesystem::path(m_outputDirectory) / "structure.oebin").string(), folderName, m_reader);
+    writeSyncMessages((filesystem::path(m_outputDirectory) / "sync_messages.txt").string(), m_reader);
+
+    size_t blockBytes = (size_t) m_blockSamples * nc * sizeof(int16_t);
+    for (Block& block : m_blocks)
+    {
+        block.frames = (int16_t *) allocateAligned(blockBytes);
+        if (!block.frames)
+            throw std::runtime_error("Cannot allocate buffers");
+        m_free.push(&block);
+    }
+
+    thread reader(&Converter::readLoop, this);
+    thread converter(&Converter::convertLoop, this);
+    thread writer(&Converter::writeLoop, this, streamDirectory);
+
+    // Progress, every half second and at the end.
+    const double totalBytes = (double) m_reader.numSamples() * nc * sizeof(int16_t);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    chrono::steady_clock::time_point report = start;
+    while (true)
+    {
+        this_thread::sleep_for(chrono::milliseconds(20));
+        chrono::steady_clock::time_point now = chrono::steady_clock::now();
+        int64_t written = m_samplesWritten;
+        bool done = m_writerDone;
+        if (!done && now - report < chrono::milliseconds(500))
+            continue;
+        report = now;
+        double seconds = chrono::duration<double>(now - start).count();
+        double bytes = (double) written * nc * sizeof(int16_t);
+        double rate = bytes / seconds;
+        cerr << "\r" << fixed << setprecision(1) << setw(5) << 100.0 * bytes / max(totalBytes, 1.0) << "%  "
+             << setw(8) << rate / 1.0e6 << " MB/s  "
+             << setw(6) << written / m_reader.sampleRate() / seconds << "x real time  "
+             << setw(6) << ((rate > 0.0) ? (totalBytes - bytes) / rate : 0.0) << " s left   " << flush;
+        if (done)
+            break;
+    }
+    writer.join();
+    converter.join();
+    reader.join();
+    cerr << endl;
+
+    for (Block& block : m_blocks)
+        freeAligned(block.frames);
+    if (m_failed)
+        throw std::runtime_error(m_error);
+}
+
+
+static void usage()
+{
+    cerr << "usage: intan2oebin [--notch] [--block-mb N] info.rhd|recording.rhd output-directory" << endl;
+    cerr << "  info.rhd (info.rhs) with amplifier.dat, a compressed copy of it, or amp-*.dat files next to it;" << endl;
+    cerr << "  or a traditional recording.rhd (recording.rhs) holding its data blocks" << endl;
+    cerr << "  --notch        apply the notch filter saved in the header" << endl;
+    cerr << "  --block-mb N   size of the blocks passed between threads (default 16)" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    bool notch = false;
+    int blockMegabytes = 16;
+    vector<string> arguments;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--notch")
+            notch = true;
+        else if (arg == "--block-mb" && i + 1 < argc)
+            blockMegabytes = max(1, atoi(argv[++i]));
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            usage();
+            return 2;
+        }
+        else
+            arguments.push_back(arg);
+    }
+    if (arguments.size() != 2)
+    {
+        usage();
+        return 2;
+    }
+
+    try
+    {
+        unique_ptr<AmplifierSource> source = openAmplifierSource(arguments[0]);
+        AmplifierSource& reader = *source;
+        if (reader.numAmplifierChannels() == 0)
+            throw std::runtime_error("No amplifier channels");
+        if (notch && !reader.header().notchFilterEnabled)
+        {
+            cerr << "intan2oebin: no notch filter in the header, --notch ignored" << endl;
+            notch = false;
+        }
+
+        // Blocks are a multiple of 2048 frames, so every block but the last is a whole number of pages.
+        int64_t frameBytes = (int64_t) reader.numAmplifierChannels() * sizeof(int16_t);
+        int blockSamples = (int) max<int64_t>(2048, ((int64_t) blockMegabytes * 1048576 / frameBytes) / 2048 * 2048);
+
+        Converter converter(reader, arguments[1], notch, blockSamples);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        converter.run();
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cerr << "intan2oebin: " << converter.samplesWritten() << " samples on " << reader.numAmplifierChannels()
+             << " channels in " << setprecision(2) << seconds << " s" << endl;
+    }
+    catch (std::exception &e)
+    {
+        cerr << "intan2oebin: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * intancompress.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// Compress the amplifier.dat of an Intan recording to amplifier.dat.icd (lossless; see
+// Source/rhx/cnscodec.h), or with --zstd compress amplifier.dat and time.dat to seekable .zst files.
+// With -d, restore the raw files. The reader opens the compressed files in place of the raw ones.
+// With --remove, each input file is removed only once the compressed file has been decoded and found
+// identical to the raw one.
+//
+// usage: intancompress [-d] [--zstd [--level N]] [--remove] [--threads N] info.rhd
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <filesystem>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
+#include "cnsreader.h"
+#include "cnscodec.h"
+#include "cnszstd.h"
+using namespace std;
+
+
+// Bytes restored at a time.
+const int64_t RestoreBlockSize = 16 << 20;
+
+static void usage()
+{
+    cerr << "usage: intancompress [-d] [--zstd [--level N]] [--remove] [--threads N] info.rhd" << endl;
+    cerr << "  -d             restore the raw files from the compressed ones" << endl;
+    cerr << "  --zstd         use seekable zstd files (.zst) rather than " << CompressedFileExtension << endl;
+    cerr << "  --level N      zstd compression level (default 3)" << endl;
+    cerr << "  --remove       remove the input files when done, once the output is checked against them" << endl;
+    cerr << "  --threads N    threads to encode or decode with (default: one per core)" << endl;
+}
+
+// Run task, reporting progress on stderr until it returns.
+static void withProgress(const function<void(atomic<double>*)>& task)
+{
+    atomic<double> progress(0.0);
+    atomic<bool> done(false);
+    thread report([&]()
+    {
+        while (!done)
+        {
+            this_thread::sleep_for(chrono::milliseconds(100));
+            cerr << "\r" << fixed << setprecision(1) << setw(5) << 100.0 * progress << "%" << flush;
+        }
+        cerr << endl;
+    });
+    try
+    {
+        task(&progress);
+    }
+    catch (std::exception &)
+    {
+        done = true;
+        report.join();
+        throw;
+    }
+    done = true;
+    report.join();
+}
+
+static void restore(ChunkedFileReader& file, const string& destination, atomic<double>* progress)
+{
+    string tempFilename = destination + ".tmp";
+    ofstream out(tempFilename, ios::out | ios::binary | ios::trunc);
+    vector<char> buffer((size_t) RestoreBlockSize);
+    for (int64_t offset = 0; offset < file.size(); )
+    {
+        int64_t n = file.read(offset, RestoreBlockSize, buffer.data());
+        out.write(buffer.data(), (streamsize) n);
+        offset += n;
+        *progress = (double) offset / (double) file.size();
+    }
+    out.close();
+    if (!out)
+        throw std::runtime_error("Cannot write " + tempFilename);
+    filesystem::rename(tempFilename, destination);
+}
+
+// Decode all of file and compare it with the raw file; will throw() if they differ.
+static void verify(ChunkedFileReader& file, const string& raw, atomic<double>* progress)
+{
+    if ((int64_t) filesystem::file_size(raw) != file.size())
+        throw std::runtime_error(raw + " and its compressed copy differ in size, nothing removed");
+    ifstream in(raw, ios::in | ios::binary);
+    vector<char> decoded((size_t) RestoreBlockSize), original((size_t) RestoreBlockSize);
+    for (int64_t offset = 0; offset < file.size(); )
+    {
+        int64_t n = file.read(offset, RestoreBlockSize, decoded.data());
+        if (n <= 0 || !in.read(original.data(), (streamsize) n))
+            throw std::runtime_error("Cannot read " + raw + ", nothing removed");
+        int64_t same = mismatch(decoded.begin(), decoded.begin() + n, original.begin()).first - decoded.begin();
+        if (same < n)
+            throw std::runtime_error(raw + " and its compressed copy differ at byte " + to_string(offset + same) + ", nothing removed");
+        offset += n;
+        *progress = (double) offset / (double) file.size();
+    }
+}
+
+// Open the compressed file of raw, as written by this tool.
+static unique_ptr<ChunkedFileReader> openCompressed(const string& compressed, bool zstd, int numThreads)
+{
+    if (zstd)
+    {
+        unique_ptr<ZstdDataFile> file(new ZstdDataFile);
+        file->open(compressed, numThreads);
+        return file;
+    }
+    unique_ptr<CompressedDataFile> file(new CompressedDataFile);
+    file->open(compressed, numThreads);
+    return file;
+}
+
+int main(int argc, char* argv[])
+{
+    bool decompress = false;
+    bool zstd = false;
+    bool remove = false;
+    int level = 3;
+    int numThreads = 0;
+    vector<string> arguments;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "-d")
+            decompress = true;
+        else if (arg == "--zstd")
+            zstd = true;
+        else if (arg == "--level" && i + 1 < argc)
+            level = atoi(argv[++i]);
+        else if (arg == "--remove")
+            remove = true;
+        else if (arg == "--threads" && i + 1 < argc)
+            numThreads = max(1, atoi(argv[++i]));
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            usage();
+            return 2;
+        }
+        else
+            arguments.push_back(arg);
+    }
+    if (arguments.size() != 1)
+    {
+        usage();
+        return 2;
+    }
+
+    // Raw files and their compressed counterparts.
+    filesystem::path directory = filesystem::path(arguments[0]).parent_path();
+    vector<string> rawFiles(1, (directory / "amplifier.dat").string());
+    if (zstd && (filesystem::exists(directory / "time.dat") || filesystem::exists(directory / "time.dat.zst")))
+        rawFiles.push_back((directory / "time.dat").string());
+    const string extension = zstd ? ZstdFileExtension : CompressedFileExtension;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    double rawSize = 0.0, compressedSize = 0.0;
+    try
+    {
+        IntanHeaderInfo info;
+        readIntanHeader(arguments[0].c_str(), info);
+        const int numChannels = (int) enabledAmplifierChannels(info).size();
+
+        for (const string& raw : rawFiles)
+        {
+            const string compressed = raw + extension;
+            if (decompress && zstd)
+            {
+                ZstdDataFile file;
+                file.open(compressed, numThreads);
+                withProgress([&](atomic<double>* progress) { restore(file, raw, progress); });
+            }
+            else if (decompress)
+            {
+                CompressedDataFile file;
+                file.open(compressed, numThreads);
+                if (file.numChannels() != numChannels)
+                    throw std::runtime_error(compressed + " does not match the header");
+                withProgress([&](atomic<double>* progress) { restore(file, raw, progress); });
+            }
+            else if (zstd)
+                withProgress([&](atomic<double>* progress) { compressZstdSeekable(raw, compressed, level, numThreads, progress); });
+            else
+                withProgress([&](atomic<double>* progress) { compressDataFile(raw, compressed, numChannels, numThreads, nullptr, progress); });
+
+            rawSize += (double) filesystem::file_size(raw);
+            compressedSize += (double) filesystem::file_size(compressed);
+            if (remove)
+            {
+                unique_ptr<ChunkedFileReader> file = openCompressed(compressed, zstd, numThreads);
+                withProgress([&](atomic<double>* progress) { verify(*file, raw, progress); });
+                file.reset();
+                filesystem::remove(decompress ? compressed : raw);
+            }
+        }
+    }
+    catch (std::exception &e)
+    {
+        cerr << "intancompress: " << e.what() << endl;
+        return 1;
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cerr << "intancompress: " << setprecision(1) << rawSize / 1.0e6 << " MB <-> " << compressedSize / 1.0e6
+         << " MB (ratio " << setprecision(2) << rawSize / max(compressedSize, 1.0) << ") in " << seconds << " s" << endl;
+    return 0;
+}
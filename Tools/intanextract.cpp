@@ -0,0 +1,90 @@
+/*
+ * intanextract.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// Cut a time range out of a "one file per signal type" Intan recording into a new recording directory.
+// Each data file's segment is a byte range, copied with copy_file_range(), so on copy-on-write file
+// systems the cut shares the data with the original instead of copying it.
+//
+// usage: intanextract --start S --duration S [--exact] [--rebase] info.rhd output-directory
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <exception>
+#include <cstdlib>
+#include <cmath>
+#include "cnsrhx.h"
+#include "cnsextract.h"
+#include "abstractrhxcontroller.h"
+using namespace std;
+
+
+static void usage()
+{
+    cerr << "usage: intanextract --start S --duration S [--exact] [--rebase] info.rhd output-directory" << endl;
+    cerr << "  --start S      start of the segment, in seconds from the start of the recording" << endl;
+    cerr << "  --duration S   length of the segment, in seconds" << endl;
+    cerr << "  --exact        cut at the exact samples rather than whole data blocks" << endl;
+    cerr << "  --rebase       make the first timestamp of the segment 0" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    ExtractOptions options;
+    double start = -1.0;
+    double duration = -1.0;
+    vector<string> arguments;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--start" && i + 1 < argc)
+            start = atof(argv[++i]);
+        else if (arg == "--duration" && i + 1 < argc)
+            duration = atof(argv[++i]);
+        else if (arg == "--exact")
+            options.alignToDataBlocks = false;
+        else if (arg == "--rebase")
+            options.rebaseTimestamps = true;
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            usage();
+            return 2;
+        }
+        else
+            arguments.push_back(arg);
+    }
+    if (arguments.size() != 2 || start < 0.0 || duration <= 0.0)
+    {
+        usage();
+        return 2;
+    }
+
+    try
+    {
+        IntanHeaderInfo info;
+        readIntanHeader(arguments[0].c_str(), info);
+        double sampleRate = AbstractRHXController::getSampleRate(info.sampleRate);
+
+        chrono::steady_clock::time_point begin = chrono::steady_clock::now();
+        ExtractResult result = extractTimeRange(arguments[0], arguments[1], (int64_t) llround(start * sampleRate),
+                                                (int64_t) llround(duration * sampleRate), options);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+        cerr << "intanextract: samples " << result.firstSample << " to " << result.firstSample + result.numSamples
+             << " (" << fixed << setprecision(3) << result.numSamples / sampleRate << " s), "
+             << result.numFiles << " files, " << setprecision(1) << result.bytesCopied / 1.0e6 << " MB in "
+             << setprecision(3) << seconds * 1000.0 << " ms" << endl;
+        for (const string& name : result.skippedFiles)
+            cerr << "intanextract: " << name << " not cut (not a signal type data file)" << endl;
+    }
+    catch (std::exception &e)
+    {
+        cerr << "intanextract: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+ * intantranscode.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+// Convert the amplifier data of an Intan recording between the "one file per signal type" format
+// (amplifier.dat) and the "one file per channel" format (amp-A-000.dat, ...). The direction follows
+// from the files next to the header: a recording with an amplifier.dat is split, otherwise the
+// per-channel files are merged. The header file and time.dat are copied to the output directory.
+// A "traditional" .rhd or .rhs file (data blocks after the header) is instead unpacked into the
+// "one file per signal type" format.
+//
+// usage: intantranscode [--memory-mb N] [--threads N] info.rhd output-directory
+//        intantranscode [--memory-mb N] recording.rhd output-directory
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <exception>
+#include <algorithm>
+#include <cstdlib>
+#include "cnstranscode.h"
+#include "cnstraditional.h"
+using namespace std;
+
+
+static void usage()
+{
+    cerr << "usage: intantranscode [--memory-mb N] [--threads N] info.rhd output-directory" << endl;
+    cerr << "       intantranscode [--memory-mb N] recording.rhd output-directory" << endl;
+    cerr << "  --memory-mb N  memory budget for the data buffers (default " << (DefaultTranscodeMemory >> 20) << ")" << endl;
+    cerr << "  --threads N    worker threads, one per slice of channels (default: one per core)" << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    TranscodeOptions options;
+    vector<string> arguments;
+    for (int i = 1; i < argc; i++)
+    {
+        string arg = argv[i];
+        if (arg == "--memory-mb" && i + 1 < argc)
+            options.memoryBudget = (int64_t) max(1, atoi(argv[++i])) << 20;
+        else if (arg == "--threads" && i + 1 < argc)
+            options.numThreads = max(1, atoi(argv[++i]));
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            usage();
+            return 2;
+        }
+        else
+            arguments.push_back(arg);
+    }
+    if (arguments.size() != 2)
+    {
+        usage();
+        return 2;
+    }
+
+    bool traditional = isTraditionalIntanFile(arguments[0]);
+    bool split = !traditional && filesystem::exists(filesystem::path(arguments[0]).parent_path() / "amplifier.dat");
+    atomic<double> progress(0.0);
+    atomic<bool> done(false);
+    thread report([&]()
+    {
+        while (!done)
+        {
+            this_thread::sleep_for(chrono::milliseconds(100));
+            cerr << "\r" << fixed << setprecision(1) << setw(5) << 100.0 * progress << "%" << flush;
+        }
+        cerr << endl;
+    });
+
+    int result = 0;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    try
+    {
+        if (traditional)
+            unpackTraditionalFile(arguments[0], arguments[1], options, nullptr, &progress);
+        else if (split)
+            splitAmplifierChannels(arguments[0], arguments[1], options, nullptr, &progress);
+        else
+            mergeAmplifierChannels(arguments[0], arguments[1], options, nullptr, &progress);
+    }
+    catch (std::exception &e)
+    {
+        cerr << endl << "intantranscode: " << e.what() << endl;
+        result = 1;
+    }
+    done = true;
+    report.join();
+    if (result == 0)
+    {
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        cerr << "intantranscode: " << (traditional ? "unpacked into one file per signal type" :
+                                       split ? "split into one file per channel" : "merged into amplifier.dat")
+             << " in " << setprecision(2) << seconds << " s" << endl;
+    }
+    return result;
+}